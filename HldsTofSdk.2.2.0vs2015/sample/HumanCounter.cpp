@@ -1,13 +1,39 @@
 #define _CRT_SECURE_NO_WARNINGS
 
+#include <WinSock2.h>	//Before Windows.h (TofMetrics.h)
 #include <Windows.h>
 #include <opencv2/opencv.hpp>
 #include <fstream>
 #include <stdio.h>
 #include <iostream>
 #include <time.h>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
 
 #include "tof.h"
+#include "TofProjection.h"
+#include "TofRayTable.h"
+#include "TofDepthGate.h"
+#include "TofZBuffer.h"
+#include "TofColorizer.h"
+#include "TofRasterizer.h"
+#include "TofPipeline.h"
+#include "TofCountEvent.h"
+#ifdef _DEBUG
+#define TOF_COUNT_ALLOCATIONS	//Count allocations of each thread (to check no allocation in a frame)
+#endif
+#include "TofFramePool.h"
+#include "TofHumanStore.h"
+#include "TofCountZone.h"
+#include "TofTripwire.h"
+#include "TofCountHistory.h"
+#include "TofCountJournal.h"
+#include "TofMetrics.h"
+#include "TofFrameTelemetry.h"
+#define TOF_TRACE	//Trace scopes of each thread (key t, or a slow frame saves Chrome trace). Comment out to remove tracing
+#include "TofTrace.h"
 
 using namespace std;
 using namespace hlds;
@@ -57,10 +83,18 @@ using namespace hlds;
 #define FRONT_VIEW_RANGE		(6000)			//Range (width) of front view [mm]
 #define SECTION_HEIGHT_MIN		(-500)			//Min height of side/front view [mm]
 #define SECTION_HEIGHT_MAX		(2000)			//Max height of side/front view [mm]
+#define SECTION_GRAY_MIN		(96)			//Gray of the farthest point of side/front view
+#define MAX_POINT_SIZE			(4)				//Max size of points on top/side/front view [pixels]
+
+//Pipeline
+#define ACQUIRE_SLOTS			(4)				//Frames between acquisition and processing
+#define RENDER_SLOTS			(3)				//Frames between processing and rendering
+#define MAX_HUMANS				(100)			//Humans reserved in application (allocated only if more humans)
+#define TELEMETRY_STAT_MSEC		(1000)			//Interval of latency statistics on the display [msec]
 
 // [解決] Human count 
 // 建立計算列表結構
-struct {
+struct CountData {
 	int Enter[4];			//Human count who enter to the area from each direction(Use COUNT_XXX macro)
 	int Exit[4];			//Human count who exit from the area to each direction(Use COUNT_XXX macro)
 	int TotalEnter;			//Total number of humans entering
@@ -92,23 +126,70 @@ TCHAR mode;
 
 // [解決] Display image
 // OpenCV 建立主影像矩陣
-cv::Mat img(480 * 2, 640 * 2, CV_8UC3);
+cv::Mat img;						//Image of the displayed frame (not allocated in headless mode)
 
 // [解決] Background image
 // OpenCV 建立背景影像畫布
-cv::Mat back(480 * 2, 640 * 2, CV_8UC3);
+cv::Mat back;						//Allocated when display is started (not allocated in headless mode)
 
 // [解決] Z-buffer(to understand before and behind)
-// 建立 z軸暫存矩陣
-float z_buffer[640 * 2][480 * 2];
+// 建立 z軸暫存矩陣 (與 img 相同的列優先排列，以畫面禎編號區分新舊，不需每次清除整個矩陣)
+ZBuffer z_buffer;					//Allocated by processing thread (not allocated in headless mode)
+
+// [解決] Depth buffers of side/front view (front point of each pixel)
+// 建立 側視/前視 的深度緩衝 (每個像素只保留最前方的點)
+Raster side_raster;					//Allocated by rendering thread (not allocated in headless mode)
+Raster front_raster;				//Allocated by rendering thread (not allocated in headless mode)
 
 // [解決] ini file
 // 設定 ini 讀取檔案位置
 LPCTSTR inifilename = L"./HumanCounter.ini";
 LPCTSTR inisection = L"Settings";
+LPCTSTR inizonesection = L"Zones";		//ZONE_NUM=n, ZONE_1 to ZONE_n="name,left_x,top_y,right_x,bottom_y"
+LPCTSTR initripwiresection = L"Tripwires";	//LINE_NUM=n, LINE_1 to LINE_n="name,x1,y1,x2,y2[,x3,y3...]"
 
 //Save file name
 string savefile;	//Image save file
+string reportfile;	//Count report file
+string tracefile;	//Trace file
+
+// [解決] Count zones (other than count area, loaded from ini file)
+// 計數區域 (計數區間以外，由 ini 檔案讀取，以網格索引只測試人員附近的區域)
+CountZones zones;
+
+// [解決] Tripwires (directed polylines, loaded from ini file)
+// 計數線 (有方向的折線，由 ini 檔案讀取，從左側跨到右側為 進入)
+Tripwires tripwires;
+
+// [解決] Count history of each minute, hour and day (written by counting, read by report without lock)
+// 每分鐘、每小時、每日 的計數記錄 (由計數寫入，報告讀取時不需上鎖)
+CountHistory history;
+
+// [解決] Journal of count events (written to files by its own thread, JOURNAL=base of file names in ini file)
+// 計數事件 記錄檔 (由專用執行緒寫入檔案，計數不會等待寫入)
+CountJournal journal;
+string journalbase = "count_journal";
+
+// [解決] Metrics of pipeline (http://127.0.0.1:METRICS_PORT/metrics, METRICS_PORT=0 in ini file: no server)
+// 管線 監控指標 (Prometheus 文字格式，記錄時不需等待)
+struct PipelineMetrics {
+	Metric* framesread;			//Frames read
+	Metric* framegaps;			//Frames skipped by sensor (gaps of frame number)
+	Metric* framesdropped;		//Frames dropped because processing was late
+	Metric* readframe;			//Latency of ReadFrame()
+	Metric* convert;			//Time of 3D conversion
+	Metric* process;			//Time of processing of a frame
+	Metric* render;				//Time of rendering of a frame
+	Metric* humans;				//Humans tracked
+	Metric* totalenter;			//Count.TotalEnter
+	Metric* totalexit;			//Count.TotalExit
+	Metric* inarea;				//Count.InArea
+	Metric* latency;			//Latency from read to the end of counting
+};
+MetricsRegistry metrics;
+MetricsServer metricsserver;
+PipelineMetrics pipelinemetrics;
+int metricsport = METRICS_PORT;
 
 // [解決] Initial settings
 // 初始化相關資料
@@ -124,46 +205,90 @@ bool bBack = false;					//Mode to display footprint on background 顯示 軌跡
 bool bCount = true;					//Mode to display human count 顯示 計算列表 開關
 bool bBoxShift = true;				//true: shift, false: change size in count area setting mode
 bool bSubDisplay = true;			//Mode to display sub display 顯示 視訊子畫面 開關
+bool bHeadless = false;				//Headless counting mode (no display, counts are output as events) 無顯示 計數模式 開關
 bool bEnableArea = false;			//Valid/Invalid Enable Area
 bool bEnableAreaShift = true;		//In Enable Area setting mode... true: Whole box shift, false: Box size change
 
-// [解決] Human information
-// 人像資訊
+// [解決] Human information (fields not used in every frame)
+// 人像資訊 (座標、進出方向、軌跡 等每一禎使用的資料 在 HumanStore 的陣列中)
 struct AppHuman {
 
-	long id;					//Human ID managed in HumanDetect function of SDK
 	int appid;					//Human ID managed in application(HumanCounter.cpp)
 	bool bEnable;				//false : Candidate(Not recognized as a human yet)
 	HumanStatus status;			//Status
 
-	float x;					//X-coordinate of center of gravity of the human
-	float y;					//Y-coordinate of center of gravity of the human
-	float prex;					//Previous X-coordinate of center of gravity of the human
-	float prey;					//Previous Y-coordinate of center of gravity of the human
 	float direction;			//Direction of body(0 degree to 359 degree) --> Positive direction of Y-axis is 0 degree, and clockwise
 	float headheight;			//Head height from floor(mm)
 	float handheight;			//Hand height from floor(mm)(Enable when bHand is true)
-
-	//Track data(Ring queue)
-	struct {
-		float x;				//X-cordinate of one point in the track
-		float y;				//Y-cordinate of one point in the track
-	} track[MAX_TRACKS];
-	int nexttrack;				//Next inserting point in ring buffer
-	int trackcnt;				//Number of points in the track
-
-	int enterdir;				//Direction entering to the count area(COUNT_XXX macro)
-	int exitdir;				//Direction exiting from the count area(COUNT_XXX macro)
 };
 
 // [解決] Array for humans in application
-// 建立 apphumans 空矩陣資料
-vector<AppHuman> apphumans;
+// 建立 apphumans 人像資料 (以 SDK 的人像 ID 查找)
+//	id, x, y, prex, prey, enterdir, exitdir : arrays of the store (apphumans.x[ahno] etc.)
+//	track : apphumans.tracks (by apphumans.Slot(ahno))
+//	other fields : AppHuman (apphumans[ahno])
+HumanStore<AppHuman> apphumans(MAX_HUMANS, MAX_TRACKS);
+
+// [解決] Work arrays for loops over all humans
+// 全部人員的迴圈 使用的陣列 (預先配置)
+vector<unsigned char> areastate;		//bit0: in count area, bit1: was in count area last time
+vector<int> areachanged;				//Humans who entered or exited count area
+vector<unsigned char> enableflags;		//1: in Enable Area (humans of SDK)
 
 // [解決] Human ID managed in application
 // 設定辨識人員計數 0
 int apphumanid = 0;
 
+// [解決] Count events of the last CountHumans()
+// 最後一次計數的 計數事件 (進入、離開、取消)
+vector<CountEvent> countevents;
+
+// [解決] Frame slot between acquisition and processing
+// 擷取 -> 處理 的畫面禎 (預先建立，不複製不配置)
+struct AcquireSlot {
+	FrameDepth	frame;				///< Depth frame
+	FrameHumans	framehumans;		///< Humans frame
+	FrameStamp	stamp;				///< Timestamps of the frame
+};
+
+// [解決] Frame slot between processing and rendering
+// 處理 -> 繪製 的畫面禎 (俯視影像與繪製所需的資料)
+struct RenderSlot {
+	cv::Mat		img;				///< Top view
+	cv::Mat		subdisplay;			///< Sub display
+	bool		bsub;				///< Sub display is made
+	Frame3d		frame3d;			///< 3D frame (only in angle and height setting mode)
+	HumanStore<AppHuman> apphumans;	///< Humans
+	CountData	count;				///< Count
+	vector<ZoneCount> zonecounts;	///< Count of each zone
+	vector<TripwireCount> tripwirecounts;	///< Count of each tripwire
+	FrameStamp	stamp;				///< Timestamps of the frame
+
+	RenderSlot() : apphumans(MAX_HUMANS, MAX_TRACKS){
+	};
+};
+
+// [解決] Pipeline (acquisition thread -> processing thread -> rendering(main) thread)
+// 擷取、處理、繪製 分別執行，繪製較慢時只略過顯示，計數不會漏掉畫面禎
+SpscRing<AcquireSlot> acquirering(ACQUIRE_SLOTS);
+SpscRing<RenderSlot> renderring(RENDER_SLOTS);
+std::atomic<bool> brun(true);			//false: all threads stop
+std::atomic<bool> bAttribute(false);	//true: SetAttribute() is requested to acquisition thread
+std::mutex settinglock;					//Lock of settings changed by keys (held by processing while a frame is processed)
+bool bPipeline = false;					//Mode to display pipeline status 顯示 管線狀態 開關
+int pointsize = 1;						//Size of points on top/side/front view [pixels] 散點大小
+FrameTelemetry telemetry;				//Timestamps, dropped frames and latency of frames 畫面禎 延遲與丟失
+TraceTrigger tracetrigger;				//Trace is saved when latency of a frame exceeds TRACE_SLOW_MSEC (ini file)
+std::atomic<bool> btracerequest(false);	//true: saving trace is requested to rendering thread by a slow frame
+bool bSave = false;						//Save the next displayed image
+
+// [解決] Stream of status text (headless: stderr, so stdout has only count events)
+// 狀態訊息 輸出串流 (無畫面模式: stderr，stdout 只輸出計數事件)
+std::ostream& StatusOut(void)
+{
+	return bHeadless ? std::cerr : std::cout;
+}
+
 // [解決] Save ini file 
 // 儲存 ini 設定檔
 bool SaveIniFile(void)
@@ -267,6 +392,12 @@ bool SaveIniFile(void)
 		return false;
 	}
 
+	swprintf_s(strBuffer, TEXT("%d"), bHeadless);
+	ret = WritePrivateProfileString(inisection, L"HEADLESS", (LPCTSTR)strBuffer, inifilename);
+	if (ret != TRUE){
+		return false;
+	}
+
 	return true;
 }
 
@@ -357,6 +488,70 @@ bool LoadIniFile(void){
 		EnableArea.bottom_y = stof(strBuffer);
 	}
 
+	ret = GetPrivateProfileString(inisection, L"HEADLESS", 0, strBuffer, 1024, inifilename);
+	if (ret != 0){
+		bHeadless = stod(strBuffer);
+	}
+
+	metricsport = GetPrivateProfileInt(inisection, L"METRICS_PORT", METRICS_PORT, inifilename);
+	tracetrigger.Set(GetPrivateProfileInt(inisection, L"TRACE_SLOW_MSEC", TRACE_SLOW_MSEC, inifilename));
+
+	ret = GetPrivateProfileString(inisection, L"JOURNAL", 0, strBuffer, 1024, inifilename);
+	if (ret != 0){
+		char text[1024];
+		wcstombs(text, strBuffer, sizeof(text));
+		text[sizeof(text) - 1] = 0;
+		journalbase = text;
+	}
+
+	// [解決] Count zones
+	// 讀取 計數區域
+	zones.Clear();
+	int numofzone = GetPrivateProfileInt(inizonesection, L"ZONE_NUM", 0, inifilename);
+	for (int zno = 1; zno <= numofzone; zno++){
+		TCHAR key[32];
+		swprintf_s(key, TEXT("ZONE_%d"), zno);
+		ret = GetPrivateProfileString(inizonesection, key, 0, strBuffer, 1024, inifilename);
+		if (ret == 0){
+			continue;
+		}
+		char text[1024];
+		wcstombs(text, strBuffer, sizeof(text));
+		text[sizeof(text) - 1] = 0;
+		string name;
+		float left, top, right, bottom;
+		if (!ParseZone(text, name, left, top, right, bottom)){
+			StatusOut() << "ZONE_" << zno << " is ignored (name,left_x,top_y,right_x,bottom_y)" << endl;
+			continue;
+		}
+		zones.Add(name, left, top, right, bottom);
+	}
+
+	// [解決] Tripwires
+	// 讀取 計數線
+	tripwires.Clear();
+	int numofline = GetPrivateProfileInt(initripwiresection, L"LINE_NUM", 0, inifilename);
+	for (int lno = 1; lno <= numofline; lno++){
+		TCHAR key[32];
+		swprintf_s(key, TEXT("LINE_%d"), lno);
+		ret = GetPrivateProfileString(initripwiresection, key, 0, strBuffer, 1024, inifilename);
+		if (ret == 0){
+			continue;
+		}
+		char text[1024];
+		wcstombs(text, strBuffer, sizeof(text));
+		text[sizeof(text) - 1] = 0;
+		string name;
+		float x[TRIPWIRE_MAX_POINTS];
+		float y[TRIPWIRE_MAX_POINTS];
+		int num = ParseTripwire(text, name, x, y);
+		if (num == 0){
+			StatusOut() << "LINE_" << lno << " is ignored (name,x1,y1,x2,y2[,x3,y3...])" << endl;
+			continue;
+		}
+		tripwires.Add(name, x, y, num);
+	}
+
 	return true;
 }
 
@@ -366,7 +561,11 @@ void InitializeHumans(void)
 	// [解決] Initialize humans in application
 	// 初始化 apphumans 結構矩陣
 	// 清除 apphumans 矩陣資料
- 	apphumans.clear();
+ 	apphumans.Clear();
+	countevents.reserve(MAX_HUMANS * 2);
+	areastate.reserve(MAX_HUMANS);
+	areachanged.reserve(MAX_HUMANS);
+	enableflags.reserve(MAX_HUMANS);
 
 	// [解決] Human ID managed in application
 	// 初始化系統辨識人數
@@ -401,90 +600,112 @@ bool InEnableArea(float x, float y)
 // 線性方程式A : 比 左上右下(大/小) 右上角/左下角
 // 線性方程式B : 比 左下右上(大/小) 左上角/右下角
 // 透過線性方程式A, B交疊與大小匹配 >>> 辨別人員進出位置
-int CountDirection(float x, float y)
+ZoneShape CountShape(void)
 {
-	//Linear equation from upper left to lower right of count area�Fy = a1 * x + b1
-	float a1 = (Count.Square.bottom_y - Count.Square.top_y) / (Count.Square.right_x - Count.Square.left_x);
-	float b1 = Count.Square.top_y - a1 * Count.Square.left_x;
-	float y1 = a1 * x + b1;
-
-	//Linear equation from lower left to upper right of count area�Fy = a2 * x + b2
-	float a2 = (Count.Square.bottom_y - Count.Square.top_y) / (Count.Square.left_x - Count.Square.right_x);
-	float b2 = Count.Square.top_y - a2 * Count.Square.right_x;
-	float y2 = a2 * x + b2;
-
-	int dir = COUNT_UP;
-
-	if ((y <= y1) && (y <= y2)){
-		dir = COUNT_UP;
-	}
-	else if ((y >= y1) && (y >= y2)){
-		dir = COUNT_DOWN;
-	}
-	else if ((y >= y1) && (y <= y2)){
-		dir = COUNT_LEFT;
-	}
-	else if ((y <= y1) && (y >= y2)){
-		dir = COUNT_RIGHT;
-	}
-
-	return dir;
+	ZoneShape shape;
+	shape.Compile(Count.Square.left_x, Count.Square.top_y, Count.Square.right_x, Count.Square.bottom_y);
+	return shape;
 }
 
-void CountHumans(void)
+//Register a count event
+void AddCountEvent(const FrameData* pframe, int ahno, CountEventType type, int dir, int zone = 0)
 {
-	Count.InArea = 0;
-
-	for (unsigned int ahno = 0; ahno < apphumans.size(); ahno++){
-
-		if (InCountArea(apphumans[ahno].x, apphumans[ahno].y)){
-			//In count area
-
-			// [解決] countup
-			// 增加辨識區間內計算的人數
-			Count.InArea++;
-
-			if (!InCountArea(apphumans[ahno].prex, apphumans[ahno].prey)){
-				//It was outside last time(Outside to inside)
+	CountEvent event;
+	event.timestamp = pframe->timestamp;
+	event.framenumber = pframe->framenumber;
+	event.appid = apphumans[ahno].appid;
+	event.id = apphumans.id[ahno];
+	event.zone = zone;
+	event.type = type;
+	event.direction = dir;
+	event.x = apphumans.x[ahno];
+	event.y = apphumans.y[ahno];
+	countevents.push_back(event);
+	journal.Append(event);
+}
 
-				if (apphumans[ahno].enterdir != COUNT_NO){
-					//Cancel previous entering count if already counted
-					Count.Enter[apphumans[ahno].enterdir]--;
-				}
+void CountHumans(const FrameData* pframe)
+{
+	TOF_TRACE_SCOPE("CountHumans");
+
+	countevents.clear();
+
+	// [解決] State of all humans to the count area (8 or 4 humans at once by AreaStates(), arrays of coordinates only)
+	// 全部人員 與 計數區間 的狀態 (AreaStates() 一次 8 或 4 人，只讀取座標陣列，並列出進出的人員)
+	int num = apphumans.Size();
+	areastate.resize(num);
+	areachanged.resize(num);
+	const float* x = apphumans.x.data();
+	const float* y = apphumans.y.data();
+	const float* prex = apphumans.prex.data();
+	const float* prey = apphumans.prey.data();
+	unsigned char* state = areastate.data();
+	ZoneShape shape = CountShape();		//Lines of direction are made once for a frame
+	int numchanged;
+	int inarea = AreaStates(shape, x, y, prex, prey, num, state, areachanged.data(), numchanged);
+
+	// [解決] countup
+	// 增加辨識區間內計算的人數
+	Count.InArea = inarea;
+
+	//Humans crossing the border of count area (none in most frames)
+	for (int c = 0; c < numchanged; c++){
+		int ahno = areachanged[c];
+
+		if (state[ahno] == 1){
+			//It was outside last time(Outside to inside)
+
+			if (apphumans.enterdir[ahno] != COUNT_NO){
+				//Cancel previous entering count if already counted
+				Count.Enter[apphumans.enterdir[ahno]]--;
+				AddCountEvent(pframe, ahno, CountEventType::CancelEnter, apphumans.enterdir[ahno]);
+			}
 
-				//Entering direction
-				int dir = CountDirection(apphumans[ahno].prex, apphumans[ahno].prey);
+			//Entering direction
+			int dir = shape.Direction(prex[ahno], prey[ahno]);
 
-				//countup
-				Count.Enter[dir]++;
+			//countup
+			Count.Enter[dir]++;
+			AddCountEvent(pframe, ahno, CountEventType::Enter, dir);
 
-				//Register countup
-				apphumans[ahno].enterdir = dir;
+			//Register countup
+			apphumans.enterdir[ahno] = dir;
+		}
+		else if (state[ahno] == 2){
+			//It was inside last time(Inside to outside)
 
+			if (apphumans.exitdir[ahno] != COUNT_NO){
+				//Cancel previous exiting count if already counted
+				Count.Exit[apphumans.exitdir[ahno]]--;
+				AddCountEvent(pframe, ahno, CountEventType::CancelExit, apphumans.exitdir[ahno]);
 			}
-		}
-		else {
-			//In outside of count area
 
-			if (InCountArea(apphumans[ahno].prex, apphumans[ahno].prey)){
-				//It was inside last time(Inside to outside)
+			//Exiting direction
+			int dir = shape.Direction(x[ahno], y[ahno]);
 
-				if (apphumans[ahno].exitdir != COUNT_NO){
-					//Cancel previous exiting count if already counted
-					Count.Exit[apphumans[ahno].exitdir]--;
-				}
+			//countup
+			Count.Exit[dir]++;
+			AddCountEvent(pframe, ahno, CountEventType::Exit, dir);
 
-				//Exiting direction
-				int dir = CountDirection(apphumans[ahno].x, apphumans[ahno].y);
-
-				//countup
-				Count.Exit[dir]++;
+			//Register countup
+			apphumans.exitdir[ahno] = dir;
+		}
+	}
 
-				//Register countup
-				apphumans[ahno].exitdir = dir;
+	// [解決] Count zones (zone number of event is 1 to number of zones)
+	// 計數區域 (事件的區域編號 1 ~ 區域數)
+	zones.Count(apphumans);
+	for (unsigned int cno = 0; cno < zones.crossings.size(); cno++){
+		const ZoneCrossing& crossing = zones.crossings[cno];
+		AddCountEvent(pframe, crossing.index, crossing.type, crossing.direction, crossing.zone + 1);
+	}
 
-			}
-		}
+	// [解決] Tripwires (tripwire number of event is 1 to number of tripwires)
+	// 計數線 (事件的計數線編號 1 ~ 計數線數)
+	tripwires.Count(apphumans);
+	for (unsigned int cno = 0; cno < tripwires.crossings.size(); cno++){
+		const TripwireCrossing& crossing = tripwires.crossings[cno];
+		AddCountEvent(pframe, crossing.index, crossing.bIn ? CountEventType::CrossIn : CountEventType::CrossOut, COUNT_NO, crossing.line + 1);
 	}
 
 	//Total number of human
@@ -494,6 +715,14 @@ void CountHumans(void)
 		Count.TotalEnter += Count.Enter[dir];
 		Count.TotalExit += Count.Exit[dir];
 	}
+
+	// [解決] Count history (count area only)
+	// 計數記錄 (只記錄計數區間)
+	history.Add(pframe->timestamp, countevents.empty() ? NULL : &countevents[0], (int)countevents.size(), Count.InArea);
+
+	pipelinemetrics.totalenter->Set(Count.TotalEnter);
+	pipelinemetrics.totalexit->Set(Count.TotalExit);
+	pipelinemetrics.inarea->Set(Count.InArea);
 }
 
 void InitializeCount(void)
@@ -501,80 +730,104 @@ void InitializeCount(void)
 	memset(Count.Enter, 0, sizeof(Count.Enter));
 	memset(Count.Exit, 0, sizeof(Count.Exit));
 	Count.InArea = 0;
+	zones.ResetCounts();
+	tripwires.ResetCounts();
+}
+
+// [解決] Output count of each zone and each tripwire
+// 輸出 各計數區域 與 各計數線 的計數
+void PrintZoneCounts(void)
+{
+	for (int zone = 0; zone < zones.Size(); zone++){
+		const ZoneCount& count = zones.counts[zone];
+		StatusOut() << "Zone " << zone + 1 << " " << zones.Name(zone) << ": Enter " << count.TotalEnter
+			<< ", Exit " << count.TotalExit << endl;
+	}
+	for (int line = 0; line < tripwires.Size(); line++){
+		const TripwireCount& count = tripwires.counts[line];
+		StatusOut() << "Line " << line + 1 << " " << tripwires.Name(line) << ": In " << count.In
+			<< ", Out " << count.Out << endl;
+	}
+}
+
+//11 colors if different colors are assigned for each human
+const cv::Scalar humancolor[11] = { cv::Scalar(0, 0, 255),
+	cv::Scalar(0, 255, 0),
+	cv::Scalar(0, 255, 255),
+	cv::Scalar(255, 0, 0),
+	cv::Scalar(255, 0, 255),
+	cv::Scalar(255, 255, 0),
+	cv::Scalar(0, 127, 255),
+	cv::Scalar(0, 255, 127),
+	cv::Scalar(255, 0, 127),
+	cv::Scalar(255, 127, 0),
+	cv::Scalar(127, 0, 255),
+};
+
+//Draw footprint of humans on background(Every processed frame, so that no line is missing when display is skipped)
+void DrawFootprints(void)
+{
+#ifndef NO_FOOTPRINT
+	for (int ahno = 0; ahno < apphumans.Size(); ahno++){
+		cv::Scalar backcolor = cv::Scalar(255, 255, 255);		//Footprint on background : White
+#ifdef HUMAN_COLOR
+		backcolor = humancolor[apphumans.id[ahno] % 11];		//Different color for each ID
+#endif //HUMAN_COLOR
+
+		//Draw footprint on background
+		cv::line(back, cv::Point((int)(apphumans.prex[ahno] * zoom + dx), (int)(apphumans.prey[ahno] * zoom + dy)),
+			cv::Point((int)(apphumans.x[ahno] * zoom + dx), (int)(apphumans.y[ahno] * zoom + dy)), backcolor, 1, CV_AA, 0);
+	}
+#endif	//NO_FOOTPRINT
 }
 
 //Draw humans
-void DrawHumans(void)
+void DrawHumans(const HumanStore<AppHuman>& humans)
 {
-	//11 colors if different colors are assigned for each human
-	cv::Scalar color[11] = { cv::Scalar(0, 0, 255),
-		cv::Scalar(0, 255, 0),
-		cv::Scalar(0, 255, 255),
-		cv::Scalar(255, 0, 0),
-		cv::Scalar(255, 0, 255),
-		cv::Scalar(255, 255, 0),
-		cv::Scalar(0, 127, 255),
-		cv::Scalar(0, 255, 127),
-		cv::Scalar(255, 0, 127),
-		cv::Scalar(255, 127, 0),
-		cv::Scalar(127, 0, 255),
-	};
+	TOF_TRACE_SCOPE("DrawHumans");
 
 	//Draw each human
-	for (unsigned int ahno = 0; ahno < apphumans.size(); ahno++){
+	for (int ahno = 0; ahno < humans.Size(); ahno++){
 
 		//Colors
-		cv::Scalar backcolor = cv::Scalar(255, 255, 255);		//Footprint on background : White
 		cv::Scalar footcolor = cv::Scalar(255, 255, 0);			//Tracking line : Light blue
 		cv::Scalar color_el = cv::Scalar(0, 255, 0);			//L of human cursor : Yellow-green
 		cv::Scalar color_plus = cv::Scalar(0, 255, 255);		//Circle of human cursor : Yellow
 
 #ifdef HUMAN_COLOR
 		//Change color depending on ID
-		cv::Scalar idcolor = color[apphumans[ahno].id % 11];	//Different color for each ID
-		backcolor = idcolor;
+		cv::Scalar idcolor = humancolor[humans.id[ahno] % 11];	//Different color for each ID
 		footcolor = idcolor;
 		color_el = idcolor;
 #endif //HUMAN_COLOR
 
 #ifndef NO_FOOTPRINT
 
-		//Draw footprint on background
-		cv::line(back, cv::Point((int)(apphumans[ahno].prex * zoom + dx), (int)(apphumans[ahno].prey * zoom + dy)),
-			cv::Point((int)(apphumans[ahno].x * zoom + dx), (int)(apphumans[ahno].y * zoom + dy)), backcolor, 1, CV_AA, 0);
-
-		//Draw tracking line
-		int tno = 0;
-		if (apphumans[ahno].trackcnt == MAX_TRACKS){
-			tno = apphumans[ahno].nexttrack;
-		}
+		//Draw tracking line (from the oldest point)
+		unsigned int slot = humans.Slot(ahno);
 		int prex;
 		int prey;
-		for (int tcnt = 0; tcnt < apphumans[ahno].trackcnt; tcnt++){
-			int x = (int)(apphumans[ahno].track[tno].x * zoom + dx);
-			int y = (int)(apphumans[ahno].track[tno].y * zoom + dy);
+		for (int tcnt = 0; tcnt < humans.tracks.Count(slot); tcnt++){
+			const TrackPoint& point = humans.tracks.Point(slot, tcnt);
+			int x = (int)(point.x * zoom + dx);
+			int y = (int)(point.y * zoom + dy);
 			if (tcnt > 0){
 				cv::line(img, cv::Point(prex, prey), cv::Point(x, y), footcolor, 2, CV_AA, 0);
 			}
 			prex = x;
 			prey = y;
-
-			tno++;
-			if (tno == MAX_TRACKS){
-				tno = 0;
-			}
 		}
 #endif	//NO_FOOTPRINT
 
 #ifndef NO_HUMAN_CURSOR
 
 		//Draw human cursor
-		int hx = (int)(apphumans[ahno].x * zoom + dx);
-		int hy = (int)(apphumans[ahno].y * zoom + dy);
+		int hx = (int)(humans.x[ahno] * zoom + dx);
+		int hy = (int)(humans.y[ahno] * zoom + dy);
 		cv::Point point1;
 		cv::Point point2;
 
-		if ((apphumans[ahno].status == HumanStatus::Crouch) || (apphumans[ahno].status == HumanStatus::CrouchHand)){
+		if ((humans[ahno].status == HumanStatus::Crouch) || (humans[ahno].status == HumanStatus::CrouchHand)){
 			//Crouching
 			color_plus = cv::Scalar(0, 128, 255);	//Orange
 		}
@@ -623,22 +876,22 @@ void DrawHumans(void)
 		point2.y = point1.y - (int)(HUMAN_CURSOR_SIZE * zoom / 3);
 		cv::line(img, point1, point2, color_el, 2, CV_AA, 0);
 
-		point1.x = hx - (int)(2 * HUMAN_CURSOR_SIZE * zoom / 6 * sin(deg2rad(apphumans[ahno].direction)));
-		point1.y = hy + (int)(2 * HUMAN_CURSOR_SIZE * zoom / 6 * cos(deg2rad(apphumans[ahno].direction)));
-		point2.x = hx - (int)(HUMAN_CURSOR_SIZE * zoom / 6 * sin(deg2rad(apphumans[ahno].direction)));
-		point2.y = hy + (int)(HUMAN_CURSOR_SIZE * zoom / 6 * cos(deg2rad(apphumans[ahno].direction)));
+		point1.x = hx - (int)(2 * HUMAN_CURSOR_SIZE * zoom / 6 * sin(deg2rad(humans[ahno].direction)));
+		point1.y = hy + (int)(2 * HUMAN_CURSOR_SIZE * zoom / 6 * cos(deg2rad(humans[ahno].direction)));
+		point2.x = hx - (int)(HUMAN_CURSOR_SIZE * zoom / 6 * sin(deg2rad(humans[ahno].direction)));
+		point2.y = hy + (int)(HUMAN_CURSOR_SIZE * zoom / 6 * cos(deg2rad(humans[ahno].direction)));
 		cv::line(img, point1, point2, color_plus, 2, CV_AA, 0);
 
 		//Display hand
-		if ((apphumans[ahno].status == HumanStatus::StandHand) || (apphumans[ahno].status == HumanStatus::CrouchHand)){
-			point1.x = hx - (int)(3 * HUMAN_CURSOR_SIZE * zoom / 6 * sin(deg2rad(apphumans[ahno].direction)));
-			point1.y = hy + (int)(3 * HUMAN_CURSOR_SIZE * zoom / 6 * cos(deg2rad(apphumans[ahno].direction)));
-			point2.x = hx - (int)(HUMAN_CURSOR_SIZE * zoom / 6 * sin(deg2rad(apphumans[ahno].direction)));
-			point2.y = hy + (int)(HUMAN_CURSOR_SIZE * zoom / 6 * cos(deg2rad(apphumans[ahno].direction)));
+		if ((humans[ahno].status == HumanStatus::StandHand) || (humans[ahno].status == HumanStatus::CrouchHand)){
+			point1.x = hx - (int)(3 * HUMAN_CURSOR_SIZE * zoom / 6 * sin(deg2rad(humans[ahno].direction)));
+			point1.y = hy + (int)(3 * HUMAN_CURSOR_SIZE * zoom / 6 * cos(deg2rad(humans[ahno].direction)));
+			point2.x = hx - (int)(HUMAN_CURSOR_SIZE * zoom / 6 * sin(deg2rad(humans[ahno].direction)));
+			point2.y = hy + (int)(HUMAN_CURSOR_SIZE * zoom / 6 * cos(deg2rad(humans[ahno].direction)));
 			cv::line(img, point1, point2, color_plus, 4, CV_AA, 0);
 
 			//Indicator box
-			if (apphumans[ahno].direction < 180){
+			if (humans[ahno].direction < 180){
 				point1.x = hx - HUMAN_CURSOR_SIZE * zoom / 2 - HUMAN_CURSOR_SIZE * zoom / 6 - 10;
 			}
 			else {
@@ -650,7 +903,7 @@ void DrawHumans(void)
 			cv::rectangle(img, point1, point2, color_plus, 2, CV_AA, 0);
 
 			//Indicator
-			int handh = (int)apphumans[ahno].handheight;
+			int handh = (int)humans[ahno].handheight;
 			if (handh < HAND_INDICATOR_MIN){
 				handh = HAND_INDICATOR_MIN;
 			}
@@ -671,12 +924,14 @@ void DrawHumans(void)
 
 // [解決] Display count area
 // 顯示計算人數數量文字區域
-void DrawCount(void)
+void DrawCount(const CountData& count)
 {
-	float x = Count.Square.left_x * zoom + dx;
-	float y = Count.Square.top_y * zoom + dy;
-	float lx = Count.Square.right_x * zoom + dx - x;
-	float ly = Count.Square.bottom_y * zoom + dy - y;
+	TOF_TRACE_SCOPE("DrawCount");
+
+	float x = count.Square.left_x * zoom + dx;
+	float y = count.Square.top_y * zoom + dy;
+	float lx = count.Square.right_x * zoom + dx - x;
+	float ly = count.Square.bottom_y * zoom + dy - y;
 	cv::rectangle(img, cv::Rect((int)x, (int)y, (int)lx, (int)ly), cv::Scalar(255, 255, 255), 2, CV_AA);
 
 	string text;
@@ -688,7 +943,7 @@ void DrawCount(void)
 	text = "IN AREA";
 	cv::putText(img, text, cv::Point(tx1, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 
-	text = ": " + std::to_string(Count.InArea);
+	text = ": " + std::to_string(count.InArea);
 	cv::putText(img, text, cv::Point(tx2, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 	ty += tdy;
 	ty += tdy;
@@ -700,35 +955,35 @@ void DrawCount(void)
 	text = "UP";
 	cv::putText(img, text, cv::Point(tx1, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 
-	text = ": " + std::to_string(Count.Enter[COUNT_UP]);
+	text = ": " + std::to_string(count.Enter[COUNT_UP]);
 	cv::putText(img, text, cv::Point(tx2, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 	ty += tdy;
 
 	text = "DOWN";
 	cv::putText(img, text, cv::Point(tx1, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 
-	text = ": " + std::to_string(Count.Enter[COUNT_DOWN]);
+	text = ": " + std::to_string(count.Enter[COUNT_DOWN]);
 	cv::putText(img, text, cv::Point(tx2, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 	ty += tdy;
 
 	text = "LEFT";
 	cv::putText(img, text, cv::Point(tx1, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 
-	text = ": " + std::to_string(Count.Enter[COUNT_LEFT]);
+	text = ": " + std::to_string(count.Enter[COUNT_LEFT]);
 	cv::putText(img, text, cv::Point(tx2, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 	ty += tdy;
 
 	text = "RIGHT";
 	cv::putText(img, text, cv::Point(tx1, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 
-	text = ": " + std::to_string(Count.Enter[COUNT_RIGHT]);
+	text = ": " + std::to_string(count.Enter[COUNT_RIGHT]);
 	cv::putText(img, text, cv::Point(tx2, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 	ty += tdy;
 
 	text = "TOTAL";
 	cv::putText(img, text, cv::Point(tx1, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 
-	text = ": " + std::to_string(Count.TotalEnter);
+	text = ": " + std::to_string(count.TotalEnter);
 	cv::putText(img, text, cv::Point(tx2, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 	ty += tdy;
 	ty += tdy;
@@ -740,40 +995,85 @@ void DrawCount(void)
 	text = "UP";
 	cv::putText(img, text, cv::Point(tx1, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 
-	text = ": " + std::to_string(Count.Exit[COUNT_UP]);
+	text = ": " + std::to_string(count.Exit[COUNT_UP]);
 	cv::putText(img, text, cv::Point(tx2, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 	ty += tdy;
 
 	text = "DOWN";
 	cv::putText(img, text, cv::Point(tx1, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 
-	text = ": " + std::to_string(Count.Exit[COUNT_DOWN]);
+	text = ": " + std::to_string(count.Exit[COUNT_DOWN]);
 	cv::putText(img, text, cv::Point(tx2, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 	ty += tdy;
 
 	text = "LEFT";
 	cv::putText(img, text, cv::Point(tx1, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 
-	text = ": " + std::to_string(Count.Exit[COUNT_LEFT]);
+	text = ": " + std::to_string(count.Exit[COUNT_LEFT]);
 	cv::putText(img, text, cv::Point(tx2, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 	ty += tdy;
 
 	text = "RIGHT";
 	cv::putText(img, text, cv::Point(tx1, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 
-	text = ": " + std::to_string(Count.Exit[COUNT_RIGHT]);
+	text = ": " + std::to_string(count.Exit[COUNT_RIGHT]);
 	cv::putText(img, text, cv::Point(tx2, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 	ty += tdy;
 
 	text = "TOTAL";
 	cv::putText(img, text, cv::Point(tx1, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 
-	text = ": " + std::to_string(Count.TotalExit);
+	text = ": " + std::to_string(count.TotalExit);
 	cv::putText(img, text, cv::Point(tx2, ty), cv::FONT_HERSHEY_TRIPLEX, 1.2, cv::Scalar(255, 255, 255), 2, CV_AA);
 	ty += tdy;
 	ty += tdy;
 }
 
+// [解決] Display count zones
+// 顯示 計數區域 的外框 與 計數 (進入 / 離開 / 區域內)
+void DrawZones(const vector<ZoneCount>& counts)
+{
+	for (int zone = 0; zone < zones.Size() && zone < (int)counts.size(); zone++){
+		const ZoneShape& shape = zones.Shape(zone);
+		float x = shape.left_x * zoom + dx;
+		float y = shape.top_y * zoom + dy;
+		float lx = shape.right_x * zoom + dx - x;
+		float ly = shape.bottom_y * zoom + dy - y;
+		cv::rectangle(img, cv::Rect((int)x, (int)y, (int)lx, (int)ly), cv::Scalar(255, 128, 0), 1, CV_AA);
+
+		string text = zones.Name(zone) + " " + std::to_string(counts[zone].TotalEnter) + "/"
+			+ std::to_string(counts[zone].TotalExit) + "/" + std::to_string(counts[zone].InArea);
+		cv::putText(img, text, cv::Point((int)x + 2, (int)y + 12), cv::FONT_HERSHEY_SIMPLEX, 0.4, cv::Scalar(255, 128, 0), 1, CV_AA);
+	}
+}
+
+// [解決] Display tripwires
+// 顯示 計數線 與 計數 (進入 / 離開)，起點畫圓表示方向
+void DrawTripwires(const vector<TripwireCount>& counts)
+{
+	cv::Scalar color = cv::Scalar(255, 0, 255);
+	for (int line = 0; line < tripwires.Size() && line < (int)counts.size(); line++){
+		cv::Point point1;
+		for (int n = 0; n < tripwires.Points(line); n++){
+			float x, y;
+			tripwires.Point(line, n, x, y);
+			cv::Point point2((int)(x * zoom + dx), (int)(y * zoom + dy));
+			if (n > 0){
+				cv::line(img, point1, point2, color, 2, CV_AA, 0);
+			}
+			else {
+				cv::circle(img, point2, 4, color, CV_FILLED);
+			}
+			point1 = point2;
+		}
+
+		float x, y;
+		tripwires.Point(line, 0, x, y);
+		string text = tripwires.Name(line) + " " + std::to_string(counts[line].In) + "/" + std::to_string(counts[line].Out);
+		cv::putText(img, text, cv::Point((int)(x * zoom + dx) + 6, (int)(y * zoom + dy) - 6), cv::FONT_HERSHEY_SIMPLEX, 0.4, color, 1, CV_AA);
+	}
+}
+
 // [解決] 建構辨識區間的外框
 void DrawEnableArea(void)
 {
@@ -790,8 +1090,28 @@ void DrawEnableArea(void)
 	cv::rectangle(img, cv::Rect((int)x, (int)y, (int)lx, (int)ly), color, 2, CV_AA);
 }
 
+// [解決] Draw points of a depth buffer of side/front view
+// 繪製 側視/前視 深度緩衝中的散點 (最近為白色，最遠為 SECTION_GRAY_MIN)
+void DrawRaster(const Raster& raster, int left, int top)
+{
+	for (int y = 0; y < raster.height; y++){
+		cv::Vec3b* d = img.ptr<cv::Vec3b>(y + top) + left;
+		for (int x = 0; x < raster.width; x++){
+			unsigned int key = raster(x, y);
+			if (key != RASTER_EMPTY){
+				unsigned char gray = (unsigned char)(255 - (((key >> 16) * (255 - SECTION_GRAY_MIN)) >> 16));
+				d[x].val[0] = gray;
+				d[x].val[1] = gray;
+				d[x].val[2] = gray;
+			}
+		}
+	}
+}
+
 void DrawSection(Frame3d* pframe3d)
 {
+	TOF_TRACE_SCOPE("DrawSection");
+
 	cv::rectangle(img, cv::Point(SIDE_VIEW_X, SIDE_VIEW_Y),
 		cv::Point(SIDE_VIEW_X + SIDE_VIEW_WIDTH, SIDE_VIEW_Y + SIDE_VIEW_HEIGHT), cv::Scalar(0, 0, 0), -1);
 
@@ -803,6 +1123,22 @@ void DrawSection(Frame3d* pframe3d)
 	v.val[1] = 255;
 	v.val[2] = 255;
 
+	// [解決] Points of a pixel are drawn directly (white). Larger points are registered to depth buffers,
+	//        then drawn (nearer is brighter), so each pixel shows the front point
+	// 1 像素的散點直接繪製 (白色)；較大的散點先寫入深度緩衝 (側視: X 越小越前方，前視: 越靠近感測器越前方)，再繪製 (越近越亮)
+	bool braster = (pointsize > 1);
+	if (braster){
+		if (side_raster.width == 0){
+			side_raster.Resize(SIDE_VIEW_WIDTH, SIDE_VIEW_HEIGHT);
+			front_raster.Resize(FRONT_VIEW_WIDTH, FRONT_VIEW_HEIGHT);
+		}
+		side_raster.Clear();
+		front_raster.Clear();
+	}
+	RasterSplat splat(pointsize, false);
+	const float sidescale = RASTER_MAX_DEPTH / (float)FRONT_VIEW_RANGE;
+	const float frontscale = RASTER_MAX_DEPTH / (float)SIDE_VIEW_RANGE;
+
 	for (int y = 0; y < pframe3d->height; y++){
 		for (int x = 0; x < pframe3d->width; x++){
 
@@ -822,19 +1158,33 @@ void DrawSection(Frame3d* pframe3d)
 				int sdy = ((SECTION_HEIGHT_MAX - SECTION_HEIGHT_MIN) - (h - SECTION_HEIGHT_MIN)) * SIDE_VIEW_HEIGHT / (SECTION_HEIGHT_MAX - SECTION_HEIGHT_MIN);
 				if ((sdx >= 0) && (sdx < SIDE_VIEW_WIDTH) &&
 					(sdy >= 0) && (sdy < SIDE_VIEW_HEIGHT)){
-					img.at<cv::Vec3b>(sdy + SIDE_VIEW_Y, sdx + SIDE_VIEW_X) = v;
+					if (braster){
+						side_raster.Splat(sdx, sdy, RasterKey(RasterDepth((float)(FRONT_VIEW_RANGE / 2 + px), 0, sidescale), 0), splat);
+					}
+					else {
+						img.at<cv::Vec3b>(sdy + SIDE_VIEW_Y, sdx + SIDE_VIEW_X) = v;
+					}
 				}
 
 				//Front view
 				int fdx = (FRONT_VIEW_RANGE / 2 + px) * FRONT_VIEW_WIDTH / FRONT_VIEW_RANGE;
 				int fdy = ((SECTION_HEIGHT_MAX - SECTION_HEIGHT_MIN) - (h - SECTION_HEIGHT_MIN)) * FRONT_VIEW_HEIGHT / (SECTION_HEIGHT_MAX - SECTION_HEIGHT_MIN);
-				if ((fdx >= 0) && (fdx < SIDE_VIEW_WIDTH) &&
-					(fdy >= 0) && (fdy < SIDE_VIEW_HEIGHT)){
-					img.at<cv::Vec3b>(fdy + FRONT_VIEW_Y, fdx + FRONT_VIEW_X) = v;
+				if ((fdx >= 0) && (fdx < FRONT_VIEW_WIDTH) &&
+					(fdy >= 0) && (fdy < FRONT_VIEW_HEIGHT)){
+					if (braster){
+						front_raster.Splat(fdx, fdy, RasterKey(RasterDepth((float)py, 0, frontscale), 0), splat);
+					}
+					else {
+						img.at<cv::Vec3b>(fdy + FRONT_VIEW_Y, fdx + FRONT_VIEW_X) = v;
+					}
 				}
 			}
 		}
 	}
+	if (braster){
+		DrawRaster(side_raster, SIDE_VIEW_X, SIDE_VIEW_Y);
+		DrawRaster(front_raster, FRONT_VIEW_X, FRONT_VIEW_Y);
+	}
 
 	cv::Point p0;
 	cv::Point p1;
@@ -915,90 +1265,128 @@ bool SaveFile(void){
 	return cv::imwrite(savefile, img);
 }
 
+// [解決] Save count history when r key is pushed
+// 針對現在時間為名稱儲存 每分鐘、每小時、每日 的計數 (CSV)
+bool SaveReport(void){
+	//Make file name with current time
+	char buff[16];
+	time_t now = time(NULL);
+	struct tm *pnow = localtime(&now);
+	sprintf(buff, "%04d%02d%02d%02d%02d%02d",
+		pnow->tm_year + 1900, pnow->tm_mon + 1, pnow->tm_mday,
+		pnow->tm_hour, pnow->tm_min, pnow->tm_sec);
+	reportfile = buff;
+	reportfile += "_count.csv";
+
+	//Save (snapshot of history does not stop counting)
+	return history.WriteCsv(reportfile.c_str());
+}
+
+// [解決] Save trace when t key is pushed or a frame is slow
+// 針對現在時間為名稱儲存 各執行緒的追蹤記錄 (Chrome trace JSON，以 chrome://tracing 或 ui.perfetto.dev 開啟)
+int SaveTrace(void){
+	//Make file name with current time
+	char buff[16];
+	time_t now = time(NULL);
+	struct tm *pnow = localtime(&now);
+	sprintf(buff, "%04d%02d%02d%02d%02d%02d",
+		pnow->tm_year + 1900, pnow->tm_mon + 1, pnow->tm_mday,
+		pnow->tm_hour, pnow->tm_min, pnow->tm_sec);
+	tracefile = buff;
+	tracefile += "_trace.json";
+
+	//Save (events are copied while other threads are recording)
+	return TraceSave(tracefile.c_str());
+}
+
 //Catch humans detected by Human Detect function in SDK
 void CatchHumans(FrameHumans *pframehumans)
 {
+	TOF_TRACE_SCOPE("CatchHumans");
+
 	//Reset relation between humans managed in application and humans detected by SDK
-	for (unsigned int ahno = 0; ahno < apphumans.size(); ahno++){
+	for (int ahno = 0; ahno < apphumans.Size(); ahno++){
 		apphumans[ahno].bEnable = false;
 	}
 
+	// [解決] Enable Area of all humans detected by SDK (one loop without branch)
+	// 先一次計算全部人員 是否在 有效區間 之內
+	int numofhuman = pframehumans->numofhuman;
+	const Human* humans = pframehumans->humans.data();
+	enableflags.resize(numofhuman);
+	if (bEnableArea){
+		float left = EnableArea.left_x;
+		float right = EnableArea.right_x;
+		float top = EnableArea.top_y;
+		float bottom = EnableArea.bottom_y;
+		for (int hno = 0; hno < numofhuman; hno++){
+			enableflags[hno] = (unsigned char)((humans[hno].x >= left) & (humans[hno].x <= right) & (humans[hno].y >= top) & (humans[hno].y <= bottom));
+		}
+	}
+	else {
+		std::fill(enableflags.begin(), enableflags.end(), (unsigned char)1);
+	}
+
 	//Assign humans managed in application and humans detected by SDK
-	for (int hno = 0; hno < pframehumans->numofhuman; hno++){
+	for (int hno = 0; hno < numofhuman; hno++){
 
-		if (bEnableArea && !InEnableArea(pframehumans->humans[hno].x, pframehumans->humans[hno].y)){
+		if (!enableflags[hno]){
 			//Out of Enable Area
 			continue;
 		}
 
-		bool bAssigned = false;
-		for (unsigned int ahno = 0; ahno < apphumans.size(); ahno++){
-
-			if (apphumans[ahno].id == pframehumans->humans[hno].id){
-				//Found the current human --> assign
-
-				apphumans[ahno].bEnable = true;
-				apphumans[ahno].prex = apphumans[ahno].x;
-				apphumans[ahno].prey = apphumans[ahno].y;
-				apphumans[ahno].x = pframehumans->humans[hno].x;
-				apphumans[ahno].y = pframehumans->humans[hno].y;
-				apphumans[ahno].direction = pframehumans->humans[hno].direction;
-				apphumans[ahno].headheight = pframehumans->humans[hno].headheight;
-				apphumans[ahno].handheight = pframehumans->humans[hno].handheight;
-
-				//Status
-				HumanStatus status = pframehumans->humans[hno].status;
-
-				//Update status
-				apphumans[ahno].status = status;
-
-				//Register to tracking data(ring queue)
-				apphumans[ahno].track[apphumans[ahno].nexttrack].x = apphumans[ahno].prex;
-				apphumans[ahno].track[apphumans[ahno].nexttrack].y = apphumans[ahno].prey;
-				apphumans[ahno].nexttrack++;
-				if (apphumans[ahno].nexttrack == MAX_TRACKS){
-					apphumans[ahno].nexttrack = 0;
-				}
-				apphumans[ahno].trackcnt++;
-				if (apphumans[ahno].trackcnt > MAX_TRACKS){
-					apphumans[ahno].trackcnt = MAX_TRACKS;
-				}
+		int ahno = apphumans.Find(humans[hno].id);
+		if (ahno >= 0){
+			//Found the current human --> assign
 
-				bAssigned = true;
-				break;
-			}
-		}
+			apphumans.prex[ahno] = apphumans.x[ahno];
+			apphumans.prey[ahno] = apphumans.y[ahno];
+			apphumans.x[ahno] = humans[hno].x;
+			apphumans.y[ahno] = humans[hno].y;
 
-		if (!bAssigned){
+			AppHuman& ah = apphumans[ahno];
+			ah.bEnable = true;
+			ah.direction = humans[hno].direction;
+			ah.headheight = humans[hno].headheight;
+			ah.handheight = humans[hno].handheight;
+
+			//Update status
+			ah.status = humans[hno].status;
+
+			//Register to tracking data(ring queue of the human in the arena)
+			apphumans.tracks.Push(apphumans.Slot(ahno), apphumans.prex[ahno], apphumans.prey[ahno]);
+		}
+		else {
 			//No corresponded human managed in application (New human)
 
-			//Make new human information managed in application
-			AppHuman ah;
-			memset(&ah, 0, sizeof(ah));
+			//Make new human information managed in application (in the store, all members are 0)
+			ahno = apphumans.Add(humans[hno].id);
+			apphumans.x[ahno] = humans[hno].x;
+			apphumans.y[ahno] = humans[hno].y;
+			apphumans.prex[ahno] = humans[hno].x;
+			apphumans.prey[ahno] = humans[hno].y;
+			apphumans.enterdir[ahno] = COUNT_NO;
+			apphumans.exitdir[ahno] = COUNT_NO;
+
+			AppHuman& ah = apphumans[ahno];
 			ah.bEnable = true;
-			ah.id = pframehumans->humans[hno].id;
+			ah.appid = ++apphumanid;
 			ah.status = HumanStatus::Walk;
-			ah.x = pframehumans->humans[hno].x;
-			ah.y = pframehumans->humans[hno].y;
-			ah.prex = ah.x;
-			ah.prey = ah.y;
-			ah.direction = pframehumans->humans[hno].direction;
-			ah.headheight = pframehumans->humans[hno].headheight;
-			ah.handheight = pframehumans->humans[hno].handheight;
-			ah.enterdir = COUNT_NO;
-			ah.exitdir = COUNT_NO;
-			apphumans.push_back(ah);
+			ah.direction = humans[hno].direction;
+			ah.headheight = humans[hno].headheight;
+			ah.handheight = humans[hno].handheight;
 		}
 	}
 
 	//Delete human managed in application who was not assigned
-	for (int ahno = apphumans.size() - 1; ahno >= 0; ahno--){
+	for (int ahno = apphumans.Size() - 1; ahno >= 0; ahno--){
 		if (apphumans[ahno].bEnable == false){
-			//No assigend
+			//No assigend (the last human is moved here)
 
-			apphumans.erase(apphumans.begin() + ahno);
+			apphumans.RemoveAt(ahno);
 		}
 	}
+	pipelinemetrics.humans->Set(apphumans.Size());
 }
 
 bool ChangeAttribute(Tof& tof, float x, float y, float z, float rx, float ry, float rz)
@@ -1013,6 +1401,501 @@ bool ChangeAttribute(Tof& tof, float x, float y, float z, float rx, float ry, fl
 	return true;
 }
 
+// [解決] Acquisition thread
+// 讀取新的畫面禎放入 acquirering (處理來不及時丟棄並計數)
+void AcquireThread(Tof* ptof, bool bEtof)
+{
+	TOF_TRACE_THREAD("acquire");
+	long lastframeno = -1;
+	while (brun){
+
+		if (bAttribute.exchange(false)){
+			//Angle or height was changed
+			float ax, ay, az, h;
+			{
+				std::lock_guard<std::mutex> lock(settinglock);
+				ax = angle_x;
+				ay = angle_y;
+				az = angle_z;
+				h = height;
+			}
+			if (ChangeAttribute(*ptof, 0, 0, h * -1, ax, ay, az) == false){
+				StatusOut() << "TOF ID " << ptof->tofinfo.tofid << " Set Camera Attributee Error" << endl;
+			}
+		}
+
+		// [解決] Get the latest frame number
+		// 建立 frameno 變數，取得最後一張的影像禎計數的數量
+		// 建立 TimeStamp 變數，取得影像抓取時間
+		// tof.GetFrameStatus(&frameno, &timestamp);
+		// tof.GetFrameStatus(最後一張影像編號, 最後一張影像時間);
+		long frameno;
+		TimeStamp timestamp;
+		ptof->GetFrameStatus(&frameno, &timestamp);
+
+		// 確認 擷取影像更新 進行影像分析
+		if (frameno == lastframeno){
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		if ((lastframeno >= 0) && (frameno >= 0)){
+			//Frame number wraps at 0x7fffffff
+			long gap = FrameNumberDiff(lastframeno, frameno) - 1;
+			if (gap > 0){
+				pipelinemetrics.framegaps->Add(gap);
+			}
+		}
+
+		AcquireSlot* slot = acquirering.Claim();
+		if (slot == NULL){
+			//Processing is late --> drop this frame
+			acquirering.Drop();
+			pipelinemetrics.framesdropped->Add();
+			lastframeno = frameno;
+			continue;
+		}
+
+		// [解決] Read a frame of humans data
+		// 建立 定義 ToF API 回復確認參數 ret = Result::OK
+		// 讀取 ToF 的影像禎數據 --> 人像物件影像禎
+		// tof.ReadFrame(&framehumans)
+		// tof.ReadFrame(讀取建立的影像模式的變數之中)
+		Result ret = Result::OK;
+		long long readstart = MetricClock();
+		{
+			TOF_TRACE_SCOPE("ReadFrame humans");
+			ret = ptof->ReadFrame(&slot->framehumans);
+		}
+		pipelinemetrics.readframe->Observe(MetricClock() - readstart);
+		if (ret != Result::OK) {
+			StatusOut() << "read frame error" << endl;
+			brun = false;
+			break;
+		}
+
+		// [解決] Read a frame of depth data
+		// 讀取 ToF 的影像禎數據 --> 深度影像禎
+		ret = Result::OK;
+		readstart = MetricClock();
+		{
+			TOF_TRACE_SCOPE("ReadFrame depth");
+			ret = ptof->ReadFrame(&slot->frame);
+		}
+		pipelinemetrics.readframe->Observe(MetricClock() - readstart);
+		if (ret != Result::OK) {
+			StatusOut() << "read frame error" << endl;
+			brun = false;
+			break;
+		}
+		lastframeno = slot->frame.framenumber;
+		pipelinemetrics.framesread->Add();
+		telemetry.Read(slot->frame.framenumber, slot->stamp);
+
+		if (bEtof == true){
+			if (slot->frame.framenumber < 0){
+				//Replay whole data
+				StatusOut() << "replay finish" << endl;
+				brun = false;
+				break;
+			}
+		}
+
+		acquirering.Publish();
+	}
+}
+
+// [解決] Processing thread
+// 3D 轉換、俯視投影、人像抓取與計數 (每個擷取的畫面禎都處理)
+void ProcessThread(void)
+{
+	TOF_TRACE_THREAD("process");
+
+	// [解決] Create instances for 3D data after conversion
+	// 實作 3D影像 畫面幀
+	Frame3d frame3d;
+
+	// [解決] Create ray table for 3D conversion
+	// 建立 每個像素的光線表 (取代 Frame3d::Convert 的透鏡校正計算)
+	RayTable raytable;
+#ifdef _DEBUG
+	Frame3d checkframe3d;
+	bool bchecked = false;
+	RayPose checkedpose;
+#endif
+
+	// [解決] Create distance gate (length table of raw depth data)
+	// 建立 距離範圍閘門 (原始深度值 -> 距離 查表，範圍變更時才重新計算)
+	DepthGate gate;
+
+	// [解決] Allocate Z-buffer
+	// 配置 Z 軸暫存 (與 img 相同大小)
+	z_buffer.Resize(640 * 2, 480 * 2);
+
+	// [解決] Create color table
+	// 色彩變換 深度影像 -> 具有彩度的影像
+	// colorframe.CreateColorTable(0, 65530);
+	// colorframe.CreateColorTable(轉換最小值, 轉換最大值);
+	FrameDepth colorframe;
+	colorframe.CreateColorTable(0, 65530);
+
+	// [解決] Pack color table (one lookup per pixel)
+	// 將 B、G、R 三個色彩表合併為一個 32 bit 色彩表 (每個像素只查表一次)
+	ColorLut colorlut;
+	colorlut.Build(colorframe.ColorTable);
+
+	// [解決] Shape of points on the top view
+	// 俯視影像 散點形狀 (Display Key 7 變更大小)
+	RasterSplat topsplat;
+
+#ifdef _DEBUG
+	//Check that no memory is allocated in a frame after warming up
+	AllocationCheck alloccheck;
+#endif
+
+	while (brun){
+		AcquireSlot* in = acquirering.Front();
+		if (in == NULL){
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		// [解決] Size of points on the top view
+		// 俯視影像 散點大小 (大於 1 像素時 先寫入 Z 軸暫存，最後再繪製)
+		// (the setting is changed by keys under settinglock, splat is made before the allocation check of the frame)
+		int splatsize;
+		{
+			std::lock_guard<std::mutex> settings(settinglock);
+			splatsize = pointsize;
+		}
+		if (topsplat.size != splatsize){
+			topsplat.Set(splatsize, false);
+		}
+#ifdef _DEBUG
+		alloccheck.Begin();
+#endif
+		TOF_TRACE_SCOPE("ProcessFrame");
+		long long processstart = MetricClock();
+		FrameDepth& frame = in->frame;
+		FrameHumans& framehumans = in->framehumans;
+
+		std::unique_lock<std::mutex> lock(settinglock);
+
+		// [解決] 3D rotation in Z,Y,X order(to top view)
+		// 旋轉 3D 畫面 [X, Y, Z]軸 (預先合成到光線表，角度變更時才重新計算)
+		// raytable.SetPose(0, 0, 0, angle_x, angle_y, angle_z);
+		// raytable.SetPose(x, y, z, X軸角度, Y軸角度, Z軸角度) <- same as frame3d.RotateZYX(angle_x, angle_y, angle_z)
+		raytable.SetPose(0, 0, 0, angle_x, angle_y, angle_z);
+
+		// [解決] 3D conversion(with lens correction and rotation)
+		// 將 深度 畫面轉換成 3D 畫面禎
+		// Frame3d::Convert() and RotateZYX() are used until the ray of every pixel is learned (or for RAYTABLE_LEARN_FRAMES frames), then point = length * ray
+		// 學習完所有像素的光線 (或學習 RAYTABLE_LEARN_FRAMES 張畫面禎) 之前使用 Frame3d::Convert() 與 RotateZYX()，之後以 點 = 距離 * 光線 一次計算
+		long long convertstart = MetricClock();
+		{
+			//Includes rotation (RotateZYX is folded into the ray table)
+			TOF_TRACE_SCOPE("Convert");
+			raytable.Convert(&frame, &frame3d);
+		}
+		pipelinemetrics.convert->Observe(MetricClock() - convertstart);
+
+#ifdef _DEBUG
+		//Check the ray table with Frame3d::Convert() and RotateZYX() once after the pose is changed
+		if (raytable.IsReady() && (!bchecked || (checkedpose != raytable.pose))){
+			StatusOut() << "ray table max error " << raytable.Verify(&frame, &checkframe3d) << "[mm]" << endl;
+			bchecked = true;
+			checkedpose = raytable.pose;
+		}
+#endif
+
+		// [解決] Top view is made only if rendering has a free slot
+		// 繪製有空的畫面禎時才產生俯視影像 (沒有時只進行計數)
+		RenderSlot* out = renderring.Claim();
+		if (out != NULL){
+			// [解決] Initialize Z-buffer
+			// 初始化 Z 軸暫存 (只更新畫面禎編號)
+			z_buffer.Clear();
+
+			// [解決] 軌跡模式開關
+			// |- 開 -> 複製 擷取的背景禎
+			// |- 關 -> 清空 目前的畫布 (畫布重複使用，不重新配置)
+			ReuseMat(out->img, 480 * 2, 640 * 2, CV_8UC3);
+			if (bBack){
+				back.copyTo(out->img);
+			}
+			else {
+				out->img.setTo(cv::Scalar(0, 0, 0));
+			}
+			cv::Mat& img = out->img;
+
+			// [解決] 子畫面模式開關
+			// |- 開 -> 建構空畫布
+			out->bsub = bSubDisplay;
+			if (bSubDisplay){
+				//Initialize sub display
+				ReuseMat(out->subdisplay, SUB_DISPLAY_HEIGHT, SUB_DISPLAY_WIDTH, CV_8UC3);
+				out->subdisplay.setTo(cv::Scalar(0, 0, 0));
+			}
+			cv::Mat& subdisplay = out->subdisplay;
+
+			// [解決] Distance gate of humans detection range
+			// 以原始深度值的整數比較判定 距離範圍 (結果為每個像素 1 bit 的遮罩)
+			gate.Build(&frame, framehumans.distance_min, framehumans.distance_max);
+			gate.Gate(frame);
+
+			// [解決] Project to top view
+			// 距離判定、縮放位移、Z軸範圍、Z軸暫存與上色 以單一 kernel 一次處理 (TofProjection.h)
+			// 無效點位的 3D 轉換禎資料設定為(0, 0, 0)
+			TopViewParam topview;
+			topview.depth = &frame.databuf[0];
+			topview.depth_min = frame.distance_min;
+			topview.depth_max = frame.distance_max;
+			topview.colorlut = &colorlut;
+			topview.mask = &gate.mask[0];
+			topview.points = &frame3d.frame3d[0];
+			topview.width = frame3d.width;
+			topview.height = frame3d.height;
+			topview.distance_min = framehumans.distance_min;
+			topview.distance_max = framehumans.distance_max;
+			topview.z_min = framehumans.z_min;
+			topview.z_max = framehumans.z_max;
+			topview.zoom = zoom;
+			topview.dx = dx;
+			topview.dy = dy;
+			topview.bpoint = bPoint;
+			topview.splat = &topsplat;
+			topview.img = img.data;
+			topview.imgstep = img.step;
+			topview.imgcols = img.cols;
+			topview.imgrows = img.rows;
+			topview.zbuffer = &z_buffer;
+			topview.sub = NULL;
+			if (bSubDisplay){
+				topview.sub = subdisplay.data;
+				topview.substep = subdisplay.step;
+				topview.subcols = subdisplay.cols;
+				topview.subrows = subdisplay.rows;
+			}
+			{
+				TOF_TRACE_SCOPE("ProjectTopView");
+				ProjectTopView(topview);
+			}
+		}
+
+		// [解function] Catch detected humans
+		CatchHumans(&framehumans);
+
+		// [解function] Human count
+		CountHumans(&framehumans);
+		long long latency = telemetry.Processed(in->stamp);
+		pipelinemetrics.latency->Observe(latency / 1000);
+		if (tracetrigger.Check(latency)){
+			//Slow frame --> trace is saved by rendering thread
+			btracerequest = true;
+		}
+
+		// [解function] Draw footprints
+		// 繪製人像軌跡到背景 (每個處理的畫面禎都繪製)
+		DrawFootprints();
+
+		if (out != NULL){
+			//Data for rendering
+			out->apphumans.CopyFrom(apphumans);
+			out->count = Count;
+			out->zonecounts = zones.counts;
+			out->tripwirecounts = tripwires.counts;
+			out->stamp = in->stamp;
+			out->frame3d.width = 0;
+			out->frame3d.height = 0;
+			if ((mode == 'a') || (mode == 'h')){
+				out->frame3d.width = frame3d.width;
+				out->frame3d.height = frame3d.height;
+				out->frame3d.frame3d = frame3d.frame3d;
+			}
+			renderring.Publish();
+		}
+		else {
+			//Rendering is late --> only count
+			renderring.Drop();
+		}
+		lock.unlock();
+		pipelinemetrics.process->Observe(MetricClock() - processstart);
+#ifdef _DEBUG
+		long long allocations = alloccheck.End();
+		if (allocations != 0){
+			StatusOut() << "frame " << frame.framenumber << ": " << allocations << " allocations in processing" << endl;
+		}
+#endif
+		acquirering.Pop();
+	}
+#ifdef _DEBUG
+	StatusOut() << "processing: " << alloccheck.badframes << " of " << alloccheck.frames << " frames allocated memory" << endl;
+#endif
+}
+
+// [解決] Stop headless counting by Ctrl+C or closing console
+// 以 Ctrl+C 或 關閉主控台 停止無顯示計數
+BOOL WINAPI HeadlessCtrlHandler(DWORD type)
+{
+	brun = false;
+	return TRUE;
+}
+
+// [解決] Headless counting
+// 只讀取 人像 畫面禎並計數 (不讀取深度、不進行 3D 轉換與 OpenCV 繪製)，計數以事件 (JSON 一行一筆) 輸出
+void RunHeadless(Tof* ptof, bool bEtof)
+{
+	// [解決] Create instances for reading human frames
+	// 時做 人像 畫面幀
+	FrameHumans framehumans;
+	FrameStamp stamp;
+
+	SetConsoleCtrlHandler(HeadlessCtrlHandler, TRUE);
+	StatusOut() << "Headless counting (Ctrl+C for Quit)" << endl;
+	TOF_TRACE_THREAD("count");
+
+#ifdef _DEBUG
+	//Check that no memory is allocated in a frame after warming up
+	AllocationCheck alloccheck;
+#endif
+
+	long lastframeno = -1;
+	while (brun){
+
+		// [解決] Get the latest frame number
+		// 取得最後一張的影像禎計數，沒有新的影像禎時等待
+		long frameno;
+		TimeStamp timestamp;
+		ptof->GetFrameStatus(&frameno, &timestamp);
+		if (frameno == lastframeno){
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		if ((lastframeno >= 0) && (frameno >= 0)){
+			//Frame number wraps at 0x7fffffff
+			long gap = FrameNumberDiff(lastframeno, frameno) - 1;
+			if (gap > 0){
+				pipelinemetrics.framegaps->Add(gap);
+			}
+		}
+
+		// [解決] Read a frame of humans data
+		// 讀取 ToF 的影像禎數據 --> 人像物件影像禎
+		long long readstart = MetricClock();
+		Result ret;
+		{
+			TOF_TRACE_SCOPE("ReadFrame humans");
+			ret = ptof->ReadFrame(&framehumans);
+		}
+		pipelinemetrics.readframe->Observe(MetricClock() - readstart);
+		if (ret != Result::OK) {
+			StatusOut() << "read frame error" << endl;
+			break;
+		}
+		lastframeno = framehumans.framenumber;
+		pipelinemetrics.framesread->Add();
+		telemetry.Read(framehumans.framenumber, stamp);
+
+		if (bEtof == true){
+			if (framehumans.framenumber < 0){
+				//Replay whole data
+				StatusOut() << "replay finish" << endl;
+				break;
+			}
+		}
+
+#ifdef _DEBUG
+		alloccheck.Begin();
+#endif
+		long long processstart = MetricClock();
+
+		TOF_TRACE_SCOPE("CountFrame");
+
+		// [解function] Catch detected humans
+		CatchHumans(&framehumans);
+
+		// [解function] Human count
+		CountHumans(&framehumans);
+
+		pipelinemetrics.process->Observe(MetricClock() - processstart);
+		long long latency = telemetry.Processed(stamp);
+		pipelinemetrics.latency->Observe(latency / 1000);
+		if (tracetrigger.Check(latency) && (SaveTrace() >= 0)){
+			StatusOut() << "Slow frame " << latency / 1000000 << " ms: trace saved to " << tracefile << endl;
+		}
+#ifdef _DEBUG
+		long long allocations = alloccheck.End();
+		if (allocations != 0){
+			StatusOut() << "frame " << framehumans.framenumber << ": " << allocations << " allocations in counting" << endl;
+		}
+#endif
+
+		// [解決] Output count events
+		// 輸出 計數事件
+		for (unsigned int eno = 0; eno < countevents.size(); eno++){
+			std::cout << FormatCountEvent(countevents[eno]) << "\n";
+		}
+		if (!countevents.empty()){
+			std::cout.flush();
+		}
+		telemetry.Output(stamp);
+	}
+	brun = false;
+
+	StatusOut() << "Total Enter " << Count.TotalEnter << ", Total Exit " << Count.TotalExit << endl;
+	PrintZoneCounts();
+	if (SaveReport()){
+		StatusOut() << "Report saved to " << reportfile << endl;
+	}
+#ifdef _DEBUG
+	StatusOut() << "counting: " << alloccheck.badframes << " of " << alloccheck.frames << " frames allocated memory" << endl;
+#endif
+	SetConsoleCtrlHandler(HeadlessCtrlHandler, FALSE);
+}
+
+// [解決] Text of latency percentiles ("p50/p99/p999 ms")
+// 延遲 百分位數 文字
+string FormatLatency(const LatencyStat& stat)
+{
+	char buff[64];
+	sprintf(buff, "%.1f/%.1f/%.1f ms", stat.p50 / 1000000.0, stat.p99 / 1000000.0, stat.p999 / 1000000.0);
+	return buff;
+}
+
+// [解決] Output frames, dropped frames and latency
+// 輸出 畫面禎數、丟失畫面禎數 與 延遲
+void PrintTelemetry(void)
+{
+	TelemetryStat stat = telemetry.Stat();
+	StatusOut() << "Frames " << stat.frames << ", dropped " << stat.dropped << " frames" << endl;
+	StatusOut() << "Count latency p50/p99/p999 " << FormatLatency(stat.processed) << " (max "
+		<< stat.processed.max / 1000000.0 << " ms)" << endl;
+	if (stat.output.num != 0){
+		StatusOut() << "Output latency p50/p99/p999 " << FormatLatency(stat.output) << " (max "
+			<< stat.output.max / 1000000.0 << " ms)" << endl;
+	}
+}
+
+// [解決] Register metrics of pipeline
+// 註冊 管線 監控指標 (執行緒啟動前)
+void InitializeMetrics(void)
+{
+	int numofbucket;
+	const long long* latency = MetricLatencyBuckets(numofbucket);
+	PipelineMetrics& m = pipelinemetrics;
+	m.framesread = metrics.Counter("hlds_frames_read_total", "Frames read from the sensor");
+	m.framegaps = metrics.Counter("hlds_frame_gaps_total", "Frames skipped by the sensor (gaps of frame number)");
+	m.framesdropped = metrics.Counter("hlds_frames_dropped_total", "Frames dropped because processing was late");
+	m.readframe = metrics.Histogram("hlds_read_frame_seconds", "Latency of ReadFrame()", latency, numofbucket, 0.000001);
+	m.convert = metrics.Histogram("hlds_convert_seconds", "Time of 3D conversion of a frame", latency, numofbucket, 0.000001);
+	m.process = metrics.Histogram("hlds_process_seconds", "Time of processing of a frame", latency, numofbucket, 0.000001);
+	m.render = metrics.Histogram("hlds_render_seconds", "Time of rendering of a frame", latency, numofbucket, 0.000001);
+	m.humans = metrics.Gauge("hlds_humans_tracked", "Humans tracked");
+	m.totalenter = metrics.Gauge("hlds_count_total_enter", "Total number of humans entering (reset by key 0)");
+	m.totalexit = metrics.Gauge("hlds_count_total_exit", "Total number of humans exiting (reset by key 0)");
+	m.inarea = metrics.Gauge("hlds_count_in_area", "Humans in the count area");
+	m.latency = metrics.Histogram("hlds_frame_latency_seconds", "Latency from read to the end of counting of a frame", latency, numofbucket, 0.000001);
+}
+
 void main(void)
 {
 	// [解決] Initialize human counter
@@ -1042,6 +1925,9 @@ void main(void)
 	// 撈取 Human.ini 檔案設定
 	LoadIniFile();
 
+	//Metrics are registered before threads start
+	InitializeMetrics();
+
 	// [解決] Create TofManager 
 	// 利用 ToFManger 對於網路中 ToF 設備進行查找 
 	TofManager tofm;
@@ -1049,7 +1935,7 @@ void main(void)
 	// [解決] Open TOF Manager (Read tof.ini file) 
 	// 讀取 tof.ini 檔案
 	if (tofm.Open() != Result::OK){
-		std::cout << "TofManager Open Error (may not be tof.ini file)" << endl;
+		StatusOut() << "TofManager Open Error (may not be tof.ini file)" << endl;
 		system("pause");
 		return;
 	}
@@ -1060,7 +1946,7 @@ void main(void)
 	int numoftof = tofm.GetTofList(&ptofinfo);
 
 	if (numoftof == 0){
-		std::cout << "No TOF Sensor" << endl;
+		StatusOut() << "No TOF Sensor" << endl;
 		bEtof = true;
 	}
 
@@ -1072,7 +1958,7 @@ void main(void)
 	// 確認 ToF 是否存在於網路環境中，並嘗試開啟連線(該執行檔僅找一台 ToF 開啟)
 	if (bEtof == false){
 		if (tof.Open(ptofinfo[0]) != Result::OK){
-			std::cout << "TOF ID " << ptofinfo[0].tofid << " Open Error" << endl;
+			StatusOut() << "TOF ID " << ptofinfo[0].tofid << " Open Error" << endl;
 			system("pause");
 			return;
 		}
@@ -1083,7 +1969,7 @@ void main(void)
 		eTof.filename = "TofCapture.bin";
 
 		if (tof.Open(eTof) != Result::OK){
-			std::cout << "eTOF Open Error" << endl;
+			StatusOut() << "eTOF Open Error" << endl;
 			system("pause");
 			return;
 		}
@@ -1092,7 +1978,7 @@ void main(void)
 	// [解決] Once Tof instances are started, TofManager is not necessary and closed
 	// 當 ToF 設備實做並測試連線之後，ToF Manger 將會自動關閉(ToF Manger 僅用於查找設備)
 	if (tofm.Close() != Result::OK){
-		std::cout << "TofManager Close Error" << endl;
+		StatusOut() << "TofManager Close Error" << endl;
 		system("pause");
 		return;
 	}
@@ -1113,7 +1999,7 @@ void main(void)
 	// |- Background_Ir     - 背景結合 + 紅外線輸出模式
 	// |- CameraModeUnkown  - 未配置或是未知模式
 	if (tof.SetCameraMode(CameraMode::CameraModeDepth) != Result::OK){
-		std::cout << "TOF ID " << tof.tofinfo.tofid << " Set Camera Mode Error" << endl;
+		StatusOut() << "TOF ID " << tof.tofinfo.tofid << " Set Camera Mode Error" << endl;
 		system("pause");
 		return;
 	}
@@ -1133,7 +2019,7 @@ void main(void)
 
 	if (tof.SetCameraPixel(CameraPixel::w320h240) != Result::OK){
 		//	if (tof.SetCameraPixel(CameraPixel::w160h120) != Result::OK){
-		std::cout << "TOF ID " << tof.tofinfo.tofid << " Set Camera Pixel Error" << endl;
+		StatusOut() << "TOF ID " << tof.tofinfo.tofid << " Set Camera Pixel Error" << endl;
 		system("pause");
 		return;
 	}
@@ -1144,7 +2030,7 @@ void main(void)
 	// tof.SetAttribute(x軸位移, y軸位移, z軸位移[從地板算起 ToF 設備高度](高度 * -1), x軸旋轉角度, y軸旋轉角度, z軸旋轉角度)
 	// 全部數值型態皆為浮點數
 	if (tof.SetAttribute(0, 0, height * -1, angle_x, angle_y, angle_z) != Result::OK){
-		std::cout << "TOF ID " << tof.tofinfo.tofid << " Set Camera Position Error" << endl;
+		StatusOut() << "TOF ID " << tof.tofinfo.tofid << " Set Camera Position Error" << endl;
 		system("pause");
 		return;
 	}
@@ -1154,7 +2040,7 @@ void main(void)
 	// tof.SetLowSignalCutoff(閥值)
 	// 閥值區間 0 - 4095 (0 = 不切斷 / 4095 = 最大值)
 	if (tof.SetLowSignalCutoff(10) != Result::OK){
-		std::cout << "TOF ID " << tof.tofinfo.tofid << " Low Signal Cutoff Error" << endl;
+		StatusOut() << "TOF ID " << tof.tofinfo.tofid << " Low Signal Cutoff Error" << endl;
 		system("pause");
 		return;
 	}
@@ -1165,7 +2051,7 @@ void main(void)
 	// tof.SetEdgeSignalCutoff(EdgeSignalCutoff::設定值)
 	// 設定值 Enable / Disable
 	if (tof.SetEdgeSignalCutoff(EdgeSignalCutoff::Enable) != Result::OK){
-		std::cout << "TOF ID " << tof.tofinfo.tofid << " Edge Noise Reduction Error" << endl;
+		StatusOut() << "TOF ID " << tof.tofinfo.tofid << " Edge Noise Reduction Error" << endl;
 		system("pause");
 		return;
 	}
@@ -1181,216 +2067,76 @@ void main(void)
 	// - Unknown        - 未設定或未知模式
 	ret = tof.Run(RunMode::HumanDetect);
 	if (ret != Result::OK){
-		std::cout << "TOF ID " << tof.tofinfo.tofid << " Run Error: " << (int)ret << endl;
+		StatusOut() << "TOF ID " << tof.tofinfo.tofid << " Run Error: " << (int)ret << endl;
 		system("pause");
 		return;
 	}
-	std::cout << "TOF ID " << tof.tofinfo.tofid << " Run OK" << endl;
-
-	// [解決] Create instances for reading frames
-	// 實作 深度影像 畫面幀
-	FrameDepth frame;
-
-	// [解決] Create instances for 3D data after conversion
-	// 實作 3D影像 畫面幀
-	Frame3d frame3d;
-
-	// [解決] Create instances for reading human frames
-	// 時做 人像 畫面幀
-	FrameHumans framehumans;
-
-	// [解決] Create color table
-	// 色彩變換 深度影像 -> 具有彩度的影像
-	// frame.CreateColorTable(0, 65530);
-	// frame.CreateColorTable(轉換最小值, 轉換最大值);
-	frame.CreateColorTable(0, 65530);
-
-	// [解決] Create display window as changeable size
-	// 利用 OpenCV 開啟圖像視窗
-	cv::namedWindow("Human Counter", CV_WINDOW_NORMAL);
-
-	// [解決] Sub display
-	// 對於視窗 建立子視窗
-	cv::Mat subdisplay(SUB_DISPLAY_WIDTH, SUB_DISPLAY_HEIGHT, CV_8UC3);
+	StatusOut() << "TOF ID " << tof.tofinfo.tofid << " Run OK" << endl;
 
 	//Initialize human information
 	InitializeHumans();
 
-	// [解決] Initialize background
-	// 創建圖像空間 (創建圖像大小 -> 內容是空白的)
-	back = cv::Mat::zeros(480 * 2, 640 * 2, CV_8UC3);
+	// [解決] Start writing journal of count events
+	// 開始寫入 計數事件 記錄檔
+	journal.Open(journalbase);
 
-	// brun 參數 用於畫面視窗與程式是否退出進行程式停止與跳脫
-	bool brun = true;
-	while (brun){
-
-		// [解決] Get the latest frame number
-		// 建立 frameno 變數，取得最後一張的影像禎計數的數量
-		// 建立 TimeStamp 變數，取得影像抓取時間
-		// tof.GetFrameStatus(&frameno, &timestamp);
-		// tof.GetFrameStatus(最後一張影像編號, 最後一張影像時間);
-		long frameno;
-		TimeStamp timestamp;
-		tof.GetFrameStatus(&frameno, &timestamp);
-
-		// 確認 frame.framenumber -> 影格的影像計數 是否等於 擷取的影像的影像計數
-		// 確認 擷取影像更新 進行影像分析
-		if (frameno != frame.framenumber){
-			//Read a new frame only if frame number is changed(Old data is shown if it is not changed.)
-
-			// [解決] Read a frame of humans data
-			// 建立 定義 ToF API 回復確認參數 ret = Result::OK
-			// 讀取 ToF 的影像禎數據 --> 人像物件影像禎
-			// tof.ReadFrame(&framehumans)
-			// tof.ReadFrame(讀取建立的影像模式的變數之中)
-			Result ret = Result::OK;
-			ret = tof.ReadFrame(&framehumans);
-			if (ret != Result::OK) {
-				std::cout << "read frame error" << endl;
-				break;
-			}
-
-			// [解決] Read a frame of depth data
-			// 讀取 ToF 的影像禎數據 --> 深度影像禎
-			ret = Result::OK;
-			ret = tof.ReadFrame(&frame);
-			if (ret != Result::OK) {
-				std::cout << "read frame error" << endl;
-				break;
-			}
+	// [解決] Start metrics server
+	// 啟動 監控指標 伺服器 (只接受本機連線)
+	if (metricsport != 0){
+		if (metricsserver.Start(&metrics, metricsport)){
+			StatusOut() << "Metrics http://127.0.0.1:" << metricsport << "/metrics" << endl;
+		}
+		else {
+			StatusOut() << "Metrics server error (port " << metricsport << ")" << endl;
+		}
+	}
 
-			if (bEtof == true){
-				if (frame.framenumber < 0){
-					//Replay whole data
-					std::cout << "replay finish" << endl;
-					break;
-				}
-			}
+	std::thread acquirethread;
+	std::thread processthread;
+	if (bHeadless){
+		// [解決] Headless counting (HEADLESS=1 in ini file)
+		// 無顯示 計數模式 (結束後 brun 為 false，不進入顯示迴圈)
+		RunHeadless(&tof, bEtof);
+	}
+	else {
+		// [解決] Create display window as changeable size
+		// 利用 OpenCV 開啟圖像視窗
+		cv::namedWindow("Human Counter", CV_WINDOW_NORMAL);
 
-			// [解決] 3D conversion(with lens correction)
-			// 將 深度 畫面轉換成 3D 畫面禎
-			frame3d.Convert(&frame);
+		// [解決] Initialize background
+		// 創建圖像空間 (創建圖像大小 -> 內容是空白的)
+		back = cv::Mat::zeros(480 * 2, 640 * 2, CV_8UC3);
 
-			// [解決] 3D rotation in Z,Y,X order(to top view)
-			// 旋轉 3D 畫面 [X, Y, Z]軸
-			// frame3d.RotateZYX(angle_x, angle_y, angle_z);
-			// frame3d.RotateZYX(X軸角度, Y軸角度, Z軸角度)
-			frame3d.RotateZYX(angle_x, angle_y, angle_z);
+		// [解決] Start acquisition and processing threads
+		// 啟動 擷取 與 處理 執行緒 (繪製與按鍵在主執行緒)
+		acquirethread = std::thread(AcquireThread, &tof, bEtof);
+		processthread = std::thread(ProcessThread);
+	}
 
-			// [解決] Initialize Z-buffer
-			// 初始化 Z 軸值 設定為 0
-			memset(z_buffer, 0, sizeof(z_buffer));
+	TOF_TRACE_THREAD("render");
 
-			// [解決] 軌跡模式開關
-			// |- 開 -> 複製 擷取的背景禎
-			// |- 關 -> 清空 目前的畫布
-			if (bBack){
-				img = back.clone();
-			}
-			else {
-				img = cv::Mat::zeros(480 * 2, 640 * 2, CV_8UC3);
-			}
+	// [解決] Latency statistics on the display (updated every TELEMETRY_STAT_MSEC, not every frame)
+	// 顯示用 延遲統計 (每 TELEMETRY_STAT_MSEC 更新一次)
+	TelemetryStat telemetrystat = telemetry.Stat();
+	long long telemetryclock = TelemetryClock();
 
-			// [解決] 子畫面模式開關
-			// |- 開 -> 建構空畫布
-			if (bSubDisplay){
-				//Initialize sub display
-				subdisplay = cv::Mat::zeros(SUB_DISPLAY_HEIGHT, SUB_DISPLAY_WIDTH, CV_8UC3);
-			}
-
-			for (int y = 0; y < frame3d.height; y++){
-				for (int x = 0; x < frame3d.width; x++){
-
-					// [解決] 利用深度模式 偵測影格(單一像素) 與 ToF 距離
-					// frame.CalculateLength(frame.databuf[y * frame.width + x])
-					// frame.CalculateLength(擷取深度影像中第N個像素的測距深度)
-					if ((frame.CalculateLength(frame.databuf[y * frame.width + x]) >= framehumans.distance_min) && (frame.CalculateLength(frame.databuf[y * frame.width + x]) <= framehumans.distance_max)){
-						//Valid data(Only data in specific distance for sensor is valid)
-
-						// [解決] 實作 ToF 3D 像素點
-						TofPoint point;		//Coordinate after rotation
-
-						// [解決] Get coordinates after 3D conversion
-						// 針對像素點給予相對 X、Y、Z軸 定位距離 
-						point.x = frame3d.frame3d[y * frame3d.width + x].x;
-						point.y = frame3d.frame3d[y * frame3d.width + x].y;
-						point.z = frame3d.frame3d[y * frame3d.width + x].z;
-
-						// [解決] Zoom
-						// 將距離進行縮放拉伸，藉此達到放大縮小的功能
-						// point.x = point.x * zoom; 
-						// point.y = point.y * zoom; 
-						point.x *= zoom;
-						point.y *= zoom;
-
-						// [解決] Shift to X/Y direction on display
-						// 透過共同位移圖像位置，移動點位至需要顯示畫面的地方
-						// 原圖在畫面點位(10, 10) 開始繪圖，增加 dx = 5、dy = 5
-						// 將從畫面點位(15, 15) 開始繪圖造成位移畫面效果
-						point.x += dx;
-						point.y += dy;
-
-						// [解決] 確認現在像素點位是在畫面之中
-						if ((point.x >= 0) && (point.x < img.size().width) && (point.y >= 0) && (point.y < img.size().height)){
-							
-							// [解決] Within range of Z direction
-							// 確認 z 軸 資料在 人像畫面 的 高度區間 之中	
-							if ((point.z >= framehumans.z_min) && (point.z < framehumans.z_max)){
-								
-								// [解決] Front than data already registered in Z-buffer
-								// 確認目前像素點的 z軸暫存資料 沒有被塞入過
-								if ((z_buffer[(int)point.x][(int)point.y] == 0) || (z_buffer[(int)point.x][(int)point.y] > point.z)){
-									
-									// [解決] Register to Z-buffer
-									// 將目前的 z軸測距 更新到 z軸暫存資料 之中
-									z_buffer[(int)point.x][(int)point.y] = point.z;
-
-									// [解決] Register color to display image based on distance of Z direction
-									// 透過拆解像素高度定位、在畫布中的位置等，修改顯示的顏色
-									long color = (long)(65530 * (point.z - framehumans.z_min) / ((framehumans.z_max - framehumans.z_min)));
-
-									// [解決] 透過 openCV 建立矩陣
-									//　將深度的影像資料轉入 RGB 三個通道進行數值塞入，建立色彩顯示點
-									cv::Vec3b v;
-									v.val[0] = frame.ColorTable[0][color];
-									v.val[1] = frame.ColorTable[1][color];
-									v.val[2] = frame.ColorTable[2][color];
-
-									// 	[解決] 確認是否開啟 散點模式
-									// |- 開啟 -> 將 散點 畫在畫布上面
-									if (bPoint){
-										img.at<cv::Vec3b>((int)point.y, (int)point.x) = v;
-									}
-								}
-								// [解決] Sub display
-								// 建構視窗子畫面
-								if (bSubDisplay){
-									// OpenCV 建構影像矩陣擺放子畫面
-									// 將深度畫面 RGB 通道資料存入矩陣之中，並在子畫面顯示
-									cv::Vec3b v;
-									v.val[0] = frame.ColorTable[0][frame.databuf[y * frame.width + x]];
-									v.val[1] = frame.ColorTable[1][frame.databuf[y * frame.width + x]];
-									v.val[2] = frame.ColorTable[2][frame.databuf[y * frame.width + x]];
-									subdisplay.at<cv::Vec3b>(y * SUB_DISPLAY_HEIGHT / frame3d.height, x * SUB_DISPLAY_WIDTH / frame3d.width) = v;
-								}
-							}
-						}
-					}
-					// [解決] Invalid point is (x,y,z) = (0,0,0) 
-					// 如果 3D 轉換禎超過臨界值，則該點位的定位資料為(0, 0, 0)
-					else {
-						frame3d.frame3d[y * frame3d.width + x].x = 0;
-						frame3d.frame3d[y * frame3d.width + x].y = 0;
-						frame3d.frame3d[y * frame3d.width + x].z = 0;
-					}
-				}
-			}
+	// brun 參數 用於畫面視窗與程式是否退出進行程式停止與跳脫
+	while (brun){
 
-			// [解function] Catch detected humans
-			CatchHumans(&framehumans);
+		// [解決] Save trace requested by a slow frame
+		// 處理執行緒發現 較慢的畫面禎 時 儲存追蹤記錄
+		if (btracerequest.exchange(false) && (SaveTrace() >= 0)){
+			StatusOut() << "Slow frame: trace saved to " << tracefile << endl;
+		}
 
-			// [解function] Human count
-			CountHumans();
+		// 確認 處理完成的畫面禎 進行繪製
+		RenderSlot* slot = renderring.Front();
+		if (slot != NULL){
+			TOF_TRACE_SCOPE("RenderFrame");
+			long long renderstart = MetricClock();
+			//Draw a processed frame (Old data is shown if there is no new frame.)
+			img = slot->img;
+			cv::Mat& subdisplay = slot->subdisplay;
 
 			// [解function] Draw Enable Area
 			if (mode == 'e'){
@@ -1399,17 +2145,19 @@ void main(void)
 
 			// [解function] Draw humans
 			// 繪製人像抓取定位
-			DrawHumans();
+			DrawHumans(slot->apphumans);
 
 			if ((mode == 'a') || (mode == 'h')){
 				// [解function] Draw side/front view
 				// 繪製3D轉換影像
-				DrawSection(&frame3d);
+				DrawSection(&slot->frame3d);
 			}
 			else if (bCount){
 				// [解決function] Draw human counter
 				// 繪製人數計算列表
-				DrawCount();
+				DrawCount(slot->count);
+				DrawZones(slot->zonecounts);
+				DrawTripwires(slot->tripwirecounts);
 			}
 
 			// [解決] Display information
@@ -1547,6 +2295,18 @@ void main(void)
 				}
 				cv::putText(img, text, cv::Point(tx, ty), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
 				ty += tdy;
+				text = "Display Key 5: Pipeline Status ";
+				if (bPipeline){
+					text += "ON";
+				}
+				else {
+					text += "OFF";
+				}
+				cv::putText(img, text, cv::Point(tx, ty), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
+				ty += tdy;
+				text = "Display Key 7: Point Size " + std::to_string(pointsize);
+				cv::putText(img, text, cv::Point(tx, ty), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
+				ty += tdy;
 				if (bBack){
 					text = "Display Key 9: Reset Footprints";
 					cv::putText(img, text, cv::Point(tx, ty), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
@@ -1566,6 +2326,24 @@ void main(void)
 				}
 				cv::putText(img, text, cv::Point(tx, ty), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
 				break;
+			case 't':
+				if (tracefile != ""){
+					text = "Trace saved to " + tracefile;
+				}
+				else {
+					text = "Trace Failed !";
+				}
+				cv::putText(img, text, cv::Point(tx, ty), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
+				break;
+			case 'r':
+				if (reportfile != ""){
+					text = "Report saved to " + reportfile;
+				}
+				else {
+					text = "Report Failed !";
+				}
+				cv::putText(img, text, cv::Point(tx, ty), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
+				break;
 			case 'q':
 				text = "Quit ? y: yes";
 				cv::putText(img, text, cv::Point(tx, ty), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
@@ -1604,12 +2382,18 @@ void main(void)
 				text = "Key f: File Save";
 				cv::putText(img, text, cv::Point(tx, ty), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
 				ty += tdy;
+				text = "Key r: Count Report";
+				cv::putText(img, text, cv::Point(tx, ty), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
+				ty += tdy;
+				text = "Key t: Trace Save";
+				cv::putText(img, text, cv::Point(tx, ty), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
+				ty += tdy;
 				text = "Key m: Menu";
 				cv::putText(img, text, cv::Point(tx, ty), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
 				ty += tdy;
 			}
 
-			if (bSubDisplay){
+			if (slot->bsub){
 				//Sub display
 
 				if ((angle_y == 0) && ((angle_z < 45) || (angle_z > 270))){
@@ -1629,15 +2413,60 @@ void main(void)
 					}
 				}
 			}
+			if (bPipeline){
+				// [解決] Pipeline status
+				// 顯示 每個階段的 等待畫面禎數 與 丟棄畫面禎數
+				PipelineStat acquirestat = acquirering.Stat();
+				PipelineStat renderstat = renderring.Stat();
+				text = "Acquire queue " + std::to_string(acquirestat.depth) + "/" + std::to_string(acquirestat.size)
+					+ " drop " + std::to_string(acquirestat.dropped);
+				cv::putText(img, text, cv::Point(850, 900), cv::FONT_HERSHEY_TRIPLEX, 0.6, color, 1, CV_AA);
+				text = "Render queue " + std::to_string(renderstat.depth) + "/" + std::to_string(renderstat.size)
+					+ " skip " + std::to_string(renderstat.dropped);
+				cv::putText(img, text, cv::Point(850, 930), cv::FONT_HERSHEY_TRIPLEX, 0.6, color, 1, CV_AA);
+
+				// [解決] Latency (p50/p99/p999 of the last frames) and dropped frames
+				// 顯示 畫面禎 延遲 (讀取 -> 計數，讀取 -> 顯示) 與 丟失畫面禎數
+				long long now = TelemetryClock();
+				if (now - telemetryclock >= TELEMETRY_STAT_MSEC * 1000000LL){
+					telemetrystat = telemetry.Stat();
+					telemetryclock = now;
+				}
+				text = "Count latency " + FormatLatency(telemetrystat.processed) + " drop " + std::to_string(telemetrystat.dropped);
+				cv::putText(img, text, cv::Point(850, 840), cv::FONT_HERSHEY_TRIPLEX, 0.6, color, 1, CV_AA);
+				text = "Display latency " + FormatLatency(telemetrystat.output);
+				cv::putText(img, text, cv::Point(850, 870), cv::FONT_HERSHEY_TRIPLEX, 0.6, color, 1, CV_AA);
+			}
+
 			if (NULL == cvGetWindowHandle("Human Counter")){
 				brun = false;
 			}
 			else{
-				cv::imshow("Human Counter", img);
+				{
+					TOF_TRACE_SCOPE("imshow");
+					cv::imshow("Human Counter", img);
+				}
+				telemetry.Output(slot->stamp);
 			}
+
+			if (bSave){
+				//Save file
+				if (!SaveFile()){
+					//Failed
+					savefile = "";
+				}
+				bSave = false;
+			}
+			renderring.Pop();
+			pipelinemetrics.render->Observe(MetricClock() - renderstart);
+		}
+		// [解決] 等待 1ms 並抓取鍵盤按鍵輸入值 (處理在其他執行緒，等待只影響顯示)
+		// 按鍵變更的設定值 在處理執行緒的畫面禎之間變更
+		auto key = cv::waitKey(1);
+		std::unique_lock<std::mutex> lock(settinglock, std::defer_lock);
+		if (key != -1){
+			lock.lock();
 		}
-		// [解決] 等待 10ms 並抓取鍵盤按鍵輸入值
-		auto key = cv::waitKey(10);
 		switch (key){
 		case 'a':
 			if (mode == key){
@@ -1707,10 +2536,33 @@ void main(void)
 				mode = 0;
 			}
 			else {
-				//Save file
-				if (!SaveFile()){
+				//Save file (the next displayed image)
+				bSave = true;
+				mode = key;
+			}
+			break;
+		case 'r':
+			if (mode == key){
+				mode = 0;
+			}
+			else {
+				//Save count report (history is read without stopping processing)
+				if (!SaveReport()){
 					//Failed
-					savefile = "";
+					reportfile = "";
+				}
+				mode = key;
+			}
+			break;
+		case 't':
+			if (mode == key){
+				mode = 0;
+			}
+			else {
+				//Save trace (events are read without stopping processing)
+				if (SaveTrace() < 0){
+					//Failed
+					tracefile = "";
 				}
 				mode = key;
 			}
@@ -1746,6 +2598,16 @@ void main(void)
 				bSubDisplay = !bSubDisplay;
 			}
 			break;
+		case '5':
+			if (mode == 'p'){
+				bPipeline = !bPipeline;
+			}
+			break;
+		case '7':
+			if (mode == 'p'){
+				pointsize = (pointsize < MAX_POINT_SIZE) ? pointsize + 1 : 1;
+			}
+			break;
 		case '9':
 			if ((mode == 'p') && (bBack)){
 				back = cv::Mat::zeros(480 * 2, 640 * 2, CV_8UC3);
@@ -1771,9 +2633,7 @@ void main(void)
 				if (angle_x >= 360){
 					angle_x -= 360;
 				}
-				if (ChangeAttribute(tof, 0, 0, height * -1, angle_x, angle_y, angle_z) == false){
-					std::cout << "TOF ID " << tof.tofinfo.tofid << " Set Camera Attributee Error" << endl;
-				}
+				bAttribute = true;
 				break;
 			case 's':
 				dy -= 100 * zoom;
@@ -1783,9 +2643,7 @@ void main(void)
 				break;
 			case 'h':
 				height += 100;
-				if (ChangeAttribute(tof, 0, 0, height * -1, angle_x, angle_y, angle_z) == false){
-					std::cout << "TOF ID " << tof.tofinfo.tofid << " Set Camera Attributee Error" << endl;
-				}
+				bAttribute = true;
 				break;
 			case 'b':
 				if (bBoxShift){
@@ -1822,9 +2680,7 @@ void main(void)
 				if (angle_x < 0){
 					angle_x += 360;
 				}
-				if (ChangeAttribute(tof, 0, 0, height * -1, angle_x, angle_y, angle_z) == false){
-					std::cout << "TOF ID " << tof.tofinfo.tofid << " Set Camera Attributee Error" << endl;
-				}
+				bAttribute = true;
 				break;
 			case 's':
 				dy += 100 * zoom;
@@ -1834,9 +2690,7 @@ void main(void)
 				break;
 			case 'h':
 				height -= 100;
-				if (ChangeAttribute(tof, 0, 0, height * -1, angle_x, angle_y, angle_z) == false){
-					std::cout << "TOF ID " << tof.tofinfo.tofid << " Set Camera Attributee Error" << endl;
-				}
+				bAttribute = true;
 				break;
 			case 'b':
 				if (bBoxShift){
@@ -1867,9 +2721,7 @@ void main(void)
 				if (angle_z >= 360){
 					angle_z -= 360;
 				}
-				if (ChangeAttribute(tof, 0, 0, height * -1, angle_x, angle_y, angle_z) == false){
-					std::cout << "TOF ID " << tof.tofinfo.tofid << " Set Camera Attributee Error" << endl;
-				}
+				bAttribute = true;
 				break;
 			case 's':
 				dx += 100 * zoom;
@@ -1903,9 +2755,7 @@ void main(void)
 				if (angle_z < 0){
 					angle_z += 360;
 				}
-				if (ChangeAttribute(tof, 0, 0, height * -1, angle_x, angle_y, angle_z) == false){
-					std::cout << "TOF ID " << tof.tofinfo.tofid << " Set Camera Attributee Error" << endl;
-				}
+				bAttribute = true;
 				break;
 			case 's':
 				dx -= 100 * zoom;
@@ -1960,23 +2810,51 @@ void main(void)
 		}
 	}
 
+	// [解決] Stop threads
+	// 停止 擷取 與 處理 執行緒
+	brun = false;
+	if (!bHeadless){
+		acquirethread.join();
+		processthread.join();
+
+		PipelineStat acquirestat = acquirering.Stat();
+		PipelineStat renderstat = renderring.Stat();
+		StatusOut() << "Acquired " << acquirestat.published << " frames, dropped " << acquirestat.dropped
+			<< " frames (max queue " << acquirestat.maxdepth << ")" << endl;
+		StatusOut() << "Rendered " << renderstat.published << " frames, skipped " << renderstat.dropped
+			<< " frames (max queue " << renderstat.maxdepth << ")" << endl;
+		PrintZoneCounts();
+	}
+
+	metricsserver.Stop();
+	PrintTelemetry();
+
+	// [解決] Write remaining count events and close journal
+	// 寫入剩餘的 計數事件 並關閉 記錄檔
+	journal.Close();
+	PipelineStat journalstat = journal.Stat();
+	StatusOut() << "Journal " << journal.Written() << " events, dropped " << journalstat.dropped
+		<< " events, " << journal.Errors() << " errors (" << journalbase << ")" << endl;
+
 	// [解決] Stop and closr TOF sensor
 	// 停止 與 關閉 ToF 設備
 	// 關閉 OpenCV 繪製的視窗
 	bool berror = false;
 	if (tof.Stop() != Result::OK){
-		std::cout << "TOF ID " << tof.tofinfo.tofid << " Stop Error" << endl;
+		StatusOut() << "TOF ID " << tof.tofinfo.tofid << " Stop Error" << endl;
 		berror = true;
 	}
 
 	Sleep(2000);
 
 	if (tof.Close() != Result::OK){
-		std::cout << "TOF ID " << tof.tofinfo.tofid << " Close Error" << endl;
+		StatusOut() << "TOF ID " << tof.tofinfo.tofid << " Close Error" << endl;
 		berror = true;
 	}
 
-	cv::destroyAllWindows();
+	if (!bHeadless){
+		cv::destroyAllWindows();
+	}
 
 	if (berror){
 		system("pause");
@@ -1985,7 +2863,7 @@ void main(void)
 	// [解決] Save ini file
 	// 對於畫布擷取，進行畫面存檔
 	if (SaveIniFile() == false){
-		std::cout << "Ini File Write Error" << endl;
+		StatusOut() << "Ini File Write Error" << endl;
 		system("pause");
 	}
 }
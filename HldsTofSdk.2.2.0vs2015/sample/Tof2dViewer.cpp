@@ -3,7 +3,7 @@
 * @brief		Sample program for Hitachi-LG Data Storage (HLDS)'s TOF Motion Sensor
 * @author		Hitachi-LG Data Storage, Inc. (HLDS)
 * @date			2018.02.07
-* @version		v1.2.0
+* @version		v1.6.1
 * @copyright	Hitachi-LG Data Storage,Inc.
 *
 * @par Change History:
@@ -16,6 +16,17 @@
 *					- Add mouse point function
 * - 2018.02.07 v1.2.0
 *					- Add close window function
+* - 2026.10.16 v1.3.0
+*					- Reuse picture buffer of each TOF sensor
+*					- Show dropped frames and latency of each TOF sensor
+* - 2026.10.16 v1.4.0
+*					- Colorize by packed color table (one lookup per pixel)
+* - 2026.10.16 v1.5.0
+*					- Add color quality/speed setting (quantized color table)
+* - 2026.10.16 v1.6.0
+*					- Colorize and mirror in one pass, directly into the tile if the size is the same
+* - 2026.10.16 v1.6.1
+*					- Remove color quality/speed setting (the quantized color table was not faster)
 */
 
 #include <stdio.h>
@@ -24,6 +35,13 @@
 #include <Windows.h>
 
 #include "tof.h""
+#ifdef _DEBUG
+#define TOF_COUNT_ALLOCATIONS	// Count allocations (to check no allocation in a frame)
+#endif
+//#define TILE_NEAREST			// Scale frames into tiles in the colorize pass by nearest neighbour (no cv::resize)
+#include "TofFramePool.h"
+#include "TofFrameTelemetry.h"
+#include "TofColorizer.h"
 
 #include "opencv2\opencv.hpp"
 //#include <opencv2/opencv.hpp>
@@ -159,10 +177,19 @@ void main(void)
 	// Create instances for reading frames
 	FrameDepth * frame = new FrameDepth[numoftof];
 
+	// Picture of each TOF sensor (buffer is reused every frame)
+	MatPool subpool(numoftof);
+#ifdef _DEBUG
+	AllocationCheck alloccheck;
+#endif
+
 	// Set color information in each frame
+	// (Packed color table is the same for all TOF sensors)
+	ColorLut colorlut;
 	for (int tofno = 0; tofno < numoftof; tofno++){
 		if (tofenable[tofno] == true){
 			frame[tofno].CreateColorTable(0, 65530);
+			colorlut.Build(frame[tofno].ColorTable);
 		}
 	}
 
@@ -178,6 +205,15 @@ void main(void)
 		timer[tofno].framecount = -1;
 	}
 
+	// For dropped frames and latency from read to display (statistics are updated every 1 sec.)
+	FrameTelemetry * telemetry = new FrameTelemetry[numoftof];
+	FrameStamp * stamp = new FrameStamp[numoftof];
+	TelemetryStat * telemetrystat = new TelemetryStat[numoftof];
+	for (int tofno = 0; tofno < numoftof; tofno++){
+		memset(&stamp[tofno], 0, sizeof(FrameStamp));
+		telemetrystat[tofno] = telemetry[tofno].Stat();
+	}
+
 	// Flags for display modes
 	bool isFlip = false;		// Default off
 	bool isGraph = false;		// Default off
@@ -215,6 +251,9 @@ void main(void)
 
 			// Loop for each TOF sensor
 			for (int tofno = 0; tofno < numoftof; tofno++){
+#ifdef _DEBUG
+				alloccheck.Begin();
+#endif
 
 				if (tofenable[tofno] == true){
 
@@ -232,6 +271,7 @@ void main(void)
 							berror = true;
 							break;
 						}
+						telemetry[tofno].Read(frame[tofno].framenumber, stamp[tofno]);
 
 						// Measure FPS(every 1 sec.)
 						if (timer[tofno].framecount != -1){
@@ -240,6 +280,7 @@ void main(void)
 							if (diff / CLOCKS_PER_SEC >= 1){
 								timer[tofno].fps = (float)timer[tofno].framecount * CLOCKS_PER_SEC / (float)diff;
 								timer[tofno].framecount = -1;
+								telemetrystat[tofno] = telemetry[tofno].Stat();
 							}
 						}
 						if (timer[tofno].framecount == -1){
@@ -251,39 +292,35 @@ void main(void)
 						memcpy(&ts[tofno], &frame[tofno].timestamp, sizeof(TimeStamp));
 					}
 
-					// Create color picture
-					std::vector<unsigned char> buf;
-					buf.resize(frame[tofno].width * frame[tofno].height * COLOR_CH_NUM);
-
-					if (isFlip == false){
-						// Reverse(Mirror) mode
-						for (int i = 0; i < frame[tofno].height; i++){
-							for (int j = 0; j < frame[tofno].width; j++){
-								for (int ch = 0; ch < COLOR_CH_NUM; ch++){
-									buf[(i * frame[tofno].width + j)*COLOR_CH_NUM + ch] = frame[tofno].ColorTable[ch][frame[tofno].databuf[i * frame[tofno].width + (frame[tofno].width - j - 1)]];
-								}
-							}
-						}
-					}
-					else{
-						// Normal(Camera view) mode
-						for (int i = 0; i < frame[tofno].width * frame[tofno].height; i++){
-							for (int ch = 0; ch < COLOR_CH_NUM; ch++){
-								buf[i * COLOR_CH_NUM + ch] = frame[tofno].ColorTable[ch][frame[tofno].databuf[i]];
-							}
-						}
-					}
-
-					// Make OpenCV matrix (8bits 3 colors) from depth data
-					cv::Mat sub(frame[tofno].height, frame[tofno].width, CV_8UC3, &buf[0]);
-
 					// Set ROI to the position in multi display
 					int col = tofno % screen_col;
 					int row = tofno / screen_row;
 					cv::Mat roi = screen(cv::Rect(col * sub_width, row * sub_height, sub_width, sub_height));
 
-					// Copy and adjust size the matrix of depth data to ROI(display position)
-					cv::resize(sub, roi, roi.size(), cv::INTER_LINEAR);
+					// Create color picture (Reverse(Mirror) mode if isFlip is false, colorize and mirror in one pass)
+#ifdef TILE_NEAREST
+					bool isDirect = true;
+#else
+					bool isDirect = (frame[tofno].width == sub_width) && (frame[tofno].height == sub_height);
+#endif
+					if (isDirect){
+						// Directly into ROI(display position)
+						colorlut.ColorizeImage(&frame[tofno].databuf[0], frame[tofno].width, frame[tofno].height, !isFlip,
+							roi.data, roi.step, sub_width, sub_height);
+					}
+					else{
+						cv::Mat& sub = subpool.Get(tofno, frame[tofno].height, frame[tofno].width, CV_8UC3);
+						colorlut.ColorizeImage(&frame[tofno].databuf[0], frame[tofno].width, frame[tofno].height, !isFlip,
+							sub.data, sub.step, frame[tofno].width, frame[tofno].height);
+
+						// Copy and adjust size the matrix of depth data to ROI(display position)
+						cv::resize(sub, roi, roi.size(), cv::INTER_LINEAR);
+					}
+#ifdef _DEBUG
+					if (alloccheck.End() != 0){
+						std::cout << "TOF ID " << tof[tofno].tofinfo.tofid << " allocated memory in a frame" << endl;
+					}
+#endif
 
 					string text;
 
@@ -301,12 +338,19 @@ void main(void)
 						text = std::to_string(timer[tofno].fps) + "fps  " + std::to_string(ts[tofno].month) + "/" + std::to_string(ts[tofno].day) + " "
 							+ std::to_string(ts[tofno].hour) + ":" + std::to_string(ts[tofno].minute) + ":" + std::to_string(ts[tofno].second) + "." + std::to_string(ts[tofno].msecond);
 						cv::putText(roi, text, cv::Point(30, 70), cv::FONT_HERSHEY_TRIPLEX, 0.7, cv::Scalar(255, 0, 0), 1.2, CV_AA);
+
+						// Display dropped frames and latency(p50/p99/p999) from read to display
+						char latency[64];
+						sprintf(latency, "%.1f/%.1f/%.1f", telemetrystat[tofno].output.p50 / 1000000.0,
+							telemetrystat[tofno].output.p99 / 1000000.0, telemetrystat[tofno].output.p999 / 1000000.0);
+						text = "drop " + std::to_string(telemetrystat[tofno].dropped) + "  latency " + latency + "ms";
+						cv::putText(roi, text, cv::Point(30, 100), cv::FONT_HERSHEY_TRIPLEX, 0.7, cv::Scalar(255, 0, 0), 1.2, CV_AA);
 					}
 				}
 				else{
 					// Create gray picture
-					std::vector<unsigned char> buf;
-					buf.resize(frame[tofno].width * frame[tofno].height * COLOR_CH_NUM);
+					cv::Mat& sub = subpool.Get(tofno, frame[tofno].height, frame[tofno].width, CV_8UC3);
+					unsigned char* buf = sub.data;
 
 					for (int i = 0; i < frame[tofno].width * frame[tofno].height; i++){
 						for (int ch = 0; ch < COLOR_CH_NUM; ch++){
@@ -314,9 +358,6 @@ void main(void)
 						}
 					}
 
-					// Make OpenCV matrix(8 bits 3 colors)
-					cv::Mat sub(frame[tofno].height, frame[tofno].width, CV_8UC3, &buf[0]);
-
 					// Set ROI to the position in multi display
 					int col = tofno % screen_col;
 					int row = tofno / screen_row;
@@ -324,6 +365,11 @@ void main(void)
 
 					// Copy and adjust size the matrix of depth data to ROI(display position)
 					cv::resize(sub, roi, roi.size(), cv::INTER_LINEAR);
+#ifdef _DEBUG
+					if (alloccheck.End() != 0){
+						std::cout << "TOF ID " << tof[tofno].tofinfo.tofid << " allocated memory in a frame" << endl;
+					}
+#endif
 
 					string text;
 
@@ -454,6 +500,13 @@ void main(void)
 			else{
 				// Display after all multi display are ready
 				cv::imshow("TOF 2D Viewer", screen);
+
+				// Latency of frames read after the last display
+				for (int tofno = 0; tofno < numoftof; tofno++){
+					if ((stamp[tofno].read != 0) && (stamp[tofno].output == 0)){
+						telemetry[tofno].Output(stamp[tofno]);
+					}
+				}
 			}
 
 			// Quit if q key is pushed
@@ -513,12 +566,19 @@ void main(void)
 	}
 
 	delete[] timer;
+	delete[] telemetry;
+	delete[] stamp;
+	delete[] telemetrystat;
 	delete[] frame;
 	delete[] tof;
 	delete[] tofenable;
 	delete[] graph;
 	cv::destroyAllWindows();
 
+#ifdef _DEBUG
+	std::cout << alloccheck.badframes << " of " << alloccheck.frames << " frames allocated memory" << endl;
+#endif
+
 	if (berror){
 		system("pause");
 	}
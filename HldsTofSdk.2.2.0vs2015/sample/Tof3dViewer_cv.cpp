@@ -3,7 +3,7 @@
 * @brief		Sample program for Hitachi-LG Data Storage (HLDS)'s TOF Motion Sensor
 * @author		Hitachi-LG Data Storage, Inc. (HLDS)
 * @date			2018.02.13
-* @version		v1.1.0
+* @version		v1.5.1
 * @copyright	Hitachi-LG Data Storage,Inc.
 *
 * @par Change History:
@@ -16,6 +16,16 @@
 *					- Correct x,y range of frame3d
 * - 2018.02.13 v1.1.0
 *					- Add close window function
+* - 2026.10.16 v1.2.0
+*					- Colorize by packed color table (one lookup per pixel)
+* - 2026.10.16 v1.3.0
+*					- Add color quality/speed setting (quantized color table)
+* - 2026.10.16 v1.4.0
+*					- Rotate and project each point once (rotation matrix once per frame, multithreaded)
+* - 2026.10.16 v1.5.0
+*					- Z-buffer of fixed-point Z without wrap of negative Z, add zoom and point size (square/disk)
+* - 2026.10.16 v1.5.1
+*					- Remove color quality/speed setting (the quantized color table was not faster)
 */
 
 #define _CRT_SECURE_NO_WARNINGS
@@ -25,6 +35,8 @@
 #include <fstream>
 
 #include "tof.h"
+#include "TofColorizer.h"
+#include "TofCloudView.h"
 
 using namespace std;
 using namespace hlds;
@@ -34,6 +46,7 @@ using namespace hlds;
 
 #define DISPLAY_WIDTH		(640)		//Width of Main Display
 #define DISPLAY_HEIGHT		(480)		//Height of Main Display
+#define DISPLAY_SCALE		(0.1f)		//Initial zoom (pixels per mm)
 
 void main(void)
 {
@@ -115,6 +128,10 @@ void main(void)
 	// Make color table
 	frame.CreateColorTable(0, 65530);
 
+	// Packed color table (one lookup per pixel)
+	ColorLut colorlut;
+	colorlut.Build(frame.ColorTable);
+
 	bool berror = false;
 
 	try {
@@ -122,8 +139,8 @@ void main(void)
 		// Create windows for display as resizable
 		cv::namedWindow("TOF 3D Viewer with OpenCV", CV_WINDOW_NORMAL);
 
-		// Z buffer (to recognize front/back position)
-		cv::Mat z_buffer(DISPLAY_HEIGHT, DISPLAY_WIDTH, CV_16UC1);
+		// Rotated view (Z buffer of each thread to recognize front/back position)
+		CloudView cloudview(DISPLAY_WIDTH, DISPLAY_HEIGHT);
 
 		// Display image
 		cv::Mat img(DISPLAY_HEIGHT, DISPLAY_WIDTH, CV_8UC3);
@@ -138,6 +155,9 @@ void main(void)
 		float max_depth = 2000;	// Max distance between sensor(mm)
 		float min_z = -1000;	// Min Z distance level on display(mm)	
 		float max_z = 1000;		// Max Z distance level on display(mm)
+		float scale = DISPLAY_SCALE;	// Zoom (pixels per mm)
+		int splat = 1;			// Size of a point (pixels)
+		bool bdisk = false;		// Point is a disk (false: square)
 
 		bool brun = true;
 		while (brun){
@@ -160,72 +180,21 @@ void main(void)
 				// Convert to 3D(with lens correction)
 				frame3d.Convert(&frame);
 
-				// Initialize matrix
-				z_buffer = cv::Mat::zeros(DISPLAY_HEIGHT, DISPLAY_WIDTH, CV_16UC1);
-				img = cv::Mat::zeros(DISPLAY_HEIGHT, DISPLAY_WIDTH, CV_8UC3);
-
-				for (int y = 0; y < DISPLAY_HEIGHT; y++){
-					for (int x = 0; x < DISPLAY_WIDTH; x++){
-
-						int tofx = x * frame3d.width / DISPLAY_WIDTH;
-						int tofy = y * frame3d.height / DISPLAY_HEIGHT;
-
-						if ((frame3d.frame3d[tofy * frame3d.width + tofx].z >= min_depth) && (frame3d.frame3d[tofy * frame3d.width + tofx].z <= max_depth)){
-							// Valid data(Only data is valid that distance between sensor is shorter than specific length)
-
-							cv::Point3f point0;	// Coordinate before rotate
-							cv::Point3f point;	// Coordinate after rotate
-
-							// Get a point after 3D conversion
-							point0.x = frame3d.frame3d[tofy * frame3d.width + tofx].x;
-							point0.y = frame3d.frame3d[tofy * frame3d.width + tofx].y;
-							point0.z = frame3d.frame3d[tofy * frame3d.width + tofx].z;
-
-							// Rote X-axis
-							point.x = point0.x;
-							point.y = point0.y * cos(deg2rad(angle_x)) - point0.z * sin(deg2rad(angle_x));
-							point.z = point0.y * sin(deg2rad(angle_x)) + point0.z * cos(deg2rad(angle_x));
-
-							point0 = point;
-
-							// Rote Y-axis
-							point.x = point0.x * cos(deg2rad(angle_y)) + point0.z * sin(deg2rad(angle_y));
-							point.y = point0.y;
-							point.z = -1 * point0.x * sin(deg2rad(angle_y)) + point0.z * cos(deg2rad(angle_y));
-
-							// X/Y direction shift on display
-							point.x = point.x + dx;
-							point.y = point.y + dy;
-
-							// Adjust X/Y origin to center of display
-							point.x = point.x / 10 + DISPLAY_WIDTH / 2;
-							point.y = point.y / 10 + DISPLAY_HEIGHT / 2;
-
-							if ((point.x >= 0) && (point.x < DISPLAY_WIDTH) &&
-								(point.y >= 0) && (point.y < DISPLAY_HEIGHT)){
-
-								if ((point.z >= min_z) && (point.z <= max_z)){
-									// Within Z scope(the scope can be changed by h/l key)
-
-									if ((z_buffer.at<unsigned short>(point.y, point.x) == 0) ||
-										(z_buffer.at<unsigned short>(point.y, point.x) > point.z)){
-										// The point is more front than Z buffer point
-
-										// Register to Z buffer
-										z_buffer.at<unsigned short>(point.y, point.x) = point.z;
-
-										// Register color to display(x,y of coordinate is corresponded to 640 x 480 = 640mm x 480mm)
-										cv::Vec3b v;
-										v.val[0] = frame.ColorTable[0][frame.databuf[tofy * frame.width + tofx]];
-										v.val[1] = frame.ColorTable[1][frame.databuf[tofy * frame.width + tofx]];
-										v.val[2] = frame.ColorTable[2][frame.databuf[tofy * frame.width + tofx]];
-										img.at<cv::Vec3b>(point.y, point.x) = v;
-									}
-								}
-							}
-						}
-					}
-				}
+				// Rotate each point once and register to the display(x,y of coordinate is corresponded to 640 x 480 = 640mm x 480mm)
+				// (Only data is valid that distance between sensor is within min/max_depth and Z is within min/max_z)
+				CloudViewParam param;
+				param.angle_x = angle_x;
+				param.angle_y = angle_y;
+				param.dx = dx;
+				param.dy = dy;
+				param.min_depth = min_depth;
+				param.max_depth = max_depth;
+				param.min_z = min_z;
+				param.max_z = max_z;
+				param.scale = scale;
+				param.splat = splat;
+				param.bdisk = bdisk;
+				cloudview.Render(param, &frame3d.frame3d[0], &frame.databuf[0], frame3d.width, frame3d.height, colorlut, img.data, img.step);
 
 				// Display information
 				string text = "q key : Quit, x key : Move, r key :Reset";
@@ -234,6 +203,8 @@ void main(void)
 				cv::putText(img, text, cv::Point(30, 50), cv::FONT_HERSHEY_TRIPLEX, 0.4, cv::Scalar(255, 255, 255), 1.5, CV_AA);
 				text = "h/l key : Filter High=" + std::to_string((int)max_z) + "[mm] Low=" + std::to_string((int)min_z) + "[mm]";
 				cv::putText(img, text, cv::Point(30, 70), cv::FONT_HERSHEY_TRIPLEX, 0.4, cv::Scalar(255, 255, 255), 1.5, CV_AA);
+				text = "z key : Zoom=" + std::to_string((int)(scale * 1000 + 0.5f)) + "[pixels/m], s/d key : Point=" + std::to_string(splat) + "[pixels] " + (bdisk ? "Disk" : "Square");
+				cv::putText(img, text, cv::Point(30, 90), cv::FONT_HERSHEY_TRIPLEX, 0.4, cv::Scalar(255, 255, 255), 1.5, CV_AA);
 
 				if (NULL == cvGetWindowHandle("TOF 3D Viewer with OpenCV")){
 					brun = false;
@@ -257,6 +228,16 @@ void main(void)
 			case 'l':
 				mode = 'l';
 				break;
+			case 'z':
+				mode = 'z';
+				break;
+			case 's':
+				//Size of a point (fills holes between points when zoomed in)
+				splat = (splat < RASTER_MAX_SPLAT) ? splat + 1 : 1;
+				break;
+			case 'd':
+				bdisk = !bdisk;
+				break;
 			case 'r':
 				angle_x = 0;
 				angle_y = 0;
@@ -264,6 +245,9 @@ void main(void)
 				dx = 0;
 				max_z = 1000;
 				min_z = -1000;
+				scale = DISPLAY_SCALE;
+				splat = 1;
+				bdisk = false;
 				break;
 			case 2490368:	//
 				switch (mode){
@@ -279,6 +263,9 @@ void main(void)
 				case 'l':
 					min_z += 10;
 					break;
+				case 'z':
+					scale *= 1.25f;
+					break;
 				}
 				break;
 			case 2621440:	//
@@ -295,6 +282,9 @@ void main(void)
 				case 'l':
 					min_z -= 10;
 					break;
+				case 'z':
+					scale /= 1.25f;
+					break;
 				}
 				break;
 			case 2555904:	//
@@ -0,0 +1,1968 @@
+/**
+* @file			TofBenchmark.cpp
+* @brief		Benchmark program for the per-pixel kernels of the TOF samples
+* @date			2026.10.16
+* @version		v1.0.1
+*
+* @par Change History:
+* - 2026.10.16 New
+*					- Top view projection of HumanCounter (current loop / fused kernel)
+*					- 3D conversion (lens model per pixel / ray table)
+*					- 3D conversion and rotation (conversion + RotateZYX / rotation folded into the ray table)
+*					- Distance gate (CalculateLength per pixel / DepthGate)
+*					- Z-buffer of top view (memset of float [x][y] / epoch stamped ZBuffer)
+*					- CatchHumans of HumanCounter (nested loop / HumanStore) at 10, 100, 1000 humans
+*					- Count area test of HumanCounter (array of structs / arrays of HumanStore)
+*					- Count zones (all zones for each human / uniform grid) at 10, 100, 1000 zones
+*					- Tripwires (test of each segment with branches / CrossSegments) at 1, 10, 100 tripwires
+*					- Current loops of the viewers at every CameraPixel (side/front view of HumanCounter,
+*					  colorize of Tof2dViewer, compositing of Tofv2Viewer, 16 bit copy of TofIrViewer,
+*					  rotation and projection of Tof3dViewer_cv) as the base of later optimization
+*					- Frames of TofEmulator (depth + IR as fast as read)
+*					- Colorize by packed color table (ColorLut, scalar / Colorize())
+*					- Colorize by quantized color table (speed mode of ColorLut) at 8, 10, 12, 14 bits
+*					  with the color error from the full table
+*					- Compositing of Tofv2Viewer by colorize at the resolution of the sensor and nearest neighbour
+*					  enlargement (index maps, same mapping as cv::resize() INTER_NEAREST)
+*					- Colorize and mirror in one pass (ColorizeMirror()) and into a 640x480 tile (ColorizeImage())
+*					- Rotation and projection of Tof3dViewer_cv by each point once (CloudView, 1 thread / CLOUD_VIEW_THREADS)
+*					- Learning of the ray table with dropout pixels (never valid at the edges, as a real sensor)
+*					- Splats of the rasterizer (TofRasterizer.h, square 1 to 3, disk 5, 2x2 by atomic minimum),
+*					  2x2 points on the top view, side/front view by depth buffers, 2x2 and disk points of CloudView
+* - 2026.10.16 v1.0.1
+*					- Color table of the SDK (CreateColorTable(0, 65530), same gradient as tof14.dll)
+*					- Quantized color table with depth over 0x0000 to 0xfffe (all buckets and the invalid index)
+*					- Count area (arrays) by AreaStates() and check of the states and changed humans in every frame
+*
+* @remarks
+*	- Works with synthetic frames. TOF sensor, SDK DLL, Windows and OpenCV are not necessary.
+*	- Build example (Linux):  g++ -O2 -mavx2 -std=c++11 TofBenchmark.cpp -o TofBenchmark
+*	- Build example (Windows): cl /O2 /arch:AVX2 /EHsc TofBenchmark.cpp
+*	- Count area of arrays is tested by AreaStates() (TofCountZone.h, AVX2/SSE2 intrinsics).
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "tof.h"
+#include "TofProjection.h"
+#include "TofRayTable.h"
+#include "TofDepthGate.h"
+#include "TofZBuffer.h"
+#include "TofHumanStore.h"
+#include "TofCountZone.h"
+#include "TofTripwire.h"
+#include "TofEmulator.h"
+#include "TofColorizer.h"
+#include "TofCloudView.h"
+#include "TofRasterizer.h"
+
+using namespace std;
+using namespace hlds;
+
+#define TOPVIEW_WIDTH		(640 * 2)		//Width of top view of HumanCounter
+#define TOPVIEW_HEIGHT		(480 * 2)		//Height of top view of HumanCounter
+#define SUB_DISPLAY_WIDTH	(320)			//Width of sub display of HumanCounter
+#define SUB_DISPLAY_HEIGHT	(240)			//Height of sub display of HumanCounter
+
+#define SENSOR_HEIGHT		(2500.0f)		//Height of synthetic sensor from floor [mm]
+
+//Size of each CameraPixel
+struct {
+	CameraPixel pixel;
+	int width;
+	int height;
+	const char* name;
+} Resolution[] = {
+	{ CameraPixel::w640h480, 640, 480, "640x480" },
+	{ CameraPixel::w320h240, 320, 240, "320x240" },
+	{ CameraPixel::w160h120, 160, 120, "160x120" },
+	{ CameraPixel::w80h60, 80, 60, "80x60" },
+	{ CameraPixel::w64h48, 64, 48, "64x48" },
+	{ CameraPixel::w40h30, 40, 30, "40x30" },
+	{ CameraPixel::w32h24, 32, 24, "32x24" },
+};
+
+//Synthetic frame
+struct Scene {
+	int width;
+	int height;
+	float distance_min;					//distance_min of depth frame
+	float distance_max;					//distance_max of depth frame
+	vector<unsigned short> depth;		//Depth data
+	vector<TofPoint> points;			//3D points after rotation to top view
+	FrameHumans humans;					//Detection range
+};
+
+//Color table (same as FrameDepth::ColorTable of the samples)
+unsigned char ColorTable[COLOR_CH_NUM][MAX_INT16 + 1];
+ColorLut Lut;
+
+//Same as FrameDepth::CreateColorTable() (tof14.dll Ver.2.2.0)
+//White below scaleMin, red -> yellow -> green -> cyan -> blue over the range, black above (and 0xffff)
+void CreateColorTable(unsigned short scaleMin, unsigned short scaleRange)
+{
+	if (scaleMin + scaleRange > MAX_INT16){
+		scaleRange = MAX_INT16 - scaleMin;
+	}
+	for (int i = 0; i <= MAX_INT16; i++){
+		unsigned char b = 0;
+		unsigned char g = 0;
+		unsigned char r = 0;
+		if (i < scaleMin){
+			b = g = r = 255;
+		}
+		else if (i < scaleMin + scaleRange){
+			int v = (int)((i - scaleMin) * 255.0 / (scaleRange * 0.25));
+			if (v < 255){
+				g = (unsigned char)v;
+				r = 255;
+			}
+			else if (v < 510){
+				g = 255;
+				r = (unsigned char)(254 - v);
+			}
+			else if (v < 765){
+				b = (unsigned char)(v + 2);
+				g = 255;
+			}
+			else if (v < 1020){
+				b = 255;
+				g = (unsigned char)(252 - v);
+			}
+		}
+		ColorTable[0][i] = b;
+		ColorTable[1][i] = g;
+		ColorTable[2][i] = r;
+	}
+	Lut.Build(ColorTable);
+}
+
+//Make a frame looking down at the floor with some box shaped humans
+void MakeScene(Scene& scene, int width, int height, unsigned int seed)
+{
+	scene.width = width;
+	scene.height = height;
+	scene.distance_min = 0;
+	scene.distance_max = 12000;
+	scene.depth.resize(width * height);
+	scene.points.resize(width * height);
+	scene.humans.distance_min = 500;
+	scene.humans.distance_max = 6000;
+	scene.humans.z_min = 0;
+	scene.humans.z_max = 3000;
+
+	srand(seed);
+	float fov = 4000.0f;	//Width of the floor seen at the edge [mm]
+	for (int y = 0; y < height; y++){
+		for (int x = 0; x < width; x++){
+			int i = y * width + x;
+			float fx = ((float)x / width - 0.5f) * fov;
+			float fy = ((float)y / height - 0.5f) * fov * 0.75f - 1500.0f;
+			float z = SENSOR_HEIGHT;
+
+			//Humans (1700mm) on a grid
+			if ((((x * 8) / width) % 3 == 1) && (((y * 6) / height) % 2 == 1)){
+				z = SENSOR_HEIGHT - 1700.0f;
+			}
+			z += (float)(rand() % 41 - 20);
+
+			scene.points[i].x = fx;
+			scene.points[i].y = fy;
+			scene.points[i].z = z;
+
+			float length = sqrt(fx * fx + (fy + 1500.0f) * (fy + 1500.0f) + z * z);
+			if (rand() % 50 == 0){
+				//Invalid data
+				scene.depth[i] = MAX_INT16;
+			}
+			else {
+				scene.depth[i] = (unsigned short)((length - scene.distance_min) * (MAX_INT16 - 1) / (scene.distance_max - scene.distance_min));
+			}
+		}
+	}
+}
+
+//Same as FrameDepth::CalculateLength()
+float CalculateLength(const Scene& scene, unsigned short depth)
+{
+	if (depth == MAX_INT16){
+		return -1;
+	}
+	return scene.distance_min + depth * ((scene.distance_max - scene.distance_min) / (float)(MAX_INT16 - 1));
+}
+
+//Output of a projection
+struct TopView {
+	vector<unsigned char> img;
+	vector<unsigned char> sub;
+	vector<float> zbuf;					//float z_buffer[x][y] of HumanCounter.cpp(Ver.2.2.0)
+	ZBuffer zbuffer;
+	vector<TofPoint> points;
+
+	TopView() : zbuffer(TOPVIEW_WIDTH, TOPVIEW_HEIGHT){
+		img.resize(TOPVIEW_WIDTH * TOPVIEW_HEIGHT * 3);
+		sub.resize(SUB_DISPLAY_WIDTH * SUB_DISPLAY_HEIGHT * 3);
+		zbuf.resize(TOPVIEW_WIDTH * TOPVIEW_HEIGHT);
+	}
+	//Images are cleared every frame in HumanCounter.cpp also
+	void ClearImage(void){
+		memset(&img[0], 0, img.size());
+		memset(&sub[0], 0, sub.size());
+	}
+	void ClearCurrent(void){
+		ClearImage();
+		memset(&zbuf[0], 0, zbuf.size() * sizeof(float));
+	}
+	void ClearFused(void){
+		ClearImage();
+		zbuffer.Clear();
+	}
+	void Clear(const Scene& scene){
+		ClearCurrent();
+		zbuffer.Clear();
+		points = scene.points;
+	}
+};
+
+//Per-pixel loop of HumanCounter.cpp(Ver.2.2.0)
+void ProjectCurrent(const Scene& scene, TopView& out)
+{
+	const FrameHumans& framehumans = scene.humans;
+	float zoom = 0.12f;
+	float dx = 600.0f;
+	float dy = 900.0f;
+
+	for (int y = 0; y < scene.height; y++){
+		for (int x = 0; x < scene.width; x++){
+			if ((CalculateLength(scene, scene.depth[y * scene.width + x]) >= framehumans.distance_min) && (CalculateLength(scene, scene.depth[y * scene.width + x]) <= framehumans.distance_max)){
+				TofPoint point;
+				point.x = out.points[y * scene.width + x].x;
+				point.y = out.points[y * scene.width + x].y;
+				point.z = out.points[y * scene.width + x].z;
+				point.x *= zoom;
+				point.y *= zoom;
+				point.x += dx;
+				point.y += dy;
+				if ((point.x >= 0) && (point.x < TOPVIEW_WIDTH) && (point.y >= 0) && (point.y < TOPVIEW_HEIGHT)){
+					if ((point.z >= framehumans.z_min) && (point.z < framehumans.z_max)){
+						//z_buffer[x][y]
+						float& zb = out.zbuf[(int)point.x * TOPVIEW_HEIGHT + (int)point.y];
+						if ((zb == 0) || (zb > point.z)){
+							zb = point.z;
+							long color = (long)(65530 * (point.z - framehumans.z_min) / ((framehumans.z_max - framehumans.z_min)));
+							unsigned char* d = &out.img[((int)point.y * TOPVIEW_WIDTH + (int)point.x) * 3];
+							d[0] = ColorTable[0][color];
+							d[1] = ColorTable[1][color];
+							d[2] = ColorTable[2][color];
+						}
+						unsigned short raw = scene.depth[y * scene.width + x];
+						unsigned char* d = &out.sub[((y * SUB_DISPLAY_HEIGHT / scene.height) * SUB_DISPLAY_WIDTH + x * SUB_DISPLAY_WIDTH / scene.width) * 3];
+						d[0] = ColorTable[0][raw];
+						d[1] = ColorTable[1][raw];
+						d[2] = ColorTable[2][raw];
+					}
+				}
+			}
+			else {
+				out.points[y * scene.width + x].x = 0;
+				out.points[y * scene.width + x].y = 0;
+				out.points[y * scene.width + x].z = 0;
+			}
+		}
+	}
+}
+
+//Fused kernel (TofProjection.h)
+void ProjectFused(const Scene& scene, TopView& out, bool bscalar, const unsigned int* mask = NULL, const RasterSplat* splat = NULL)
+{
+	TopViewParam p;
+	p.depth = &scene.depth[0];
+	p.depth_min = scene.distance_min;
+	p.depth_max = scene.distance_max;
+	p.colorlut = &Lut;
+	p.mask = mask;
+	p.points = &out.points[0];
+	p.width = scene.width;
+	p.height = scene.height;
+	p.distance_min = scene.humans.distance_min;
+	p.distance_max = scene.humans.distance_max;
+	p.z_min = scene.humans.z_min;
+	p.z_max = scene.humans.z_max;
+	p.zoom = 0.12f;
+	p.dx = 600.0f;
+	p.dy = 900.0f;
+	p.bpoint = true;
+	p.splat = splat;
+	p.img = &out.img[0];
+	p.imgstep = TOPVIEW_WIDTH * 3;
+	p.imgcols = TOPVIEW_WIDTH;
+	p.imgrows = TOPVIEW_HEIGHT;
+	p.zbuffer = &out.zbuffer;
+	p.sub = &out.sub[0];
+	p.substep = SUB_DISPLAY_WIDTH * 3;
+	p.subcols = SUB_DISPLAY_WIDTH;
+	p.subrows = SUB_DISPLAY_HEIGHT;
+
+	if (bscalar){
+		ProjectTopViewScalar(p, 0, p.height);
+	}
+	else {
+		ProjectTopView(p);
+	}
+}
+
+//Count different bytes
+long Compare(const TopView& a, const TopView& b)
+{
+	long diff = 0;
+	for (size_t i = 0; i < a.img.size(); i++){
+		diff += (a.img[i] != b.img[i]);
+	}
+	for (size_t i = 0; i < a.sub.size(); i++){
+		diff += (a.sub[i] != b.sub[i]);
+	}
+	if (memcmp(&a.points[0], &b.points[0], a.points.size() * sizeof(TofPoint)) != 0){
+		diff++;
+	}
+	return diff;
+}
+
+//Run a function for the specified time and return microseconds per call
+template <class Func>
+double Measure(Func func, double seconds)
+{
+	typedef std::chrono::steady_clock clock;
+	long count = 0;
+	clock::time_point start = clock::now();
+	double elapsed = 0;
+	do {
+		func();
+		count++;
+		elapsed = std::chrono::duration<double>(clock::now() - start).count();
+	} while (elapsed < seconds);
+	return elapsed * 1e6 / count;
+}
+
+void Report(const char* name, const char* size, double usec, double baseusec)
+{
+	printf("%-28s %-8s %10.1f us/frame %8.1f fps  x%.2f\n", name, size, usec, 1e6 / usec, baseusec / usec);
+}
+
+void BenchProjection(double seconds)
+{
+	printf("\n[HumanCounter top view projection] (%s)\n", TofSimdName());
+
+	for (size_t r = 0; r < sizeof(Resolution) / sizeof(Resolution[0]); r++){
+		Scene scene;
+		MakeScene(scene, Resolution[r].width, Resolution[r].height, 1);
+
+		TopView current;
+		TopView scalar;
+		TopView fused;
+
+		//Check result
+		current.Clear(scene);
+		ProjectCurrent(scene, current);
+		scalar.Clear(scene);
+		ProjectFused(scene, scalar, true);
+		fused.Clear(scene);
+		ProjectFused(scene, fused, false);
+		long diff = Compare(current, scalar) + Compare(current, fused);
+		DepthGate gate;
+		gate.Build(scene.distance_min, scene.distance_max, scene.humans.distance_min, scene.humans.distance_max);
+		vector<unsigned int> mask((scene.width * scene.height + 31) / 32);
+		gate.Gate(&scene.depth[0], scene.width * scene.height, &mask[0]);
+		scalar.Clear(scene);
+		ProjectFused(scene, scalar, true, &mask[0]);
+		diff += Compare(current, scalar);
+		fused.Clear(scene);
+		ProjectFused(scene, fused, false, &mask[0]);
+		diff += Compare(current, fused);
+		if (diff != 0){
+			printf("%s: result is different from current loop (%ld)\n", Resolution[r].name, diff);
+		}
+
+		//Speed (including the clear of the images and the Z-buffer of every frame)
+		double clear = Measure([&](){ current.ClearImage(); }, seconds);
+		Report("clear images", Resolution[r].name, clear, clear);
+		double base = Measure([&](){ current.ClearCurrent(); ProjectCurrent(scene, current); }, seconds);
+		Report("current loop", Resolution[r].name, base, base);
+		double us = Measure([&](){ scalar.ClearFused(); ProjectFused(scene, scalar, true); }, seconds);
+		Report("fused kernel (scalar)", Resolution[r].name, us, base);
+		us = Measure([&](){ fused.ClearFused(); ProjectFused(scene, fused, false); }, seconds);
+		Report("fused kernel", Resolution[r].name, us, base);
+		us = Measure([&](){ fused.ClearFused(); gate.Gate(&scene.depth[0], scene.width * scene.height, &mask[0]); ProjectFused(scene, fused, false, &mask[0]); }, seconds);
+		Report("depth gate + fused kernel", Resolution[r].name, us, base);
+		RasterSplat splat(2, false);
+		us = Measure([&](){ fused.ClearFused(); ProjectFused(scene, fused, false, NULL, &splat); }, seconds);
+		Report("fused kernel, 2x2 points", Resolution[r].name, us, base);
+	}
+}
+
+//Lens of synthetic sensor
+LensParam MakeLens(void)
+{
+	LensParam lens;
+	memset(&lens, 0, sizeof(lens));
+	lens.focallength = 2.8;
+	lens.fov_x = 90;
+	lens.fov_y = 70;
+	lens.ellipticity = 1;
+	lens.distortion[0] = -0.12;		//k1
+	lens.distortion[1] = 0.03;		//k2
+	lens.distortion[2] = 0.001;		//p1
+	lens.distortion[3] = -0.0005;	//p2
+	return lens;
+}
+
+//Depth frame of a scene
+void MakeDepthFrame(const Scene& scene, FrameDepth& frame)
+{
+	frame.width = scene.width;
+	frame.height = scene.height;
+	frame.pixel = scene.width * scene.height;
+	frame.distance_min = scene.distance_min;
+	frame.distance_max = scene.distance_max;
+	frame.lens = MakeLens();
+	frame.databuf = scene.depth;
+}
+
+//Lens correction calculated for every pixel (in place of Frame3d::Convert())
+void ConvertPerPixel(const FrameDepth& frame, vector<TofPoint>& points)
+{
+	points.resize(frame.width * frame.height);
+	float lscale = (frame.distance_max - frame.distance_min) / (float)(MAX_INT16 - 1);
+	for (int y = 0; y < frame.height; y++){
+		for (int x = 0; x < frame.width; x++){
+			int i = y * frame.width + x;
+			TofPoint ray = LensRay(x, y, frame.width, frame.height, frame.lens);
+			float length = (frame.databuf[i] == MAX_INT16) ? 0.0f : frame.distance_min + frame.databuf[i] * lscale;
+			points[i].x = length * ray.x;
+			points[i].y = length * ray.y;
+			points[i].z = length * ray.z;
+		}
+	}
+}
+
+//Maximum difference of coordinate [mm]
+float MaxError(const vector<TofPoint>& a, const vector<TofPoint>& b)
+{
+	float err = 0;
+	for (size_t i = 0; i < a.size(); i++){
+		err = max(err, fabs(a[i].x - b[i].x));
+		err = max(err, fabs(a[i].y - b[i].y));
+		err = max(err, fabs(a[i].z - b[i].z));
+	}
+	return err;
+}
+
+void BenchConvert(double seconds)
+{
+	printf("\n[3D conversion]\n");
+
+	for (size_t r = 0; r < sizeof(Resolution) / sizeof(Resolution[0]); r++){
+		Scene scene;
+		MakeScene(scene, Resolution[r].width, Resolution[r].height, 1);
+		FrameDepth frame;
+		MakeDepthFrame(scene, frame);
+
+		vector<TofPoint> reference;
+		vector<TofPoint> points;
+		ConvertPerPixel(frame, reference);
+
+		//Table from LensParam
+		RayTable table;
+		table.Convert(frame, points);
+		float builderr = MaxError(reference, points);
+
+		//Table learned from the converted frame (first frame has no invalid data at learning)
+		RayTable learned;
+		FrameDepth all = frame;
+		for (size_t i = 0; i < all.databuf.size(); i++){
+			all.databuf[i] = (unsigned short)(i % (MAX_INT16 - 2) + 1);
+		}
+		vector<TofPoint> allpoints;
+		ConvertPerPixel(all, allpoints);
+		int remain = learned.Learn(all, &allpoints[0]);
+		learned.Convert(frame, points);
+		float learnerr = MaxError(reference, points);
+
+		//Dropout pixels (left and right edges never valid): the table is used after RAYTABLE_LEARN_FRAMES frames,
+		//and the pixels are learned when they have valid data
+		RayTable dropout;
+		FrameDepth holes = all;
+		int edge = max(1, frame.width / 20);
+		for (int y = 0; y < holes.height; y++){
+			for (int x = 0; x < holes.width; x++){
+				if ((x < edge) || (x >= holes.width - edge)){
+					holes.databuf[y * holes.width + x] = MAX_INT16;
+				}
+			}
+		}
+		vector<TofPoint> holepoints;
+		ConvertPerPixel(holes, holepoints);
+		int sdkframes = 0;
+		for (int n = 0; n < RAYTABLE_LEARN_FRAMES * 3; n++){
+			if (dropout.NeedLearn(holes)){
+				dropout.Learn(holes, &holepoints[0]);
+				sdkframes++;
+			}
+		}
+		int dropremain = frame.width * frame.height - dropout.numoflearned;
+		int relearnframes = 0;
+		for (int n = 1; (n <= RAYTABLE_LEARN_FRAMES) && (relearnframes == 0); n++){
+			if (dropout.NeedLearn(all)){
+				dropout.Learn(all, &allpoints[0]);
+				relearnframes = n;
+			}
+		}
+		printf("%-8s dropout %d pixels: learned %d frames, then ray table; valid again -> learned after %d frames\n",
+			Resolution[r].name, dropremain, sdkframes, relearnframes);
+		if ((sdkframes != RAYTABLE_LEARN_FRAMES) || !dropout.IsLearned()){
+			printf("%s: learning with dropout pixels failed\n", Resolution[r].name);
+		}
+
+		//Save and load
+		RayTable loaded;
+		bool bsave = learned.Save("raytable.bin") && loaded.Load("raytable.bin") && loaded.IsValid(frame) &&
+			(memcmp(&loaded.rays[0], &learned.rays[0], loaded.rays.size() * sizeof(TofPoint)) == 0);
+		remove("raytable.bin");
+
+		//Invalidation
+		frame.lens.fov_x += 1;
+		bool binvalid = !table.IsValid(frame) && table.Build(frame) && !table.Build(frame);
+		frame.lens.fov_x -= 1;
+		table.Build(frame);
+
+		printf("%-8s max error: LensParam %.6fmm, learned %.6fmm (unlearned %d)%s%s\n", Resolution[r].name, builderr, learnerr, remain,
+			bsave ? "" : ", save/load failed", binvalid ? "" : ", invalidation failed");
+		if (learnerr > 0.01f){
+			printf("%s: learned table is over tolerance (0.01mm)\n", Resolution[r].name);
+		}
+
+		double base = Measure([&](){ ConvertPerPixel(frame, points); }, seconds);
+		Report("lens model per pixel", Resolution[r].name, base, base);
+		double us = Measure([&](){ table.Convert(frame, points); }, seconds);
+		Report("ray table", Resolution[r].name, us, base);
+
+		//Rotation of HumanCounter (angle_x=90) and a pose with all angles
+		const float poses[][6] = { { 0, 0, 0, 90, 0, 0 }, { 100, -200, -2500, 75, 10, 350 } };
+		for (size_t n = 0; n < sizeof(poses) / sizeof(poses[0]); n++){
+			const float* pose = poses[n];
+			vector<TofPoint> rotated;
+			auto twopass = [&](){
+				table.SetPose(0, 0, 0, 0, 0, 0);
+				table.Convert(frame, rotated);
+				RotatePointsZYX(&rotated[0], (int)rotated.size(), pose[3], pose[4], pose[5]);
+				for (size_t i = 0; i < rotated.size(); i++){
+					rotated[i].x += pose[0];
+					rotated[i].y += pose[1];
+					rotated[i].z += pose[2];
+				}
+			};
+			twopass();
+			table.SetPose(pose[0], pose[1], pose[2], pose[3], pose[4], pose[5]);
+			table.Convert(frame, points);
+			float poseerr = MaxError(rotated, points);
+			printf("%-8s pose (%g,%g,%g,%g,%g,%g) max error %.6fmm\n", Resolution[r].name, pose[0], pose[1], pose[2], pose[3], pose[4], pose[5], poseerr);
+			if (poseerr > 0.01f){
+				printf("%s: rotated ray table is over tolerance (0.01mm)\n", Resolution[r].name);
+			}
+
+			base = Measure([&](){ table.Convert(frame, points); RotatePointsZYX(&points[0], (int)points.size(), pose[3], pose[4], pose[5]); }, seconds);
+			Report("convert + RotateZYX", Resolution[r].name, base, base);
+			us = Measure([&](){ table.SetPose(pose[0], pose[1], pose[2], pose[3], pose[4], pose[5]); table.Convert(frame, points); }, seconds);
+			Report("rotation in ray table", Resolution[r].name, us, base);
+			table.SetPose(0, 0, 0, 0, 0, 0);
+		}
+	}
+}
+
+//FrameDepth::CalculateLength() is a DLL call, so it is called through a pointer
+float (*volatile CalculateLengthCall)(const Scene&, unsigned short) = CalculateLength;
+
+//Distance gate of HumanCounter.cpp(Ver.2.2.0) into a packed mask
+void GateCurrent(const Scene& scene, unsigned int* mask)
+{
+	int num = scene.width * scene.height;
+	memset(mask, 0, (num + 31) / 32 * sizeof(unsigned int));
+	for (int i = 0; i < num; i++){
+		if ((CalculateLengthCall(scene, scene.depth[i]) >= scene.humans.distance_min) && (CalculateLengthCall(scene, scene.depth[i]) <= scene.humans.distance_max)){
+			mask[i >> 5] |= 1u << (i & 31);
+		}
+	}
+}
+
+void BenchGate(double seconds)
+{
+	printf("\n[Distance gate] (%s)\n", TofSimdName());
+
+	for (size_t r = 0; r < sizeof(Resolution) / sizeof(Resolution[0]); r++){
+		Scene scene;
+		MakeScene(scene, Resolution[r].width, Resolution[r].height, 1);
+		int words = (scene.width * scene.height + 31) / 32;
+		vector<unsigned int> current(words);
+		vector<unsigned int> mask(words);
+
+		DepthGate gate;
+		gate.Build(scene.distance_min, scene.distance_max, scene.humans.distance_min, scene.humans.distance_max);
+		bool brebuild = !gate.Build(scene.distance_min, scene.distance_max, scene.humans.distance_min, scene.humans.distance_max);
+
+		//Check result (including the ends of the range and invalid data)
+		GateCurrent(scene, &current[0]);
+		gate.Gate(&scene.depth[0], scene.width * scene.height, &mask[0]);
+		long diff = (memcmp(&current[0], &mask[0], words * sizeof(unsigned int)) != 0);
+		for (int raw = 0; raw <= MAX_INT16; raw++){
+			float length = CalculateLength(scene, (unsigned short)raw);
+			diff += (gate.IsValid((unsigned short)raw) != ((length >= scene.humans.distance_min) && (length <= scene.humans.distance_max)));
+			diff += (gate.Length((unsigned short)raw) != length);
+		}
+		if ((diff != 0) || !brebuild){
+			printf("%s: result is different from CalculateLength (%ld)%s\n", Resolution[r].name, diff, brebuild ? "" : ", rebuilt");
+		}
+
+		double base = Measure([&](){ GateCurrent(scene, &current[0]); }, seconds);
+		Report("CalculateLength x2", Resolution[r].name, base, base);
+		double us = Measure([&](){ gate.Gate(&scene.depth[0], scene.width * scene.height, &mask[0]); }, seconds);
+		Report("depth gate", Resolution[r].name, us, base);
+	}
+}
+
+#define MAX_TRACKS			(100)			//Max points in a track (HumanCounter.cpp)
+#define HUMAN_FRAMES		(64)			//Synthetic humans frames (used in turn)
+
+//Human managed in application (same layout as AppHuman of HumanCounter.cpp)
+struct BenchHuman {
+	long id;
+	int appid;
+	bool bEnable;
+	HumanStatus status;
+	float x;
+	float y;
+	float prex;
+	float prey;
+	float direction;
+	float headheight;
+	float handheight;
+	struct {
+		float x;
+		float y;
+	} track[MAX_TRACKS];
+	int nexttrack;
+	int trackcnt;
+	int enterdir;
+	int exitdir;
+};
+
+//Other fields of a human in HumanStore (same as AppHuman of HumanCounter.cpp)
+struct StoreHuman {
+	int appid;
+	bool bEnable;
+	HumanStatus status;
+	float direction;
+	float headheight;
+	float handheight;
+};
+
+//Synthetic humans frames (about 5% of IDs are changed every frame, order is shuffled)
+void MakeHumanFrames(vector<FrameHumans>& frames, int num, unsigned int seed)
+{
+	srand(seed);
+	vector<long> ids(num);
+	long nextid = 1;
+	for (int i = 0; i < num; i++){
+		ids[i] = nextid++;
+	}
+	frames.resize(HUMAN_FRAMES);
+	for (int f = 0; f < HUMAN_FRAMES; f++){
+		for (int i = 0; i < num; i++){
+			if (rand() % 20 == 0){
+				ids[i] = nextid++;
+			}
+		}
+		for (int i = num - 1; i > 0; i--){
+			std::swap(ids[i], ids[rand() % (i + 1)]);
+		}
+		FrameHumans& frame = frames[f];
+		frame.framenumber = f;
+		frame.numofhuman = num;
+		frame.humans.resize(num);
+		for (int i = 0; i < num; i++){
+			Human& h = frame.humans[i];
+			h.id = ids[i];
+			h.x = (float)(ids[i] * 37 % 4000) - 2000 + f * 10;
+			h.y = (float)(ids[i] * 53 % 4000) - 4000 + f * 5;
+			h.direction = 0;
+			h.headheight = 1700;
+			h.handheight = 1000;
+			h.status = HumanStatus::Walk;
+		}
+	}
+}
+
+//Update a human by SDK human
+inline void AssignHuman(BenchHuman& ah, const Human& h)
+{
+	ah.bEnable = true;
+	ah.prex = ah.x;
+	ah.prey = ah.y;
+	ah.x = h.x;
+	ah.y = h.y;
+	ah.direction = h.direction;
+	ah.headheight = h.headheight;
+	ah.handheight = h.handheight;
+	ah.status = h.status;
+	ah.track[ah.nexttrack].x = ah.prex;
+	ah.track[ah.nexttrack].y = ah.prey;
+	ah.nexttrack++;
+	if (ah.nexttrack == MAX_TRACKS){
+		ah.nexttrack = 0;
+	}
+	ah.trackcnt++;
+	if (ah.trackcnt > MAX_TRACKS){
+		ah.trackcnt = MAX_TRACKS;
+	}
+}
+
+//Make a new human by SDK human
+inline void NewHuman(BenchHuman& ah, const Human& h)
+{
+	ah.bEnable = true;
+	ah.id = h.id;
+	ah.status = HumanStatus::Walk;
+	ah.x = h.x;
+	ah.y = h.y;
+	ah.prex = ah.x;
+	ah.prey = ah.y;
+	ah.direction = h.direction;
+	ah.headheight = h.headheight;
+	ah.handheight = h.handheight;
+	ah.enterdir = -1;
+	ah.exitdir = -1;
+}
+
+//CatchHumans() of HumanCounter.cpp(Ver.2.2.0)
+void CatchCurrent(vector<BenchHuman>& humans, const FrameHumans& frame)
+{
+	for (unsigned int ahno = 0; ahno < humans.size(); ahno++){
+		humans[ahno].bEnable = false;
+	}
+	for (int hno = 0; hno < frame.numofhuman; hno++){
+		bool bAssigned = false;
+		for (unsigned int ahno = 0; ahno < humans.size(); ahno++){
+			if (humans[ahno].id == frame.humans[hno].id){
+				AssignHuman(humans[ahno], frame.humans[hno]);
+				bAssigned = true;
+				break;
+			}
+		}
+		if (!bAssigned){
+			BenchHuman ah;
+			memset(&ah, 0, sizeof(ah));
+			NewHuman(ah, frame.humans[hno]);
+			humans.push_back(ah);
+		}
+	}
+	for (int ahno = humans.size() - 1; ahno >= 0; ahno--){
+		if (humans[ahno].bEnable == false){
+			humans.erase(humans.begin() + ahno);
+		}
+	}
+}
+
+//CatchHumans() with HumanStore
+void CatchStore(HumanStore<StoreHuman>& humans, const FrameHumans& frame)
+{
+	for (int ahno = 0; ahno < humans.Size(); ahno++){
+		humans[ahno].bEnable = false;
+	}
+	for (int hno = 0; hno < frame.numofhuman; hno++){
+		const Human& h = frame.humans[hno];
+		int ahno = humans.Find(h.id);
+		if (ahno >= 0){
+			humans.prex[ahno] = humans.x[ahno];
+			humans.prey[ahno] = humans.y[ahno];
+			humans.x[ahno] = h.x;
+			humans.y[ahno] = h.y;
+			humans.tracks.Push(humans.Slot(ahno), humans.prex[ahno], humans.prey[ahno]);
+		}
+		else {
+			ahno = humans.Add(h.id);
+			humans.x[ahno] = h.x;
+			humans.y[ahno] = h.y;
+			humans.prex[ahno] = h.x;
+			humans.prey[ahno] = h.y;
+			humans.enterdir[ahno] = -1;
+			humans.exitdir[ahno] = -1;
+			humans[ahno].status = HumanStatus::Walk;
+		}
+		StoreHuman& ah = humans[ahno];
+		ah.bEnable = true;
+		ah.direction = h.direction;
+		ah.headheight = h.headheight;
+		ah.handheight = h.handheight;
+	}
+	for (int ahno = humans.Size() - 1; ahno >= 0; ahno--){
+		if (humans[ahno].bEnable == false){
+			humans.RemoveAt(ahno);
+		}
+	}
+}
+
+//Compare humans regardless of order (number of different humans)
+long CompareHumans(const vector<BenchHuman>& a, const HumanStore<StoreHuman>& b)
+{
+	long diff = labs((long)a.size() - b.Size());
+	for (unsigned int i = 0; i < a.size(); i++){
+		int j = b.Find(a[i].id);
+		if ((j < 0) || (b.x[j] != a[i].x) || (b.y[j] != a[i].y) || (b.prex[j] != a[i].prex) ||
+			(b.tracks.Count(b.Slot(j)) != a[i].trackcnt)){
+			diff++;
+			continue;
+		}
+		int tno = (a[i].trackcnt == MAX_TRACKS) ? a[i].nexttrack : 0;
+		for (int tcnt = 0; tcnt < a[i].trackcnt; tcnt++){
+			const TrackPoint& point = b.tracks.Point(b.Slot(j), tcnt);
+			if ((point.x != a[i].track[tno].x) || (point.y != a[i].track[tno].y)){
+				diff++;
+				break;
+			}
+			tno = (tno + 1) % MAX_TRACKS;
+		}
+	}
+	return diff;
+}
+
+//Count area test of CountHumans() in HumanCounter.cpp(Ver.2.2.0) (number of humans in the area)
+int InAreaCurrent(const vector<BenchHuman>& humans, float left, float right, float top, float bottom)
+{
+	int inarea = 0;
+	for (unsigned int ahno = 0; ahno < humans.size(); ahno++){
+		if ((humans[ahno].x >= left) && (humans[ahno].x <= right) && (humans[ahno].y >= top) && (humans[ahno].y <= bottom)){
+			if (!((humans[ahno].prex >= left) && (humans[ahno].prex <= right) && (humans[ahno].prey >= top) && (humans[ahno].prey <= bottom))){
+				inarea += 1000;
+			}
+			inarea++;
+		}
+		else if ((humans[ahno].prex >= left) && (humans[ahno].prex <= right) && (humans[ahno].prey >= top) && (humans[ahno].prey <= bottom)){
+			inarea += 1000000;
+		}
+	}
+	return inarea;
+}
+
+//Count area test of CountHumans() with arrays of HumanStore (state of each human and list of changed by AreaStates())
+int InAreaStore(const HumanStore<StoreHuman>& humans, const ZoneShape& shape, vector<unsigned char>& state, vector<int>& changed)
+{
+	int num = humans.Size();
+	state.resize(num);
+	changed.resize(num);
+	int numchanged;
+	int inarea = AreaStates(shape, humans.x.data(), humans.y.data(), humans.prex.data(), humans.prey.data(), num,
+		state.data(), changed.data(), numchanged);
+	for (int c = 0; c < numchanged; c++){
+		inarea += (state[changed[c]] == 1) ? 1000 : 1000000;
+	}
+	return inarea;
+}
+
+void BenchHumans(double seconds)
+{
+	printf("\n[CatchHumans]\n");
+
+	int nums[] = { 10, 100, 1000 };
+	for (size_t n = 0; n < sizeof(nums) / sizeof(nums[0]); n++){
+		char name[16];
+		sprintf(name, "%d", nums[n]);
+		vector<FrameHumans> frames;
+		MakeHumanFrames(frames, nums[n], 1);
+
+		//Check result and handles
+		vector<BenchHuman> current;
+		HumanStore<StoreHuman> store(64, MAX_TRACKS);
+		long diff = 0;
+		long stale = 0;
+		float left = -1000, right = 1000, top = -3000, bottom = -1000;
+		ZoneShape area;
+		area.Compile(left, top, right, bottom);
+		vector<unsigned char> state;
+		vector<int> changed;
+		for (int f = 0; f < HUMAN_FRAMES; f++){
+			vector<HumanHandle> handles;
+			for (int i = 0; i < store.Size(); i++){
+				handles.push_back(store.Handle(i));
+			}
+			vector<long> ids;
+			for (int i = 0; i < store.Size(); i++){
+				ids.push_back(store.id[i]);
+			}
+			CatchCurrent(current, frames[f]);
+			CatchStore(store, frames[f]);
+			diff += CompareHumans(current, store);
+			for (unsigned int i = 0; i < handles.size(); i++){
+				int j = store.IndexOf(handles[i]);
+				stale += (j >= 0) ? (store.id[j] != ids[i]) : (store.Find(ids[i]) >= 0);
+			}
+			if (InAreaCurrent(current, left, right, top, bottom) != InAreaStore(store, area, state, changed)){
+				diff++;
+			}
+			int c = 0;
+			for (int i = 0; i < store.Size(); i++){
+				int now = area.Inside(store.x[i], store.y[i]);
+				int pre = area.Inside(store.prex[i], store.prey[i]);
+				diff += (state[i] != (now | (pre << 1)));
+				if (now != pre){
+					diff += (changed[c] != i);
+					c++;
+				}
+			}
+		}
+		if ((diff != 0) || (stale != 0)){
+			printf("%s humans: result is different from current loop (%ld), wrong handles (%ld)\n", name, diff, stale);
+		}
+
+		int f = 0;
+		double base = Measure([&](){ CatchCurrent(current, frames[f]); f = (f + 1) % HUMAN_FRAMES; }, seconds);
+		Report("nested loop + erase", name, base, base);
+		f = 0;
+		double us = Measure([&](){ CatchStore(store, frames[f]); f = (f + 1) % HUMAN_FRAMES; }, seconds);
+		Report("human store", name, us, base);
+
+		//Count area
+		volatile int sink = 0;
+		base = Measure([&](){ sink += InAreaCurrent(current, left, right, top, bottom); }, seconds);
+		Report("count area (struct)", name, base, base);
+		us = Measure([&](){ sink += InAreaStore(store, area, state, changed); }, seconds);
+		Report("count area (arrays)", name, us, base);
+	}
+}
+
+#define ZONE_HUMANS			(100)			//Humans walking in the zones
+#define ZONE_PITCH			(600.0f)		//Pitch of zones [mm]
+#define ZONE_SIZE			(400.0f)		//Size of a zone [mm]
+
+//Count zones by testing all zones for each human (number of humans in zones and number of crossings)
+void CountZonesAll(const HumanStore<StoreHuman>& humans, const vector<ZoneShape>& shapes, int& inarea, int& crossings)
+{
+	for (int ahno = 0; ahno < humans.Size(); ahno++){
+		for (size_t zone = 0; zone < shapes.size(); zone++){
+			bool bnow = shapes[zone].Inside(humans.x[ahno], humans.y[ahno]);
+			bool bpre = shapes[zone].Inside(humans.prex[ahno], humans.prey[ahno]);
+			inarea += bnow;
+			crossings += (bnow != bpre);
+		}
+	}
+}
+
+void BenchZones(double seconds)
+{
+	printf("\n[Count zones] (%d humans)\n", ZONE_HUMANS);
+
+	//Humans walking straight (100mm each frame) in 20m x 20m
+	vector<float> startx(ZONE_HUMANS), starty(ZONE_HUMANS), stepx(ZONE_HUMANS), stepy(ZONE_HUMANS);
+	srand(1);
+	for (int i = 0; i < ZONE_HUMANS; i++){
+		startx[i] = (float)(rand() % 20000);
+		starty[i] = (float)(rand() % 20000);
+		float angle = (float)(rand() % 360) * 3.14159265f / 180;
+		stepx[i] = 100 * cosf(angle);
+		stepy[i] = 100 * sinf(angle);
+	}
+	HumanStore<StoreHuman> humans(ZONE_HUMANS);
+	for (int i = 0; i < ZONE_HUMANS; i++){
+		humans.Add(i + 1);
+	}
+	int frame = 0;
+	auto Walk = [&](){
+		for (int i = 0; i < ZONE_HUMANS; i++){
+			float t = (float)(frame % 200);
+			humans.prex[i] = humans.x[i];
+			humans.prey[i] = humans.y[i];
+			humans.x[i] = fmodf(startx[i] + stepx[i] * t + 20000, 20000);
+			humans.y[i] = fmodf(starty[i] + stepy[i] * t + 20000, 20000);
+		}
+		frame++;
+	};
+
+	int nums[] = { 10, 100, 1000 };
+	for (size_t n = 0; n < sizeof(nums) / sizeof(nums[0]); n++){
+		char name[16];
+		sprintf(name, "%d", nums[n]);
+
+		//Zones on a grid from the center of the area
+		CountZones zones;
+		vector<ZoneShape> shapes;
+		int side = (int)ceilf(sqrtf((float)nums[n]));
+		for (int zone = 0; zone < nums[n]; zone++){
+			float left = 10000 + (zone % side - side / 2) * ZONE_PITCH;
+			float top = 10000 + (zone / side - side / 2) * ZONE_PITCH;
+			zones.Add(name, left, top, left + ZONE_SIZE, top + ZONE_SIZE);
+			shapes.push_back(zones.Shape(zone));
+		}
+
+		//Check result
+		long diff = 0;
+		for (int f = 0; f < 200; f++){
+			Walk();
+			int inarea = 0, crossings = 0;
+			CountZonesAll(humans, shapes, inarea, crossings);
+			zones.Count(humans);
+			int gridinarea = 0, gridcrossings = 0;
+			for (int zone = 0; zone < zones.Size(); zone++){
+				gridinarea += zones.counts[zone].InArea;
+			}
+			for (size_t cno = 0; cno < zones.crossings.size(); cno++){
+				CountEventType type = zones.crossings[cno].type;
+				gridcrossings += (type == CountEventType::Enter) || (type == CountEventType::Exit);
+			}
+			diff += (inarea != gridinarea) || (crossings != gridcrossings);
+		}
+		if (diff != 0){
+			printf("%s zones: result is different from all zones loop (%ld frames)\n", name, diff);
+		}
+
+		volatile int sink = 0;
+		double base = Measure([&](){ int inarea = 0, crossings = 0; Walk(); CountZonesAll(humans, shapes, inarea, crossings); sink += inarea; }, seconds);
+		Report("all zones", name, base, base);
+		double us = Measure([&](){ Walk(); zones.Count(humans); }, seconds);
+		Report("uniform grid", name, us, base);
+	}
+}
+
+#define TRIPWIRE_POINTS		(5)				//Points of a synthetic tripwire
+
+//Polyline of a synthetic tripwire
+struct BenchTripwire {
+	float x[TRIPWIRE_POINTS];
+	float y[TRIPWIRE_POINTS];
+};
+
+//Tripwires by testing each segment with branches (sum of crossings of all humans, in: +1, out: -1)
+int CrossAll(const HumanStore<StoreHuman>& humans, const vector<BenchTripwire>& lines, int& count)
+{
+	int sum = 0;
+	for (int ahno = 0; ahno < humans.Size(); ahno++){
+		float px = humans.prex[ahno];
+		float py = humans.prey[ahno];
+		float qx = humans.x[ahno];
+		float qy = humans.y[ahno];
+		for (size_t line = 0; line < lines.size(); line++){
+			int linesum = 0;
+			for (int n = 0; n + 1 < TRIPWIRE_POINTS; n++){
+				float ax = lines[line].x[n];
+				float ay = lines[line].y[n];
+				float ex = lines[line].x[n + 1] - ax;
+				float ey = lines[line].y[n + 1] - ay;
+				bool b1 = (ex * (py - ay) - ey * (px - ax)) > 0;
+				bool b2 = (ex * (qy - ay) - ey * (qx - ax)) > 0;
+				if (b1 == b2){
+					continue;
+				}
+				bool b3 = ((qx - px) * (ay - py) - (qy - py) * (ax - px)) > 0;
+				bool b4 = ((qx - px) * (ay + ey - py) - (qy - py) * (ax + ex - px)) > 0;
+				if (b3 == b4){
+					continue;
+				}
+				linesum += b2 ? 1 : -1;
+			}
+			if (linesum != 0){
+				sum += (linesum > 0) ? 1 : -1;
+				count++;
+			}
+		}
+	}
+	return sum;
+}
+
+void BenchTripwires(double seconds)
+{
+	printf("\n[Tripwires] (%d humans, %d points each)\n", ZONE_HUMANS, TRIPWIRE_POINTS);
+
+	//Humans walking around in 20m x 20m
+	HumanStore<StoreHuman> humans(ZONE_HUMANS);
+	srand(2);
+	for (int i = 0; i < ZONE_HUMANS; i++){
+		int ahno = humans.Add(i + 1);
+		humans.x[ahno] = (float)(rand() % 20000);
+		humans.y[ahno] = (float)(rand() % 20000);
+	}
+	auto Walk = [&](){
+		for (int i = 0; i < ZONE_HUMANS; i++){
+			humans.prex[i] = humans.x[i];
+			humans.prey[i] = humans.y[i];
+			humans.x[i] = fmodf(humans.x[i] + (float)(rand() % 401 - 200) + 20000, 20000);
+			humans.y[i] = fmodf(humans.y[i] + (float)(rand() % 401 - 200) + 20000, 20000);
+		}
+	};
+
+	int nums[] = { 1, 10, 100 };
+	for (size_t n = 0; n < sizeof(nums) / sizeof(nums[0]); n++){
+		char name[16];
+		sprintf(name, "%d", nums[n]);
+
+		//Zigzag lines across the area
+		Tripwires tripwires;
+		vector<BenchTripwire> lines(nums[n]);
+		for (int line = 0; line < nums[n]; line++){
+			float y0 = (line + 0.5f) * 20000 / nums[n];
+			for (int p = 0; p < TRIPWIRE_POINTS; p++){
+				lines[line].x[p] = p * 20000.0f / (TRIPWIRE_POINTS - 1);
+				lines[line].y[p] = y0 + ((p & 1) ? 150.0f : -150.0f);
+			}
+			tripwires.Add(name, lines[line].x, lines[line].y, TRIPWIRE_POINTS);
+		}
+
+		//Check result
+		long diff = 0;
+		for (int f = 0; f < 200; f++){
+			Walk();
+			int count = 0;
+			int sum = CrossAll(humans, lines, count);
+			tripwires.Count(humans);
+			int batchsum = 0;
+			for (size_t cno = 0; cno < tripwires.crossings.size(); cno++){
+				batchsum += tripwires.crossings[cno].bIn ? 1 : -1;
+			}
+			diff += (sum != batchsum) || (count != (int)tripwires.crossings.size());
+		}
+		if (diff != 0){
+			printf("%s tripwires: result is different from segment loop (%ld frames)\n", name, diff);
+		}
+
+		volatile int sink = 0;
+		double base = Measure([&](){ int count = 0; Walk(); sink += CrossAll(humans, lines, count); }, seconds);
+		Report("segment loop", name, base, base);
+		double us = Measure([&](){ Walk(); tripwires.Count(humans); }, seconds);
+		Report("batched segments", name, us, base);
+	}
+}
+
+#define SECTION_DISPLAY_WIDTH	(640 * 2)		//Width of display of HumanCounter
+#define SECTION_DISPLAY_HEIGHT	(480 * 2)		//Height of display of HumanCounter
+#define SIDE_VIEW_X				(850)			//X-coordinate of side view
+#define SIDE_VIEW_Y				(100)			//Y-coordinate of side view
+#define SIDE_VIEW_WIDTH			(400)			//Width of side view
+#define SIDE_VIEW_HEIGHT		(300)			//Height of side view
+#define FRONT_VIEW_X			(850)			//X-coordinate of front view
+#define FRONT_VIEW_Y			(500)			//Y-coordinate of front view
+#define FRONT_VIEW_WIDTH		(400)			//Width of front view
+#define FRONT_VIEW_HEIGHT		(300)			//Height of front view
+#define SIDE_VIEW_RANGE			(5000)			//Range (distance) of side view [mm]
+#define FRONT_VIEW_RANGE		(6000)			//Range (width) of front view [mm]
+#define SECTION_GRAY_MIN		(96)			//Gray of the farthest point of side/front view
+#define SECTION_HEIGHT_MIN		(-500)			//Min height of side/front view [mm]
+#define SECTION_HEIGHT_MAX		(2000)			//Max height of side/front view [mm]
+
+//IR frame of a scene (nearer is brighter)
+void MakeIrFrame(const Scene& scene, FrameIr& frame)
+{
+	frame.width = scene.width;
+	frame.height = scene.height;
+	frame.pixel = scene.width * scene.height;
+	frame.distance_min = scene.distance_min;
+	frame.distance_max = scene.distance_max;
+	frame.lens = MakeLens();
+	frame.databuf.resize(frame.pixel);
+	for (int i = 0; i < frame.pixel; i++){
+		frame.databuf[i] = (scene.depth[i] == MAX_INT16) ? 0 : (unsigned short)(MAX_INT16 - scene.depth[i]);
+	}
+}
+
+//3D frame of a scene in coordinate of the sensor (in place of Frame3d::Convert(), Frame3d needs the SDK DLL)
+void MakeFrame3d(const Scene& scene, vector<TofPoint>& points)
+{
+	FrameDepth frame;
+	MakeDepthFrame(scene, frame);
+	RayTable table;
+	table.Convert(frame, points);
+}
+
+//Side and front view of HumanCounter.cpp(Ver.2.2.0) DrawSection() (img is BGR of SECTION_DISPLAY_WIDTH x SECTION_DISPLAY_HEIGHT)
+void SectionCurrent(const Scene& scene, float height, vector<unsigned char>& img)
+{
+	for (int y = 0; y < SIDE_VIEW_HEIGHT; y++){
+		memset(&img[((y + SIDE_VIEW_Y) * SECTION_DISPLAY_WIDTH + SIDE_VIEW_X) * 3], 0, SIDE_VIEW_WIDTH * 3);
+	}
+	for (int y = 0; y < FRONT_VIEW_HEIGHT; y++){
+		memset(&img[((y + FRONT_VIEW_Y) * SECTION_DISPLAY_WIDTH + FRONT_VIEW_X) * 3], 0, FRONT_VIEW_WIDTH * 3);
+	}
+
+	for (int y = 0; y < scene.height; y++){
+		for (int x = 0; x < scene.width; x++){
+			TofPoint p = scene.points[y * scene.width + x];
+			int h = (int)height - (int)p.z;
+			if ((h >= SECTION_HEIGHT_MIN) && (h <= SECTION_HEIGHT_MAX)){
+				int px = (int)p.x;
+				int py = (int)p.y;
+				if (py < 0){
+					py *= -1;
+				}
+
+				//Side view
+				int sdx = (SIDE_VIEW_RANGE - py) * SIDE_VIEW_WIDTH / SIDE_VIEW_RANGE;
+				int sdy = ((SECTION_HEIGHT_MAX - SECTION_HEIGHT_MIN) - (h - SECTION_HEIGHT_MIN)) * SIDE_VIEW_HEIGHT / (SECTION_HEIGHT_MAX - SECTION_HEIGHT_MIN);
+				if ((sdx >= 0) && (sdx < SIDE_VIEW_WIDTH) &&
+					(sdy >= 0) && (sdy < SIDE_VIEW_HEIGHT)){
+					memset(&img[((sdy + SIDE_VIEW_Y) * SECTION_DISPLAY_WIDTH + sdx + SIDE_VIEW_X) * 3], 255, 3);
+				}
+
+				//Front view
+				int fdx = (FRONT_VIEW_RANGE / 2 + px) * FRONT_VIEW_WIDTH / FRONT_VIEW_RANGE;
+				int fdy = ((SECTION_HEIGHT_MAX - SECTION_HEIGHT_MIN) - (h - SECTION_HEIGHT_MIN)) * FRONT_VIEW_HEIGHT / (SECTION_HEIGHT_MAX - SECTION_HEIGHT_MIN);
+				if ((fdx >= 0) && (fdx < SIDE_VIEW_WIDTH) &&
+					(fdy >= 0) && (fdy < SIDE_VIEW_HEIGHT)){
+					memset(&img[((fdy + FRONT_VIEW_Y) * SECTION_DISPLAY_WIDTH + fdx + FRONT_VIEW_X) * 3], 255, 3);
+				}
+			}
+		}
+	}
+}
+
+//Draw a depth buffer of side/front view (HumanCounter.cpp DrawRaster())
+void SectionDraw(const Raster& raster, int left, int top, vector<unsigned char>& img)
+{
+	for (int y = 0; y < raster.height; y++){
+		unsigned char* d = &img[((y + top) * SECTION_DISPLAY_WIDTH + left) * 3];
+		for (int x = 0; x < raster.width; x++){
+			unsigned int key = raster(x, y);
+			if (key != RASTER_EMPTY){
+				memset(d + x * 3, 255 - (((key >> 16) * (255 - SECTION_GRAY_MIN)) >> 16), 3);
+			}
+		}
+	}
+}
+
+//Side and front view of HumanCounter.cpp DrawSection() (points of a pixel are drawn directly, larger points by depth buffers)
+void SectionRaster(const Scene& scene, float height, const RasterSplat& splat, Raster& side, Raster& front, vector<unsigned char>& img)
+{
+	if (splat.size == 1){
+		SectionCurrent(scene, height, img);
+		return;
+	}
+	for (int y = 0; y < SIDE_VIEW_HEIGHT; y++){
+		memset(&img[((y + SIDE_VIEW_Y) * SECTION_DISPLAY_WIDTH + SIDE_VIEW_X) * 3], 0, SIDE_VIEW_WIDTH * 3);
+	}
+	for (int y = 0; y < FRONT_VIEW_HEIGHT; y++){
+		memset(&img[((y + FRONT_VIEW_Y) * SECTION_DISPLAY_WIDTH + FRONT_VIEW_X) * 3], 0, FRONT_VIEW_WIDTH * 3);
+	}
+	side.Clear();
+	front.Clear();
+	const float sidescale = RASTER_MAX_DEPTH / (float)FRONT_VIEW_RANGE;
+	const float frontscale = RASTER_MAX_DEPTH / (float)SIDE_VIEW_RANGE;
+
+	for (int y = 0; y < scene.height; y++){
+		for (int x = 0; x < scene.width; x++){
+			TofPoint p = scene.points[y * scene.width + x];
+			int h = (int)height - (int)p.z;
+			if ((h >= SECTION_HEIGHT_MIN) && (h <= SECTION_HEIGHT_MAX)){
+				int px = (int)p.x;
+				int py = (int)p.y;
+				if (py < 0){
+					py *= -1;
+				}
+
+				//Side view
+				int sdx = (SIDE_VIEW_RANGE - py) * SIDE_VIEW_WIDTH / SIDE_VIEW_RANGE;
+				int sdy = ((SECTION_HEIGHT_MAX - SECTION_HEIGHT_MIN) - (h - SECTION_HEIGHT_MIN)) * SIDE_VIEW_HEIGHT / (SECTION_HEIGHT_MAX - SECTION_HEIGHT_MIN);
+				if ((sdx >= 0) && (sdx < SIDE_VIEW_WIDTH) &&
+					(sdy >= 0) && (sdy < SIDE_VIEW_HEIGHT)){
+					side.Splat(sdx, sdy, RasterKey(RasterDepth((float)(FRONT_VIEW_RANGE / 2 + px), 0, sidescale), 0), splat);
+				}
+
+				//Front view
+				int fdx = (FRONT_VIEW_RANGE / 2 + px) * FRONT_VIEW_WIDTH / FRONT_VIEW_RANGE;
+				int fdy = ((SECTION_HEIGHT_MAX - SECTION_HEIGHT_MIN) - (h - SECTION_HEIGHT_MIN)) * FRONT_VIEW_HEIGHT / (SECTION_HEIGHT_MAX - SECTION_HEIGHT_MIN);
+				if ((fdx >= 0) && (fdx < FRONT_VIEW_WIDTH) &&
+					(fdy >= 0) && (fdy < FRONT_VIEW_HEIGHT)){
+					front.Splat(fdx, fdy, RasterKey(RasterDepth((float)py, 0, frontscale), 0), splat);
+				}
+			}
+		}
+	}
+	SectionDraw(side, SIDE_VIEW_X, SIDE_VIEW_Y, img);
+	SectionDraw(front, FRONT_VIEW_X, FRONT_VIEW_Y, img);
+}
+
+void BenchSection(double seconds)
+{
+	printf("\n[HumanCounter side/front view]\n");
+
+	vector<unsigned char> img(SECTION_DISPLAY_WIDTH * SECTION_DISPLAY_HEIGHT * 3);
+	Raster side(SIDE_VIEW_WIDTH, SIDE_VIEW_HEIGHT);
+	Raster front(FRONT_VIEW_WIDTH, FRONT_VIEW_HEIGHT);
+	RasterSplat pixel(1, false);
+	RasterSplat square(2, false);
+	for (size_t r = 0; r < sizeof(Resolution) / sizeof(Resolution[0]); r++){
+		Scene scene;
+		MakeScene(scene, Resolution[r].width, Resolution[r].height, 1);
+
+		double base = Measure([&](){ SectionCurrent(scene, SENSOR_HEIGHT, img); }, seconds);
+		Report("current loop", Resolution[r].name, base, base);
+		double us = Measure([&](){ SectionRaster(scene, SENSOR_HEIGHT, pixel, side, front, img); }, seconds);
+		Report("point size 1", Resolution[r].name, us, base);
+		us = Measure([&](){ SectionRaster(scene, SENSOR_HEIGHT, square, side, front, img); }, seconds);
+		Report("depth buffer, 2x2 points", Resolution[r].name, us, base);
+	}
+}
+
+//Colorize of Tof2dViewer.cpp(Ver.2.2.0), Reverse(Mirror) mode
+void ColorizeMirror(const FrameDepth& frame, unsigned char* buf)
+{
+	for (int i = 0; i < frame.height; i++){
+		for (int j = 0; j < frame.width; j++){
+			for (int ch = 0; ch < COLOR_CH_NUM; ch++){
+				buf[(i * frame.width + j)*COLOR_CH_NUM + ch] = ColorTable[ch][frame.databuf[i * frame.width + (frame.width - j - 1)]];
+			}
+		}
+	}
+}
+
+//Colorize of Tof2dViewer.cpp(Ver.2.2.0), Normal(Camera view) mode
+void ColorizeNormal(const FrameDepth& frame, unsigned char* buf)
+{
+	for (int i = 0; i < frame.width * frame.height; i++){
+		for (int ch = 0; ch < COLOR_CH_NUM; ch++){
+			buf[i * COLOR_CH_NUM + ch] = ColorTable[ch][frame.databuf[i]];
+		}
+	}
+}
+
+//Reverse(Mirror) mode by packed color table
+void ColorizePackedMirror(const FrameDepth& frame, unsigned char* buf)
+{
+	for (int i = 0; i < frame.height; i++){
+		for (int j = 0; j < frame.width; j++){
+			PutColor(&buf[(i * frame.width + j)*COLOR_CH_NUM], Lut[frame.databuf[i * frame.width + (frame.width - j - 1)]]);
+		}
+	}
+}
+
+void BenchColorize(double seconds)
+{
+	printf("\n[Tof2dViewer colorize] (%s)\n", TofSimdName());
+
+	for (size_t r = 0; r < sizeof(Resolution) / sizeof(Resolution[0]); r++){
+		Scene scene;
+		MakeScene(scene, Resolution[r].width, Resolution[r].height, 1);
+		FrameDepth frame;
+		MakeDepthFrame(scene, frame);
+		vector<unsigned char> buf(frame.pixel * COLOR_CH_NUM);
+
+		//Check result
+		vector<unsigned char> packed(frame.pixel * COLOR_CH_NUM);
+		vector<unsigned char> tile(IMAGE_MAX_WIDTH * IMAGE_MAX_HEIGHT * COLOR_CH_NUM);
+		ColorizeNormal(frame, &buf[0]);
+		Lut.Colorize(&frame.databuf[0], frame.pixel, &packed[0]);
+		long diff = (memcmp(&buf[0], &packed[0], buf.size()) != 0);
+		ColorizeMirror(frame, &buf[0]);
+		ColorizePackedMirror(frame, &packed[0]);
+		diff += (memcmp(&buf[0], &packed[0], buf.size()) != 0);
+		Lut.ColorizeMirror(&frame.databuf[0], frame.width, frame.height, &packed[0], frame.width * COLOR_CH_NUM);
+		diff += (memcmp(&buf[0], &packed[0], buf.size()) != 0);
+		if (diff != 0){
+			printf("%s: result is different from current loop\n", Resolution[r].name);
+		}
+
+		double base = Measure([&](){ ColorizeMirror(frame, &buf[0]); }, seconds);
+		Report("mirror loop", Resolution[r].name, base, base);
+		double us = Measure([&](){ ColorizePackedMirror(frame, &packed[0]); }, seconds);
+		Report("mirror packed table", Resolution[r].name, us, base);
+		us = Measure([&](){ ColorizeNormal(frame, &buf[0]); }, seconds);
+		Report("normal loop", Resolution[r].name, us, base);
+		us = Measure([&](){ Lut.Colorize(&frame.databuf[0], frame.pixel, &packed[0]); }, seconds);
+		Report("normal Colorize()", Resolution[r].name, us, base);
+		us = Measure([&](){ Lut.ColorizeMirror(&frame.databuf[0], frame.width, frame.height, &packed[0], frame.width * COLOR_CH_NUM); }, seconds);
+		Report("mirror ColorizeMirror()", Resolution[r].name, us, base);
+
+		//Into a 640x480 tile of the mosaic of Tof2dViewer by nearest neighbour (TILE_NEAREST, no cv::resize())
+		us = Measure([&](){ Lut.ColorizeImage(&frame.databuf[0], frame.width, frame.height, true,
+			&tile[0], IMAGE_MAX_WIDTH * COLOR_CH_NUM, IMAGE_MAX_WIDTH, IMAGE_MAX_HEIGHT); }, seconds);
+		Report("mirror + enlarge to tile", Resolution[r].name, us, base);
+	}
+}
+
+//Mean and max of difference of each channel
+void ColorError(const vector<unsigned char>& a, const vector<unsigned char>& b, double& mean, int& max)
+{
+	long long sum = 0;
+	max = 0;
+	for (size_t i = 0; i < a.size(); i++){
+		int diff = abs((int)a[i] - (int)b[i]);
+		sum += diff;
+		if (diff > max){
+			max = diff;
+		}
+	}
+	mean = (double)sum / a.size();
+}
+
+//Stretch valid depth data of a frame over the whole range (0x0000 to 0xfffe), invalid data is kept
+void SpreadDepth(FrameDepth& frame)
+{
+	int dmin = MAX_INT16;
+	int dmax = 0;
+	for (int i = 0; i < frame.pixel; i++){
+		if (frame.databuf[i] != MAX_INT16){
+			dmin = min(dmin, (int)frame.databuf[i]);
+			dmax = max(dmax, (int)frame.databuf[i]);
+		}
+	}
+	for (int i = 0; i < frame.pixel; i++){
+		if ((frame.databuf[i] != MAX_INT16) && (dmax > dmin)){
+			frame.databuf[i] = (unsigned short)((long long)(frame.databuf[i] - dmin) * (MAX_INT16 - 1) / (dmax - dmin));
+		}
+	}
+}
+
+void BenchColorQuantize(double seconds)
+{
+	printf("\n[Colorize quantized color table] (%s, depth data over 0x0000 to 0xfffe)\n", TofSimdName());
+
+	const int bits[] = { 8, 10, 12, 14 };
+	for (size_t r = 0; r < sizeof(Resolution) / sizeof(Resolution[0]); r++){
+		Scene scene;
+		MakeScene(scene, Resolution[r].width, Resolution[r].height, 1);
+		FrameDepth frame;
+		MakeDepthFrame(scene, frame);
+		SpreadDepth(frame);
+		vector<unsigned char> full(frame.pixel * COLOR_CH_NUM);
+		vector<unsigned char> quantized(frame.pixel * COLOR_CH_NUM);
+		Lut.Colorize(&frame.databuf[0], frame.pixel, &full[0]);
+
+		double base = Measure([&](){ Lut.Colorize(&frame.databuf[0], frame.pixel, &full[0]); }, seconds);
+		Report("full table", Resolution[r].name, base, base);
+		for (size_t b = 0; b < sizeof(bits) / sizeof(bits[0]); b++){
+			ColorLut lut;
+			lut.Build(ColorTable);
+			lut.SetQuantize(bits[b]);
+			lut.Colorize(&frame.databuf[0], frame.pixel, &quantized[0]);
+			double mean;
+			int max;
+			ColorError(full, quantized, mean, max);
+
+			//Scalar lookup must give the same color
+			long diff = 0;
+			for (int i = 0; i < frame.pixel; i++){
+				unsigned char bgr[COLOR_CH_NUM];
+				PutColor(bgr, lut[frame.databuf[i]]);
+				diff += (memcmp(bgr, &quantized[i * COLOR_CH_NUM], COLOR_CH_NUM) != 0);
+			}
+			if (diff != 0){
+				printf("%s %d bits: Colorize() is different from lookup (%ld pixels)\n", Resolution[r].name, bits[b], diff);
+			}
+
+			//Invalid data has its own color, valid data of the last range has the color of the range
+			if ((lut[MAX_INT16] != Lut[MAX_INT16]) || (lut[MAX_INT16 - 1] != Lut[MAX_INT16 - (1 << (15 - bits[b]))])){
+				printf("%d bits: color of invalid data or of the last range is wrong\n", bits[b]);
+			}
+
+			char name[64];
+			sprintf(name, "%d bits (%d entries)", bits[b], 1 << bits[b]);
+			double us = Measure([&](){ lut.Colorize(&frame.databuf[0], frame.pixel, &quantized[0]); }, seconds);
+			Report(name, Resolution[r].name, us, base);
+			printf("%-28s %-8s error mean %.3f max %d\n", "", "", mean, max);
+		}
+	}
+}
+
+//Copy of TofIrViewer.cpp(Ver.2.2.0), Reverse(Mirror) mode
+void IrCopyMirror(const FrameIr& frame, unsigned short* buf)
+{
+	for (int i = 0; i < frame.height; i++){
+		for (int j = 0; j < frame.width; j++){
+			buf[(i * frame.width + j)] = frame.databuf[i * frame.width + (frame.width - j - 1)];
+		}
+	}
+}
+
+//Copy of TofIrViewer.cpp(Ver.2.2.0), Normal(Camera view) mode
+void IrCopyNormal(const FrameIr& frame, unsigned short* buf)
+{
+	for (int i = 0; i < frame.width * frame.height; i++){
+		buf[i] = frame.databuf[i];
+	}
+}
+
+void BenchIrCopy(double seconds)
+{
+	printf("\n[TofIrViewer 16 bit copy]\n");
+
+	for (size_t r = 0; r < sizeof(Resolution) / sizeof(Resolution[0]); r++){
+		Scene scene;
+		MakeScene(scene, Resolution[r].width, Resolution[r].height, 1);
+		FrameIr frame;
+		MakeIrFrame(scene, frame);
+		vector<unsigned short> buf(frame.pixel);
+
+		double base = Measure([&](){ IrCopyMirror(frame, &buf[0]); }, seconds);
+		Report("mirror loop", Resolution[r].name, base, base);
+		double us = Measure([&](){ IrCopyNormal(frame, &buf[0]); }, seconds);
+		Report("normal loop", Resolution[r].name, us, base);
+	}
+}
+
+#define MAIN_DISPLAY_WIDTH		(640 * 2)		//Width of Main Display of Tofv2Viewer
+#define MAIN_DISPLAY_HEIGHT		(480 * 2)		//Height of Main Display of Tofv2Viewer
+#define V2_SUB_DISPLAY_WIDTH	(480)			//Width of Sub Display of Tofv2Viewer
+#define V2_SUB_DISPLAY_HEIGHT	(360)			//Height of Sub Display of Tofv2Viewer
+
+//Output of Tofv2Viewer
+struct Composite {
+	vector<unsigned char> img;
+	vector<unsigned char> sub;
+
+	Composite(){
+		img.resize(MAIN_DISPLAY_WIDTH * MAIN_DISPLAY_HEIGHT * 3);
+		sub.resize(V2_SUB_DISPLAY_WIDTH * V2_SUB_DISPLAY_HEIGHT * 3);
+	}
+};
+
+//Per-pixel loop of Tofv2Viewer.cpp(Ver.2.2.0) (cv::resize() of the sub display is not included)
+void CompositeCurrent(const FrameDepth& frame1, const FrameIr& frameir, const FrameDepth& frame2, bool bDepthIr, Composite& out)
+{
+	//Initialize screen (cv::Mat::zeros())
+	memset(&out.img[0], 0, out.img.size());
+	memset(&out.sub[0], 0, out.sub.size());
+
+	for (int y = 0; y < MAIN_DISPLAY_HEIGHT; y++){
+		for (int x = 0; x < MAIN_DISPLAY_WIDTH; x++){
+			long datano = (y * frame1.height / MAIN_DISPLAY_HEIGHT) * frame1.width + x * frame1.width / MAIN_DISPLAY_WIDTH;
+
+			unsigned char v_main[3];
+			unsigned char v_sub[3];
+			v_main[0] = ColorTable[0][frame1.databuf[datano]];
+			v_main[1] = ColorTable[1][frame1.databuf[datano]];
+			v_main[2] = ColorTable[2][frame1.databuf[datano]];
+			if (bDepthIr){
+				v_sub[0] = (unsigned char)(frameir.databuf[datano] / 256);
+				v_sub[1] = v_sub[0];
+				v_sub[2] = v_sub[0];
+			}
+			else {
+				v_sub[0] = ColorTable[0][frame2.databuf[datano]];
+				v_sub[1] = ColorTable[1][frame2.databuf[datano]];
+				v_sub[2] = ColorTable[2][frame2.databuf[datano]];
+			}
+
+			memcpy(&out.img[(y * MAIN_DISPLAY_WIDTH + x) * 3], v_main, 3);
+			memcpy(&out.sub[((y * V2_SUB_DISPLAY_HEIGHT / MAIN_DISPLAY_HEIGHT) * V2_SUB_DISPLAY_WIDTH + x * V2_SUB_DISPLAY_WIDTH / MAIN_DISPLAY_WIDTH) * 3], v_sub, 3);
+		}
+	}
+}
+
+//Nearest neighbour enlargement by row/column index maps (cv::resize() INTER_NEAREST of Tofv2Viewer)
+struct NearestMap {
+	vector<int> xs;					//Byte offset of source pixel of each column
+	vector<int> ys;					//Source row of each row
+	int		srcstep;
+	int		dstwidth;
+	int		dstheight;
+
+	void Build(int srcwidth, int srcheight, int dstwidth, int dstheight){
+		xs.resize(dstwidth);
+		ys.resize(dstheight);
+		for (int x = 0; x < dstwidth; x++){
+			xs[x] = (x * srcwidth / dstwidth) * 3;
+		}
+		for (int y = 0; y < dstheight; y++){
+			ys[y] = y * srcheight / dstheight;
+		}
+		srcstep = srcwidth * 3;
+		this->dstwidth = dstwidth;
+		this->dstheight = dstheight;
+	}
+
+	void Resize(const unsigned char* src, unsigned char* dst, int dststep) const {
+		for (int y = 0; y < dstheight; y++){
+			unsigned char* d = dst + y * dststep;
+			if ((y > 0) && (ys[y] == ys[y - 1])){
+				//Same source row
+				memcpy(d, d - dststep, dstwidth * 3);
+				continue;
+			}
+			const unsigned char* s = src + ys[y] * srcstep;
+			for (int x = 0; x < dstwidth; x++){
+				memcpy(d + x * 3, s + xs[x], 3);
+			}
+		}
+	}
+};
+
+//Tofv2Viewer.cpp (v1.5.0): colorize at the resolution of the sensor, then enlarge
+void CompositeNative(const FrameDepth& frame1, const FrameIr& frameir, const FrameDepth& frame2, bool bDepthIr,
+	const NearestMap& mainmap, const NearestMap& submap, vector<unsigned char>& native1, vector<unsigned char>& native2, Composite& out)
+{
+	int pixels = frame1.width * frame1.height;
+	Lut.Colorize(&frame1.databuf[0], pixels, &native1[0]);
+	if (bDepthIr){
+		unsigned char* ir = &native2[0];
+		for (int i = 0; i < pixels; i++){
+			unsigned char v = (unsigned char)(frameir.databuf[i] >> 8);
+			ir[i * 3] = v;
+			ir[i * 3 + 1] = v;
+			ir[i * 3 + 2] = v;
+		}
+	}
+	else {
+		Lut.Colorize(&frame2.databuf[0], pixels, &native2[0]);
+	}
+	mainmap.Resize(&native1[0], &out.img[0], MAIN_DISPLAY_WIDTH * 3);
+	submap.Resize(&native2[0], &out.sub[0], V2_SUB_DISPLAY_WIDTH * 3);
+}
+
+void BenchComposite(double seconds)
+{
+	printf("\n[Tofv2Viewer %dx%d compositing]\n", MAIN_DISPLAY_WIDTH, MAIN_DISPLAY_HEIGHT);
+
+	Composite out;
+	for (size_t r = 0; r < sizeof(Resolution) / sizeof(Resolution[0]); r++){
+		Scene scene;
+		MakeScene(scene, Resolution[r].width, Resolution[r].height, 1);
+		FrameDepth frame1;
+		MakeDepthFrame(scene, frame1);
+		FrameIr frameir;
+		MakeIrFrame(scene, frameir);
+		Scene scene2;
+		MakeScene(scene2, Resolution[r].width, Resolution[r].height, 2);
+		FrameDepth frame2;
+		MakeDepthFrame(scene2, frame2);
+
+		NearestMap mainmap;
+		NearestMap submap;
+		mainmap.Build(frame1.width, frame1.height, MAIN_DISPLAY_WIDTH, MAIN_DISPLAY_HEIGHT);
+		submap.Build(frame1.width, frame1.height, V2_SUB_DISPLAY_WIDTH, V2_SUB_DISPLAY_HEIGHT);
+		vector<unsigned char> native1(frame1.pixel * 3);
+		vector<unsigned char> native2(frame1.pixel * 3);
+
+		//Check result (main display)
+		Composite native;
+		long diff = 0;
+		for (int ir = 0; ir < 2; ir++){
+			CompositeCurrent(frame1, frameir, frame2, ir != 0, out);
+			CompositeNative(frame1, frameir, frame2, ir != 0, mainmap, submap, native1, native2, native);
+			diff += (memcmp(&out.img[0], &native.img[0], out.img.size()) != 0);
+		}
+		if (diff != 0){
+			printf("%s: result is different from current loop\n", Resolution[r].name);
+		}
+
+		double base = Measure([&](){ CompositeCurrent(frame1, frameir, frame2, true, out); }, seconds);
+		Report("depth + IR loop", Resolution[r].name, base, base);
+		double us = Measure([&](){ CompositeCurrent(frame1, frameir, frame2, false, out); }, seconds);
+		Report("depth + depth loop", Resolution[r].name, us, base);
+		us = Measure([&](){ CompositeNative(frame1, frameir, frame2, true, mainmap, submap, native1, native2, native); }, seconds);
+		Report("depth + IR native", Resolution[r].name, us, base);
+		us = Measure([&](){ CompositeNative(frame1, frameir, frame2, false, mainmap, submap, native1, native2, native); }, seconds);
+		Report("depth + depth native", Resolution[r].name, us, base);
+	}
+}
+
+#define VIEW3D_WIDTH			(640)			//Width of display of Tof3dViewer_cv
+#define VIEW3D_HEIGHT			(480)			//Height of display of Tof3dViewer_cv
+#define deg2rad(a)				((a) / 180.0 * 3.14159265358979)	//Same as Tof3dViewer_cv.cpp
+
+//Settings of Tof3dViewer_cv
+struct View3d {
+	float angle_x;
+	float angle_y;
+	float dx;
+	float dy;
+	float min_depth;
+	float max_depth;
+	float min_z;
+	float max_z;
+	vector<unsigned short> zbuf;		//cv::Mat z_buffer(CV_16UC1) of Tof3dViewer_cv.cpp(Ver.2.2.0)
+	vector<unsigned char> img;
+
+	View3d(){
+		zbuf.resize(VIEW3D_WIDTH * VIEW3D_HEIGHT);
+		img.resize(VIEW3D_WIDTH * VIEW3D_HEIGHT * 3);
+	}
+};
+
+//Per-pixel loop of Tof3dViewer_cv.cpp(Ver.2.2.0)
+void RotateProjectCurrent(const FrameDepth& frame, const vector<TofPoint>& frame3d, View3d& v)
+{
+	//Initialize matrix (cv::Mat::zeros())
+	memset(&v.zbuf[0], 0, v.zbuf.size() * sizeof(unsigned short));
+	memset(&v.img[0], 0, v.img.size());
+
+	for (int y = 0; y < VIEW3D_HEIGHT; y++){
+		for (int x = 0; x < VIEW3D_WIDTH; x++){
+			int tofx = x * frame.width / VIEW3D_WIDTH;
+			int tofy = y * frame.height / VIEW3D_HEIGHT;
+
+			if ((frame3d[tofy * frame.width + tofx].z >= v.min_depth) && (frame3d[tofy * frame.width + tofx].z <= v.max_depth)){
+				TofPoint point0 = frame3d[tofy * frame.width + tofx];
+				TofPoint point;
+
+				//Rotate X-axis
+				point.x = point0.x;
+				point.y = (float)(point0.y * cos(deg2rad(v.angle_x)) - point0.z * sin(deg2rad(v.angle_x)));
+				point.z = (float)(point0.y * sin(deg2rad(v.angle_x)) + point0.z * cos(deg2rad(v.angle_x)));
+				point0 = point;
+
+				//Rotate Y-axis
+				point.x = (float)(point0.x * cos(deg2rad(v.angle_y)) + point0.z * sin(deg2rad(v.angle_y)));
+				point.y = point0.y;
+				point.z = (float)(-1 * point0.x * sin(deg2rad(v.angle_y)) + point0.z * cos(deg2rad(v.angle_y)));
+
+				point.x = point.x + v.dx;
+				point.y = point.y + v.dy;
+				point.x = point.x / 10 + VIEW3D_WIDTH / 2;
+				point.y = point.y / 10 + VIEW3D_HEIGHT / 2;
+
+				if ((point.x >= 0) && (point.x < VIEW3D_WIDTH) &&
+					(point.y >= 0) && (point.y < VIEW3D_HEIGHT)){
+					if ((point.z >= v.min_z) && (point.z <= v.max_z)){
+						unsigned short& zb = v.zbuf[(int)point.y * VIEW3D_WIDTH + (int)point.x];
+						if ((zb == 0) || (zb > point.z)){
+							zb = (unsigned short)point.z;
+							unsigned short raw = frame.databuf[tofy * frame.width + tofx];
+							unsigned char* d = &v.img[((int)point.y * VIEW3D_WIDTH + (int)point.x) * 3];
+							d[0] = ColorTable[0][raw];
+							d[1] = ColorTable[1][raw];
+							d[2] = ColorTable[2][raw];
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+void BenchRotateProject(double seconds)
+{
+	printf("\n[Tof3dViewer_cv rotate and project]\n");
+
+	View3d view;
+	view.angle_x = 20;
+	view.angle_y = 30;
+	view.dx = 0;
+	view.dy = 0;
+	view.min_depth = 500;
+	view.max_depth = 6000;
+	view.min_z = 0;
+	view.max_z = 6000;
+	for (size_t r = 0; r < sizeof(Resolution) / sizeof(Resolution[0]); r++){
+		Scene scene;
+		MakeScene(scene, Resolution[r].width, Resolution[r].height, 1);
+		FrameDepth frame;
+		MakeDepthFrame(scene, frame);
+		vector<TofPoint> frame3d;
+		MakeFrame3d(scene, frame3d);
+
+		CloudViewParam param;
+		param.angle_x = view.angle_x;
+		param.angle_y = view.angle_y;
+		param.dx = view.dx;
+		param.dy = view.dy;
+		param.min_depth = view.min_depth;
+		param.max_depth = view.max_depth;
+		param.min_z = view.min_z;
+		param.max_z = view.max_z;
+		param.scale = 0.1f;
+		param.splat = 1;
+		param.bdisk = false;
+		CloudView single(VIEW3D_WIDTH, VIEW3D_HEIGHT, 1);
+		CloudView multi(VIEW3D_WIDTH, VIEW3D_HEIGHT);
+		vector<unsigned char> img(VIEW3D_WIDTH * VIEW3D_HEIGHT * 3);
+
+		//Check result (Z of the current loop is truncated to unsigned short, so points of the same Z [mm] may differ)
+		RotateProjectCurrent(frame, frame3d, view);
+		multi.Render(param, &frame3d[0], &frame.databuf[0], frame.width, frame.height, Lut, &img[0], VIEW3D_WIDTH * 3);
+		long diff = 0;
+		for (int i = 0; i < VIEW3D_WIDTH * VIEW3D_HEIGHT; i++){
+			diff += (memcmp(&view.img[i * 3], &img[i * 3], 3) != 0);
+		}
+
+		double base = Measure([&](){ RotateProjectCurrent(frame, frame3d, view); }, seconds);
+		Report("current loop", Resolution[r].name, base, base);
+		double us = Measure([&](){ single.Render(param, &frame3d[0], &frame.databuf[0], frame.width, frame.height, Lut, &img[0], VIEW3D_WIDTH * 3); }, seconds);
+		Report("each point once", Resolution[r].name, us, base);
+		us = Measure([&](){ multi.Render(param, &frame3d[0], &frame.databuf[0], frame.width, frame.height, Lut, &img[0], VIEW3D_WIDTH * 3); }, seconds);
+		char name[64];
+		sprintf(name, "each point once, %d threads", CLOUD_VIEW_THREADS);
+		Report(name, Resolution[r].name, us, base);
+		printf("%-28s %-8s %.2f%% pixels differ from current loop\n", "", "", diff * 100.0 / (VIEW3D_WIDTH * VIEW3D_HEIGHT));
+		param.splat = 2;
+		us = Measure([&](){ single.Render(param, &frame3d[0], &frame.databuf[0], frame.width, frame.height, Lut, &img[0], VIEW3D_WIDTH * 3); }, seconds);
+		Report("each point once, 2x2 points", Resolution[r].name, us, base);
+		param.splat = 5;
+		param.bdisk = true;
+		us = Measure([&](){ single.Render(param, &frame3d[0], &frame.databuf[0], frame.width, frame.height, Lut, &img[0], VIEW3D_WIDTH * 3); }, seconds);
+		Report("each point once, disk 5", Resolution[r].name, us, base);
+		param.splat = 1;
+		param.bdisk = false;
+	}
+}
+
+//Points on a view (x, y, key)
+struct RasterPoints {
+	vector<int> x;
+	vector<int> y;
+	vector<unsigned int> key;
+};
+
+void MakeRasterPoints(RasterPoints& points, int num, int width, int height)
+{
+	srand(1);
+	points.x.resize(num);
+	points.y.resize(num);
+	points.key.resize(num);
+	for (int i = 0; i < num; i++){
+		points.x[i] = rand() % width;
+		points.y[i] = rand() % height;
+		points.key[i] = RasterKey((unsigned int)(rand() % (RASTER_MAX_DEPTH + 1)), (unsigned short)rand());
+	}
+}
+
+//Splat points (bscalar: scalar depth test of each cell)
+void SplatPoints(const RasterPoints& points, const RasterSplat& splat, Raster& raster, bool bscalar, bool batomic)
+{
+	raster.Clear();
+	for (size_t i = 0; i < points.x.size(); i++){
+		if (batomic){
+			raster.SplatAtomic(points.x[i], points.y[i], points.key[i], splat);
+		}
+		else if (bscalar){
+			for (int s = 0; s < splat.spans; s++){
+				int py = points.y[i] + splat.dy[s];
+				for (int px = points.x[i] + splat.x0[s]; px <= points.x[i] + splat.x1[s]; px++){
+					if ((px >= 0) && (px < raster.width) && (py >= 0) && (py < raster.height) && (points.key[i] < raster.cells[py * raster.width + px])){
+						raster.cells[py * raster.width + px] = points.key[i];
+					}
+				}
+			}
+		}
+		else {
+			raster.Splat(points.x[i], points.y[i], points.key[i], splat);
+		}
+	}
+}
+
+void BenchRaster(double seconds)
+{
+	printf("\n[Rasterizer splats] (%s, %d x %d points on %d x %d)\n", TofSimdName(), 640, 480, VIEW3D_WIDTH, VIEW3D_HEIGHT);
+
+	RasterPoints points;
+	MakeRasterPoints(points, 640 * 480, VIEW3D_WIDTH, VIEW3D_HEIGHT);
+	Raster scalar(VIEW3D_WIDTH, VIEW3D_HEIGHT);
+	Raster raster(VIEW3D_WIDTH, VIEW3D_HEIGHT);
+	Raster atomic(VIEW3D_WIDTH, VIEW3D_HEIGHT);
+	struct {
+		int size;
+		bool bdisk;
+		const char* name;
+	} shapes[] = {
+		{ 1, false, "1 pixel" },
+		{ 2, false, "2x2" },
+		{ 3, false, "3x3" },
+		{ 5, true, "disk 5" },
+	};
+	for (size_t n = 0; n < sizeof(shapes) / sizeof(shapes[0]); n++){
+		RasterSplat splat(shapes[n].size, shapes[n].bdisk);
+
+		//Check result
+		SplatPoints(points, splat, scalar, true, false);
+		SplatPoints(points, splat, raster, false, false);
+		SplatPoints(points, splat, atomic, false, true);
+		if ((scalar.cells != raster.cells) || (scalar.cells != atomic.cells)){
+			printf("%s: result is different from scalar depth test\n", shapes[n].name);
+		}
+
+		char name[64];
+		double base = Measure([&](){ SplatPoints(points, splat, scalar, true, false); }, seconds);
+		sprintf(name, "scalar, %s", shapes[n].name);
+		Report(name, "640x480", base, base);
+		double us = Measure([&](){ SplatPoints(points, splat, raster, false, false); }, seconds);
+		sprintf(name, "splat, %s", shapes[n].name);
+		Report(name, "640x480", us, base);
+		us = Measure([&](){ SplatPoints(points, splat, atomic, false, true); }, seconds);
+		sprintf(name, "atomic splat, %s", shapes[n].name);
+		Report(name, "640x480", us, base);
+	}
+}
+
+void BenchEmulator(double seconds)
+{
+	printf("\n[TofEmulator] (%d humans, Depth_Ir, as fast as read)\n", EMULATOR_HUMANS);
+
+	for (size_t r = 0; r < sizeof(Resolution) / sizeof(Resolution[0]); r++){
+		TofEmulator tof;
+		tof.param.timescale = 0;
+		tof.SetCameraMode(CameraMode::Depth_Ir);
+		tof.SetCameraPixel(Resolution[r].pixel);
+		tof.Run();
+
+		FrameDepth frame;
+		FrameIr frameir;
+		FrameHumans framehumans;
+		frame.framenumber = -1;
+		long gaps = 0;
+		long prevno = -1;
+		auto Read = [&](){
+			long frameno;
+			TimeStamp timestamp;
+			tof.GetFrameStatus(&frameno, &timestamp);
+			if (frameno != frame.framenumber){
+				tof.ReadFrame(&frame, &frameir);
+				gaps += (prevno >= 0) && (frame.framenumber != prevno + 1);
+				prevno = frame.framenumber;
+			}
+		};
+
+		//Check result (humans are seen as nearer than floor)
+		Read();
+		tof.ReadFrame(&framehumans);
+		Scene scene;
+		scene.distance_min = frame.distance_min;
+		scene.distance_max = frame.distance_max;
+		long near = 0;
+		for (int i = 0; i < frame.pixel; i++){
+			near += (frame.databuf[i] != MAX_INT16) && (CalculateLength(scene, frame.databuf[i]) < SENSOR_HEIGHT - 300.0f);
+		}
+		printf("%-8s %d humans in view, %.1f%% pixels of humans\n", Resolution[r].name, framehumans.numofhuman, near * 100.0 / frame.pixel);
+		prevno = -1;
+
+		double us = Measure(Read, seconds);
+		Report("depth + IR frame", Resolution[r].name, us, us);
+		if (gaps != 0){
+			printf("%s: frame number is skipped (%ld)\n", Resolution[r].name, gaps);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	//Seconds to measure each case
+	double seconds = 0.5;
+	if (argc > 1){
+		seconds = atof(argv[1]);
+	}
+
+	CreateColorTable(0, 65530);
+
+	BenchProjection(seconds);
+	BenchConvert(seconds);
+	BenchGate(seconds);
+	BenchHumans(seconds);
+	BenchZones(seconds);
+	BenchTripwires(seconds);
+	BenchSection(seconds);
+	BenchColorize(seconds);
+	BenchColorQuantize(seconds);
+	BenchComposite(seconds);
+	BenchIrCopy(seconds);
+	BenchRotateProject(seconds);
+	BenchRaster(seconds);
+	BenchEmulator(seconds);
+
+	return 0;
+}
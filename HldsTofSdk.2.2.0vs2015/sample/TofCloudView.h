@@ -0,0 +1,272 @@
+/**
+* @file			TofCloudView.h
+* @brief		Rotation and projection of a 3D frame to a view (Tof3dViewer_cv)
+* @date			2026.10.16
+* @version		v1.1.1
+*
+* @par Change History:
+* - 2026.10.16 New
+* - 2026.10.16 v1.1.0
+*					- Depth buffers of Raster (TofRasterizer.h), square/disk splats
+* - 2026.10.16 v1.1.1
+*					- Worker threads are started once by the constructor (were started twice in each Render())
+*
+* @remarks
+*	- Each point of the 3D frame is rotated and projected once. The loop of Tof3dViewer_cv (Ver.2.2.0) visited
+*	  every display pixel, converted the same point several times when the display was larger than the frame,
+*	  and called cos()/sin() 8 times per display pixel.
+*	- Render() makes the rotation matrix (X-axis, then Y-axis, same as Tof3dViewer_cv) once per frame.
+*	  The scale (pixels per mm) and the offset to the center of the view are folded into the matrix,
+*	  so a point is 9 multiplies and 8 adds.
+*	- Rows of the frame are split into bands, one band per thread. Each band has its own Raster
+*	  (key of 16 bit fixed-point Z over min_z to max_z and the depth data for color), so threads write without lock.
+*	  The rasters are merged (minimum of keys) and colorized by bands of the view, also in parallel.
+*	- Each point is a splat of CloudViewParam::splat pixels (square or disk), which fills the holes
+*	  between points when the view is zoomed in.
+*	- CLOUD_VIEW_THREADS - 1 worker threads are started once by the constructor and wait on a condition variable
+*	  for each step (project, merge) of Render(). The calling thread works too and waits for the workers at the end of the step.
+*	  A band has at least CLOUD_VIEW_BAND_POINTS points, so small frames are rendered by fewer threads
+*	  (clear and merge of a depth buffer cost more than the points of a small frame).
+*	- No dependency on the SDK DLL, Windows or OpenCV (images are given as raw BGR buffers).
+*/
+#ifndef _hlds_cloudview_H
+#define _hlds_cloudview_H
+
+#include <math.h>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tof.h"
+#include "TofColorizer.h"
+#include "TofRasterizer.h"
+
+#define CLOUD_VIEW_THREADS		(4)				//Threads of Render() (including the calling thread)
+#define CLOUD_VIEW_BAND_POINTS	(32768)			//Min points of a band (320x240: 2 threads, 640x480: 4 threads)
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	View settings (same as the keys of Tof3dViewer_cv)
+	*/
+	struct CloudViewParam {
+		float	angle_x;			///< X angle [degree]
+		float	angle_y;			///< Y angle [degree]
+		float	dx;					///< X shift [mm]
+		float	dy;					///< Y shift [mm]
+		float	min_depth;			///< Min distance from sensor [mm] (Z of the frame)
+		float	max_depth;			///< Max distance from sensor [mm] (Z of the frame)
+		float	min_z;				///< Min Z after rotation [mm]
+		float	max_z;				///< Max Z after rotation [mm]
+		float	scale;				///< Pixels per mm (0.1: 1 pixel is 10mm)
+		int		splat;				///< Size of a point [pixels] (1 to RASTER_MAX_SPLAT)
+		bool	bdisk;				///< Disk splat (false: square)
+	};
+
+	/**
+	* @brief
+	* 	Rotated view of a 3D frame
+	*/
+	class CloudView {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		* @param	w		Width of view
+		* @param	h		Height of view
+		* @param	threads	Number of threads (including the calling thread)
+		*/
+		CloudView(int w, int h, int threads = CLOUD_VIEW_THREADS) : bands(std::max(threads, 1)), workers(std::max(threads, 1) - 1){
+			width = w;
+			height = h;
+			for (size_t b = 0; b < bands.size(); b++){
+				bands[b].Resize(w, h);
+			}
+			job = NULL;
+			jobfunc = NULL;
+			jobnum = 0;
+			jobno = 0;
+			pending = 0;
+			bquit = false;
+			for (size_t t = 0; t < workers.size(); t++){
+				workers[t] = std::thread(&CloudView::Worker, this, (int)t + 1);
+			}
+		};
+
+		/**
+		* @brief
+		* 	Destructor (worker threads are stopped)
+		*/
+		~CloudView(){
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				bquit = true;
+			}
+			start.notify_all();
+			for (size_t t = 0; t < workers.size(); t++){
+				workers[t].join();
+			}
+		}
+
+		/**
+		* @brief
+		* 	Rotate, project and colorize a frame
+		* @param	param		View settings
+		* @param	points		3D points (Frame3d::frame3d)
+		* @param	depth		Depth data of the same frame (FrameMatrix::databuf, for color)
+		* @param	framewidth	Width of the frame
+		* @param	frameheight	Height of the frame
+		* @param	colorlut	Color table
+		* @param	bgr			Output (all pixels are written, pixels without points are black)
+		* @param	step		Bytes per row of the output
+		*/
+		void Render(const CloudViewParam& param, const TofPoint* points, const unsigned short* depth,
+			int framewidth, int frameheight, const ColorLut& colorlut, unsigned char* bgr, size_t step){
+			//Rotation matrix with scale and offset (once per frame)
+			double ax = param.angle_x / 180.0 * 3.14159265358979;
+			double ay = param.angle_y / 180.0 * 3.14159265358979;
+			double s = param.scale;
+			m[0][0] = (float)(cos(ay) * s);
+			m[0][1] = (float)(sin(ay) * sin(ax) * s);
+			m[0][2] = (float)(sin(ay) * cos(ax) * s);
+			m[1][0] = 0;
+			m[1][1] = (float)(cos(ax) * s);
+			m[1][2] = (float)(-sin(ax) * s);
+			m[2][0] = (float)(-sin(ay));
+			m[2][1] = (float)(cos(ay) * sin(ax));
+			m[2][2] = (float)(cos(ay) * cos(ax));
+			ox = (float)(param.dx * s + width / 2.0);
+			oy = (float)(param.dy * s + height / 2.0);
+			zscale = (param.max_z > param.min_z) ? RASTER_MAX_DEPTH / (param.max_z - param.min_z) : 0;
+			if ((splat.size != param.splat) || (splat.bdisk != param.bdisk)){
+				splat.Set(param.splat, param.bdisk);
+			}
+
+			int num = std::min((int)bands.size(), std::max(1, framewidth * frameheight / CLOUD_VIEW_BAND_POINTS));
+			Parallel(num, [&](int b){
+				Project(bands[b], param, points, depth, framewidth, frameheight * b / num, frameheight * (b + 1) / num);
+			});
+			Parallel(num, [&](int b){
+				Merge(num, colorlut, bgr, step, height * b / num, height * (b + 1) / num);
+			});
+		}
+
+	private:
+		int		width;
+		int		height;
+		std::vector<Raster> bands;			//Depth buffer of each band (key: fixed-point Z | depth data)
+		std::vector<std::thread> workers;	//Worker thread of bands 1 to threads - 1
+		std::mutex lock;					//Lock of the job (below)
+		std::condition_variable start;		//A job is given to the workers
+		std::condition_variable done;		//All workers finished the job
+		void	(*job)(void*, int);			//Job of a band (calls jobfunc)
+		void*	jobfunc;					//Function of Parallel()
+		int		jobnum;						//Number of bands of the job
+		unsigned int jobno;					//Serial number of the job
+		int		pending;					//Workers not finished the job
+		bool	bquit;						//Workers are stopped
+		RasterSplat splat;
+		float	m[3][3];					//Rotation (rows 0 and 1 are multiplied by scale)
+		float	ox;							//Offset of X on the view
+		float	oy;							//Offset of Y on the view
+		float	zscale;						//Fixed-point Z per mm
+
+		//Call a function of Parallel()
+		template <class Func>
+		static void Call(void* func, int band){
+			(*(Func*)func)(band);
+		}
+
+		//Run func(band) for bands 0 to num - 1 (band 0 by the calling thread, others by the workers)
+		template <class Func>
+		void Parallel(int num, Func func){
+			if (num <= 1){
+				func(0);
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> guard(lock);
+				job = &Call<Func>;
+				jobfunc = &func;
+				jobnum = num;
+				jobno++;
+				pending = (int)workers.size();
+			}
+			start.notify_all();
+			func(0);
+			std::unique_lock<std::mutex> guard(lock);
+			while (pending > 0){
+				done.wait(guard);
+			}
+		}
+
+		//Worker thread of a band (1 to threads - 1)
+		void Worker(int band){
+			unsigned int last = 0;
+			std::unique_lock<std::mutex> guard(lock);
+			while (true){
+				while (!bquit && (jobno == last)){
+					start.wait(guard);
+				}
+				if (bquit){
+					return;
+				}
+				last = jobno;
+				if (band < jobnum){
+					guard.unlock();
+					job(jobfunc, band);
+					guard.lock();
+				}
+				pending--;
+				if (pending == 0){
+					done.notify_one();
+				}
+			}
+		}
+
+		//Rotate and project rows [row0, row1) of the frame into a band
+		void Project(Raster& band, const CloudViewParam& param, const TofPoint* points, const unsigned short* depth,
+			int framewidth, int row0, int row1){
+			band.Clear();
+			for (int i = row0 * framewidth; i < row1 * framewidth; i++){
+				const TofPoint& p = points[i];
+				if ((p.z < param.min_depth) || (p.z > param.max_depth)){
+					continue;
+				}
+				float x = m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + ox;
+				float y = m[1][1] * p.y + m[1][2] * p.z + oy;
+				if ((x < 0) || (x >= width) || (y < 0) || (y >= height)){
+					continue;
+				}
+				float z = m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z;
+				if ((z < param.min_z) || (z > param.max_z)){
+					continue;
+				}
+				band.Splat((int)x, (int)y, RasterKey(RasterDepth(z, param.min_z, zscale), depth[i]), splat);
+			}
+		}
+
+		//Merge bands 0 to num - 1 into band 0 and colorize rows [row0, row1) of the view
+		void Merge(int num, const ColorLut& colorlut, unsigned char* bgr, size_t step, int row0, int row1){
+			for (int b = 1; b < num; b++){
+				bands[0].Merge(bands[b], row0, row1);
+			}
+			for (int y = row0; y < row1; y++){
+				const unsigned int* cell = &bands[0].cells[y * width];
+				unsigned char* d = bgr + y * step;
+				for (int x = 0; x < width; x++){
+					PutColor(d + x * 3, (cell[x] != RASTER_EMPTY) ? colorlut[(unsigned short)cell[x]] : 0);
+				}
+			}
+		}
+
+		CloudView(const CloudView&);
+		CloudView& operator=(const CloudView&);
+	};
+
+}
+
+#endif //_hlds_cloudview_H
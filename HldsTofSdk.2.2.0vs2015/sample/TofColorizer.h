@@ -0,0 +1,328 @@
+/**
+* @file			TofColorizer.h
+* @brief		Packed color table and colorization of depth frames for the viewers
+* @date			2026.10.16
+* @version		v1.2.1
+*
+* @par Change History:
+* - 2026.10.16 New
+* - 2026.10.16 v1.1.0
+*					- Quantized table (speed mode)
+* - 2026.10.16 v1.2.0
+*					- Colorize with horizontal mirror in one pass (ColorizeMirror())
+*					- Colorize into an image of other size by nearest neighbour (ColorizeImage())
+* - 2026.10.16 v1.2.1
+*					- Invalid data (0xffff) has its own entry of the quantized table (the last range was drawn in its color)
+*
+* @remarks
+*	- FrameDepth::ColorTable[3][65536] has a table for each channel, so a pixel needs 3 lookups
+*	  from 3 tables of 64KB. ColorLut packs the 3 channels into a 32 bit entry (ch0 | ch1 << 8 | ch2 << 16),
+*	  so a pixel is one lookup.
+*	- Build() packs the table made by FrameDepth::CreateColorTable(min, range). Call it again only if
+*	  CreateColorTable() is called again.
+*	- Colorize() converts depth data into BGR 8bit x 3 (data of a continuous CV_8UC3 Mat).
+*	  8 (AVX2, gather) or 4 (SSE4.1) pixels are looked up and packed into 24 or 12 bytes at once.
+*	- SetQuantize(bits) selects the speed mode: the table has 2^bits + 1 entries (16KB for 12 bits, fits in L1 cache)
+*	  indexed by depth >> (16 - bits). Each entry is the color of the center of its range, so only the gradation
+*	  becomes coarse. Invalid data (0xffff) is counted as 0x10000 (LutIndex()), so its color is the extra last entry
+*	  and valid data of the last range (e.g. 0xfff0 to 0xfffe for 12 bits) keeps its own color.
+*	  SetQuantize(0) returns to the full table (quality mode).
+*	- ColorizeMirror() reads each row from the end (8 or 4 pixels are loaded and reversed at once), so
+*	  the mirrored picture of Tof2dViewer needs no other buffer or pass.
+*	- ColorizeImage() writes into any image with row step (e.g. ROI of a tile of a mosaic). If the size differs
+*	  from the frame, pixels are picked by nearest neighbour and repeated rows are copied.
+*	- No dependency on the SDK DLL, Windows or OpenCV (images are given as raw BGR buffers).
+*/
+#ifndef _hlds_colorizer_H
+#define _hlds_colorizer_H
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "tof.h"
+#include "TofSimd.h"
+
+#define COLOR_LUT_FAST_BITS		(12)			//Bits of depth for the quantized table of speed mode (4096 entries)
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Write a packed color to a BGR pixel
+	*/
+	inline void PutColor(unsigned char* d, unsigned int color)
+	{
+		d[0] = (unsigned char)color;
+		d[1] = (unsigned char)(color >> 8);
+		d[2] = (unsigned char)(color >> 16);
+	}
+
+	/**
+	* @brief
+	* 	Index of a packed table of depth >> shift (0xffff is counted as 0x10000, the entry after the last range)
+	*/
+	inline unsigned int LutIndex(unsigned short depth, int shift)
+	{
+		return ((unsigned int)depth + (depth == MAX_INT16)) >> shift;
+	}
+
+	/**
+	* @brief
+	* 	Packed color table
+	*/
+	class ColorLut {
+	public:
+		std::vector<unsigned int> lut;		///< Color of each depth data (ch0 | ch1 << 8 | ch2 << 16, entry 0x10000: invalid data)
+		std::vector<unsigned int> qlut;		///< Quantized table (index: LutIndex(), last entry: invalid data)
+
+		/**
+		* @brief
+		* 	Constructor (all black, quality mode)
+		*/
+		ColorLut() : lut(MAX_INT16 + 2, 0){
+			bits = 0;
+			shift = 0;
+		};
+
+		/**
+		* @brief
+		* 	Pack a color table
+		* @param	colortable	Color table (FrameDepth::ColorTable after FrameDepth::CreateColorTable())
+		*/
+		void Build(const unsigned char (*colortable)[MAX_INT16 + 1]){
+			for (int i = 0; i <= MAX_INT16; i++){
+				lut[i] = colortable[0][i] | (colortable[1][i] << 8) | (colortable[2][i] << 16);
+			}
+			lut[MAX_INT16 + 1] = lut[MAX_INT16];
+			BuildQuantized();
+		}
+
+		/**
+		* @brief
+		* 	Select quality or speed mode
+		* @param	qbits	Bits of depth used for the color (8 to 15: speed mode, 0 or 16: quality mode)
+		*/
+		void SetQuantize(int qbits){
+			if ((qbits <= 0) || (qbits >= 16)){
+				//qlut is kept for the next speed mode
+				bits = 0;
+				shift = 0;
+				return;
+			}
+			bits = std::max(qbits, 8);
+			shift = 16 - bits;
+			BuildQuantized();
+		}
+
+		/**
+		* @brief
+		* 	Bits of the quantized table (0: quality mode)
+		*/
+		int Quantize(void) const {
+			return bits;
+		}
+
+		/**
+		* @brief
+		* 	Packed color of depth data
+		*/
+		unsigned int operator[](unsigned short depth) const {
+			if (bits == 0){
+				return lut[depth];
+			}
+			return qlut[LutIndex(depth, shift)];
+		}
+
+		/**
+		* @brief
+		* 	Convert depth data to BGR
+		* @param	depth	Depth data (FrameMatrix::databuf)
+		* @param	num		Number of pixels
+		* @param	bgr		Output (num x 3 bytes)
+		*/
+		void Colorize(const unsigned short* depth, int num, unsigned char* bgr) const {
+			if (bits != 0){
+				ColorizeQuantized(depth, num, bgr);
+				return;
+			}
+			const unsigned int* table = &lut[0];
+			int i = 0;
+#if defined(TOF_SIMD_AVX2)
+			//Remove 4th byte of each entry and put 8 entries together in 24 bytes
+			const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+				0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+			const __m256i perm = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+			//32 bytes are stored (8 bytes over are overwritten by the next pixels)
+			for (; i + 11 <= num; i += 8){
+				__m256i index = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(depth + i)));
+				__m256i color = _mm256_i32gather_epi32((const int*)table, index, 4);
+				color = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(color, pack), perm);
+				_mm256_storeu_si256((__m256i*)(bgr + i * 3), color);
+			}
+#elif defined(TOF_SIMD_SSE4)
+			const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+			//16 bytes are stored (4 bytes over are overwritten by the next pixels)
+			for (; i + 6 <= num; i += 4){
+				__m128i color = _mm_setr_epi32((int)table[depth[i]], (int)table[depth[i + 1]], (int)table[depth[i + 2]], (int)table[depth[i + 3]]);
+				_mm_storeu_si128((__m128i*)(bgr + i * 3), _mm_shuffle_epi8(color, pack));
+			}
+#endif
+			for (; i < num; i++){
+				PutColor(bgr + i * 3, table[depth[i]]);
+			}
+		}
+
+		/**
+		* @brief
+		* 	Convert depth data to BGR with horizontal mirror
+		* @param	depth	Depth data (FrameMatrix::databuf)
+		* @param	width	Width of the frame
+		* @param	height	Height of the frame
+		* @param	bgr		Output (width x height x 3 bytes in each row)
+		* @param	step	Bytes per row of the output
+		*/
+		void ColorizeMirror(const unsigned short* depth, int width, int height, unsigned char* bgr, size_t step) const {
+			const unsigned int* table = (bits == 0) ? &lut[0] : &qlut[0];
+#if defined(TOF_SIMD_AVX2)
+			const __m128i reverse = _mm_setr_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+			const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+				0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+			const __m256i perm = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+			const __m128i count = _mm_cvtsi32_si128(shift);
+			const __m256i invalid = _mm256_set1_epi32(MAX_INT16);
+#elif defined(TOF_SIMD_SSE4)
+			const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+#endif
+			for (int y = 0; y < height; y++){
+				//Pixel j of output is pixel (width - j - 1) of the frame
+				const unsigned short* end = depth + (size_t)y * width + width - 1;
+				unsigned char* d = bgr + y * step;
+				int j = 0;
+#if defined(TOF_SIMD_AVX2)
+				for (; j + 11 <= width; j += 8){
+					__m128i raw = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(end - j - 7)), reverse);
+					__m256i index = _mm256_cvtepu16_epi32(raw);
+					//0xffff -> 0x10000 (cmpeq is -1)
+					index = _mm256_srl_epi32(_mm256_sub_epi32(index, _mm256_cmpeq_epi32(index, invalid)), count);
+					__m256i color = _mm256_i32gather_epi32((const int*)table, index, 4);
+					color = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(color, pack), perm);
+					_mm256_storeu_si256((__m256i*)(d + j * 3), color);
+				}
+#elif defined(TOF_SIMD_SSE4)
+				for (; j + 6 <= width; j += 4){
+					__m128i color = _mm_setr_epi32((int)table[LutIndex(end[-j], shift)], (int)table[LutIndex(end[-j - 1], shift)],
+						(int)table[LutIndex(end[-j - 2], shift)], (int)table[LutIndex(end[-j - 3], shift)]);
+					_mm_storeu_si128((__m128i*)(d + j * 3), _mm_shuffle_epi8(color, pack));
+				}
+#endif
+				for (; j < width; j++){
+					PutColor(d + j * 3, table[LutIndex(end[-j], shift)]);
+				}
+			}
+		}
+
+		/**
+		* @brief
+		* 	Convert depth data to BGR image of any size (nearest neighbour)
+		* @param	depth		Depth data (FrameMatrix::databuf)
+		* @param	width		Width of the frame
+		* @param	height		Height of the frame
+		* @param	bmirror		Horizontal mirror
+		* @param	bgr			Output image
+		* @param	step		Bytes per row of the output
+		* @param	bgrwidth	Width of the output
+		* @param	bgrheight	Height of the output
+		*/
+		void ColorizeImage(const unsigned short* depth, int width, int height, bool bmirror,
+			unsigned char* bgr, size_t step, int bgrwidth, int bgrheight) const {
+			if ((width == bgrwidth) && (height == bgrheight)){
+				if (bmirror){
+					ColorizeMirror(depth, width, height, bgr, step);
+				}
+				else {
+					for (int y = 0; y < height; y++){
+						Colorize(depth + (size_t)y * width, width, bgr + y * step);
+					}
+				}
+				return;
+			}
+			const unsigned int* table = (bits == 0) ? &lut[0] : &qlut[0];
+			int lasty = -1;
+			for (int y = 0; y < bgrheight; y++){
+				unsigned char* d = bgr + y * step;
+				int sy = y * height / bgrheight;
+				if (sy == lasty){
+					//Same row of the frame
+					memcpy(d, d - step, bgrwidth * 3);
+					continue;
+				}
+				lasty = sy;
+				const unsigned short* row = depth + (size_t)sy * width;
+				//Pixel x of output is pixel (x * width / bgrwidth) of the frame, one lookup for each pixel of the frame
+				int x = 0;
+				for (int sx = 0; sx < width; sx++){
+					int xend = ((sx + 1) * bgrwidth + width - 1) / width;
+					if (x >= xend){
+						continue;
+					}
+					unsigned int color = table[LutIndex(bmirror ? row[width - sx - 1] : row[sx], shift)];
+					for (; x < xend; x++){
+						PutColor(d + x * 3, color);
+					}
+				}
+			}
+		}
+
+	private:
+		int		bits;						//Bits of the quantized table (0: quality mode)
+		int		shift;						//16 - bits
+
+		//Color of the center of each range (the extra last entry is the color of 0xffff)
+		void BuildQuantized(void){
+			if (bits == 0){
+				return;
+			}
+			int size = 1 << bits;
+			qlut.resize(size + 1);
+			for (int q = 0; q < size; q++){
+				qlut[q] = lut[(q << shift) + (1 << (shift - 1))];
+			}
+			qlut[size] = lut[MAX_INT16];
+		}
+
+		//Colorize() of speed mode
+		void ColorizeQuantized(const unsigned short* depth, int num, unsigned char* bgr) const {
+			const unsigned int* table = &qlut[0];
+			int i = 0;
+#if defined(TOF_SIMD_AVX2)
+			const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+				0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+			const __m256i perm = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+			const __m128i count = _mm_cvtsi32_si128(shift);
+			const __m256i invalid = _mm256_set1_epi32(MAX_INT16);
+			for (; i + 11 <= num; i += 8){
+				__m256i index = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(depth + i)));
+				//0xffff -> 0x10000 (cmpeq is -1)
+				index = _mm256_srl_epi32(_mm256_sub_epi32(index, _mm256_cmpeq_epi32(index, invalid)), count);
+				__m256i color = _mm256_i32gather_epi32((const int*)table, index, 4);
+				color = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(color, pack), perm);
+				_mm256_storeu_si256((__m256i*)(bgr + i * 3), color);
+			}
+#elif defined(TOF_SIMD_SSE4)
+			const __m128i pack = _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+			for (; i + 6 <= num; i += 4){
+				__m128i color = _mm_setr_epi32((int)table[LutIndex(depth[i], shift)], (int)table[LutIndex(depth[i + 1], shift)],
+					(int)table[LutIndex(depth[i + 2], shift)], (int)table[LutIndex(depth[i + 3], shift)]);
+				_mm_storeu_si128((__m128i*)(bgr + i * 3), _mm_shuffle_epi8(color, pack));
+			}
+#endif
+			for (; i < num; i++){
+				PutColor(bgr + i * 3, table[LutIndex(depth[i], shift)]);
+			}
+		}
+	};
+
+}
+
+#endif //_hlds_colorizer_H
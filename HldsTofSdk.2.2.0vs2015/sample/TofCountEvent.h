@@ -0,0 +1,115 @@
+/**
+* @file			TofCountEvent.h
+* @brief		Events of human count
+* @date			2026.10.16
+* @version		v1.2.0
+*
+* @par Change History:
+* - 2026.10.16 New
+* - 2026.10.16 v1.1.0
+*	- Zone number of count zones (TofCountZone.h)
+* - 2026.10.16 v1.2.0
+*	- Crossing of tripwires (TofTripwire.h)
+*
+* @remarks
+*	- One event is made when a count is changed (enter, exit, and cancel of a previous enter or exit).
+*	- FormatCountEvent() makes one line of JSON for an event, so that events can be passed to other
+*	  programs through standard output or a file.
+*/
+#ifndef _hlds_countevent_H
+#define _hlds_countevent_H
+
+#include <stdio.h>
+#include <string>
+
+#include "tof.h"
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Type of count event
+	*/
+	enum class CountEventType {
+		Enter = 0,			///< Entered to the area
+		Exit,				///< Exited from the area
+		CancelEnter,		///< Previous enter of the human is canceled (the human entered again)
+		CancelExit,			///< Previous exit of the human is canceled (the human exited again)
+		CrossIn,			///< Crossed a tripwire from the left side to the right side
+		CrossOut,			///< Crossed a tripwire from the right side to the left side
+	};
+
+	/**
+	* @brief
+	* 	Count event
+	*/
+	struct CountEvent {
+		TimeStamp timestamp;		///< Timestamp of the frame (UTC)
+		long	framenumber;		///< Frame number of the frame
+		int		appid;				///< Human ID managed in application
+		long	id;					///< Human ID managed in SDK
+		int		zone;				///< Zone (0: count area, 1 to number of zones: count zones), tripwire number (1 to) of CrossIn/CrossOut
+		CountEventType type;		///< Type
+		int		direction;			///< Direction (0: up, 1: right, 2: down, 3: left, -1: none)
+		float	x;					///< X-coordinate of the human [mm]
+		float	y;					///< Y-coordinate of the human [mm]
+	};
+
+	/**
+	* @brief
+	* 	Name of event type
+	*/
+	inline const char* CountEventName(CountEventType type)
+	{
+		switch (type){
+		case CountEventType::Enter:
+			return "enter";
+		case CountEventType::Exit:
+			return "exit";
+		case CountEventType::CancelEnter:
+			return "cancel_enter";
+		case CountEventType::CancelExit:
+			return "cancel_exit";
+		case CountEventType::CrossIn:
+			return "cross_in";
+		case CountEventType::CrossOut:
+			return "cross_out";
+		}
+		return "unknown";
+	}
+
+	/**
+	* @brief
+	* 	Name of direction
+	*/
+	inline const char* CountDirectionName(int direction)
+	{
+		static const char* names[4] = { "up", "right", "down", "left" };
+		if ((direction < 0) || (direction >= 4)){
+			return "none";
+		}
+		return names[direction];
+	}
+
+	/**
+	* @brief
+	* 	Make one line of JSON (without line feed)
+	* @param	event	Event
+	* @return	JSON
+	*/
+	inline std::string FormatCountEvent(const CountEvent& event)
+	{
+		char buff[256];
+		snprintf(buff, sizeof(buff),
+			"{\"time\":\"%04d-%02d-%02dT%02d:%02d:%02d.%03dZ\",\"frame\":%ld,\"appid\":%d,\"id\":%ld,"
+			"\"zone\":%d,\"event\":\"%s\",\"dir\":\"%s\",\"x\":%.0f,\"y\":%.0f}",
+			event.timestamp.year, event.timestamp.month, event.timestamp.day,
+			event.timestamp.hour, event.timestamp.minute, event.timestamp.second, event.timestamp.msecond,
+			event.framenumber, event.appid, event.id, event.zone,
+			CountEventName(event.type), CountDirectionName(event.direction), event.x, event.y);
+		return buff;
+	}
+
+}
+
+#endif //_hlds_countevent_H
@@ -0,0 +1,367 @@
+/**
+* @file			TofCountHistory.h
+* @brief		Counts of each minute, hour and day in fixed rings
+* @date			2026.10.16
+* @version		v1.0.0
+*
+* @par Change History:
+* - 2026.10.16 New
+*
+* @remarks
+*	- Enter[4], Exit[4] and max number of humans in the count area are kept for each minute (last 24 hours),
+*	  each hour (last 7 days) and each day (last 366 days) of the frame timestamp (UTC).
+*	- Only one thread (the counting thread) writes by Add(). It never waits for readers.
+*	- Any thread reads by Snapshot(). Each ring has a sequence number (seqlock), which is odd while
+*	  the ring is written. A reader copies the ring and copies again if the number was odd or changed,
+*	  so a snapshot is always consistent. Fields are atomic (relaxed), so there is no data race.
+*	- Counts are not reset by reset of the counter of the application (InitializeCount()).
+*/
+#ifndef _hlds_counthistory_H
+#define _hlds_counthistory_H
+
+#include <stdio.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "TofCountEvent.h"
+
+#define COUNTHISTORY_MINUTES	(1440)			//Buckets of minutes (24 hours)
+#define COUNTHISTORY_HOURS		(168)			//Buckets of hours (7 days)
+#define COUNTHISTORY_DAYS		(366)			//Buckets of days
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Period of a bucket
+	*/
+	enum class CountPeriod {
+		Minute = 0,			///< 1 minute
+		Hour,				///< 1 hour
+		Day,				///< 1 day
+	};
+
+	/**
+	* @brief
+	* 	Counts of a period
+	*/
+	struct CountBucket {
+		long long start;			///< Start of the period (periods from 1970-01-01 00:00 UTC)
+		int		Enter[4];			///< Humans who enter to the area from each direction
+		int		Exit[4];			///< Humans who exit from the area to each direction
+		int		TotalEnter;			///< Total number of humans entering
+		int		TotalExit;			///< Total number of humans exiting
+		int		InArea;				///< Max number of humans in the area
+	};
+
+	/**
+	* @brief
+	* 	Days from 1970-01-01 of a date
+	*/
+	inline long long DaysFromCivil(int year, int month, int day)
+	{
+		year -= (month <= 2);
+		long long era = (year >= 0 ? year : year - 399) / 400;
+		int yoe = (int)(year - era * 400);
+		int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+		int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+		return era * 146097 + doe - 719468;
+	}
+
+	/**
+	* @brief
+	* 	Date of days from 1970-01-01
+	*/
+	inline void CivilFromDays(long long days, int& year, int& month, int& day)
+	{
+		days += 719468;
+		long long era = (days >= 0 ? days : days - 146096) / 146097;
+		int doe = (int)(days - era * 146097);
+		int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+		int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+		int mp = (5 * doy + 2) / 153;
+		day = doy - (153 * mp + 2) / 5 + 1;
+		month = mp + (mp < 10 ? 3 : -9);
+		year = (int)(yoe + era * 400) + (month <= 2);
+	}
+
+	/**
+	* @brief
+	* 	Minutes from 1970-01-01 00:00 of a timestamp (-1: before 1970 or no timestamp)
+	*/
+	inline long long TimeStampMinutes(const TimeStamp& timestamp)
+	{
+		if ((timestamp.year < 1970) || (timestamp.month < 1) || (timestamp.month > 12)){
+			return -1;
+		}
+		return DaysFromCivil(timestamp.year, timestamp.month, timestamp.day) * 1440 + timestamp.hour * 60 + timestamp.minute;
+	}
+
+	/**
+	* @brief
+	* 	Text of the start of a period ("2026-10-16T10:05Z")
+	*/
+	inline std::string FormatPeriod(CountPeriod period, long long start)
+	{
+		long long minutes = start;
+		if (period == CountPeriod::Hour){
+			minutes = start * 60;
+		}
+		else if (period == CountPeriod::Day){
+			minutes = start * 1440;
+		}
+		long long days = minutes / 1440;
+		int minute = (int)(minutes % 1440);
+		int year, month, day;
+		CivilFromDays(days, year, month, day);
+		char buff[64];
+		snprintf(buff, sizeof(buff), "%04d-%02d-%02dT%02d:%02dZ", year, month, day, minute / 60, minute % 60);
+		return buff;
+	}
+
+	/**
+	* @brief
+	* 	Counts of each minute, hour and day
+	*/
+	class CountHistory {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		*/
+		CountHistory(){
+			rings[(int)CountPeriod::Minute].Initialize(COUNTHISTORY_MINUTES, 1);
+			rings[(int)CountPeriod::Hour].Initialize(COUNTHISTORY_HOURS, 60);
+			rings[(int)CountPeriod::Day].Initialize(COUNTHISTORY_DAYS, 1440);
+		};
+
+		/**
+		* @brief
+		* 	Number of buckets of a period
+		*/
+		int Size(CountPeriod period) const {
+			return rings[(int)period].size;
+		}
+
+		/**
+		* @brief
+		* 	Add counts of a frame (counting thread only)
+		* @param	timestamp	Timestamp of the frame
+		* @param	events		Count events of the frame (events of zone 0 are counted)
+		* @param	num			Number of events
+		* @param	inarea		Number of humans in the area
+		*/
+		void Add(const TimeStamp& timestamp, const CountEvent* events, int num, int inarea){
+			//Changes of counts
+			int enter[4] = { 0, 0, 0, 0 };
+			int exit[4] = { 0, 0, 0, 0 };
+			for (int eno = 0; eno < num; eno++){
+				const CountEvent& event = events[eno];
+				if ((event.zone != 0) || (event.direction < 0) || (event.direction >= 4)){
+					continue;
+				}
+				switch (event.type){
+				case CountEventType::Enter:
+					enter[event.direction]++;
+					break;
+				case CountEventType::CancelEnter:
+					enter[event.direction]--;
+					break;
+				case CountEventType::Exit:
+					exit[event.direction]++;
+					break;
+				case CountEventType::CancelExit:
+					exit[event.direction]--;
+					break;
+				default:
+					break;
+				}
+			}
+
+			long long minutes = TimeStampMinutes(timestamp);
+			for (int level = 0; level < 3; level++){
+				rings[level].Add(minutes, enter, exit, inarea);
+			}
+		}
+
+		/**
+		* @brief
+		* 	Copy buckets of a period (any thread, never blocks the counting thread)
+		* @param	period	Period
+		* @param	out		Output (Size(period) buckets), from the oldest to the newest
+		* @return	Number of buckets
+		*/
+		int Snapshot(CountPeriod period, CountBucket* out) const {
+			return rings[(int)period].Snapshot(out);
+		}
+
+		/**
+		* @brief
+		* 	Write all buckets as CSV (any thread)
+		* @return	true: OK
+		*/
+		bool WriteCsv(const char* filename) const {
+			FILE* fp = fopen(filename, "w");
+			if (fp == NULL){
+				return false;
+			}
+			static const char* names[3] = { "minute", "hour", "day" };
+			fprintf(fp, "period,start,enter_up,enter_right,enter_down,enter_left,exit_up,exit_right,exit_down,exit_left,"
+				"total_enter,total_exit,in_area_max\n");
+			std::vector<CountBucket> buckets(COUNTHISTORY_MINUTES);
+			for (int level = 0; level < 3; level++){
+				CountPeriod period = (CountPeriod)level;
+				int num = Snapshot(period, &buckets[0]);
+				for (int bno = 0; bno < num; bno++){
+					const CountBucket& b = buckets[bno];
+					fprintf(fp, "%s,%s,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d\n", names[level], FormatPeriod(period, b.start).c_str(),
+						b.Enter[0], b.Enter[1], b.Enter[2], b.Enter[3], b.Exit[0], b.Exit[1], b.Exit[2], b.Exit[3],
+						b.TotalEnter, b.TotalExit, b.InArea);
+				}
+			}
+			bool bok = (ferror(fp) == 0);
+			fclose(fp);
+			return bok;
+		}
+
+	private:
+		//Bucket written by the counting thread
+		struct AtomicBucket {
+			std::atomic<long long> start;		//-1: not used
+			std::atomic<int> enter[4];
+			std::atomic<int> exit[4];
+			std::atomic<int> inarea;
+		};
+
+		//Ring of buckets of a period
+		struct Ring {
+			int		size;							//Number of buckets
+			int		minutes;						//Minutes of a bucket
+			long long newest;						//Start of the newest bucket (-1: none, writer only)
+			std::atomic<unsigned int> seq;			//Sequence (odd: writing)
+			std::vector<AtomicBucket> buckets;
+
+			void Initialize(int size, int minutes){
+				this->size = size;
+				this->minutes = minutes;
+				newest = -1;
+				seq.store(0, std::memory_order_relaxed);
+				std::vector<AtomicBucket> b(size);
+				buckets.swap(b);
+				for (int bno = 0; bno < size; bno++){
+					Clear(buckets[bno], -1);
+				}
+			}
+
+			static void Clear(AtomicBucket& b, long long start){
+				b.start.store(start, std::memory_order_relaxed);
+				for (int dir = 0; dir < 4; dir++){
+					b.enter[dir].store(0, std::memory_order_relaxed);
+					b.exit[dir].store(0, std::memory_order_relaxed);
+				}
+				b.inarea.store(0, std::memory_order_relaxed);
+			}
+
+			void Add(long long time, const int* enter, const int* exit, int inarea){
+				if (time < 0){
+					//No timestamp
+					return;
+				}
+				long long start = time / minutes;
+				if ((newest >= 0) && (start <= newest - size)){
+					//Older than the ring (clock was set back)
+					return;
+				}
+
+				unsigned int s = seq.load(std::memory_order_relaxed);
+				seq.store(s + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+
+				if ((newest < 0) || (start > newest)){
+					//New periods (periods without frames are cleared also)
+					long long first = (newest < 0) ? start : newest + 1;
+					if (start - first >= size){
+						first = start - size + 1;
+					}
+					for (long long p = first; p <= start; p++){
+						Clear(buckets[(size_t)(p % size)], p);
+					}
+					newest = start;
+				}
+
+				AtomicBucket& b = buckets[(size_t)(start % size)];
+				for (int dir = 0; dir < 4; dir++){
+					if (enter[dir] != 0){
+						b.enter[dir].store(b.enter[dir].load(std::memory_order_relaxed) + enter[dir], std::memory_order_relaxed);
+					}
+					if (exit[dir] != 0){
+						b.exit[dir].store(b.exit[dir].load(std::memory_order_relaxed) + exit[dir], std::memory_order_relaxed);
+					}
+				}
+				if (inarea > b.inarea.load(std::memory_order_relaxed)){
+					b.inarea.store(inarea, std::memory_order_relaxed);
+				}
+
+				seq.store(s + 2, std::memory_order_release);
+			}
+
+			int Snapshot(CountBucket* out) const {
+				for (;;){
+					unsigned int s1 = seq.load(std::memory_order_acquire);
+					if (s1 & 1){
+						//Being written
+						std::this_thread::yield();
+						continue;
+					}
+
+					//Newest bucket has the largest start
+					int num = 0;
+					long long last = -1;
+					int lastno = 0;
+					for (int bno = 0; bno < size; bno++){
+						long long start = buckets[bno].start.load(std::memory_order_relaxed);
+						if (start > last){
+							last = start;
+							lastno = bno;
+						}
+					}
+					if (last >= 0){
+						for (int n = 1; n <= size; n++){
+							const AtomicBucket& b = buckets[(lastno + n) % size];
+							CountBucket& o = out[num];
+							o.start = b.start.load(std::memory_order_relaxed);
+							if (o.start < 0){
+								continue;
+							}
+							o.TotalEnter = 0;
+							o.TotalExit = 0;
+							for (int dir = 0; dir < 4; dir++){
+								o.Enter[dir] = b.enter[dir].load(std::memory_order_relaxed);
+								o.Exit[dir] = b.exit[dir].load(std::memory_order_relaxed);
+								o.TotalEnter += o.Enter[dir];
+								o.TotalExit += o.Exit[dir];
+							}
+							o.InArea = b.inarea.load(std::memory_order_relaxed);
+							num++;
+						}
+					}
+
+					std::atomic_thread_fence(std::memory_order_acquire);
+					if (seq.load(std::memory_order_relaxed) == s1){
+						return num;
+					}
+				}
+			}
+		};
+
+		Ring	rings[3];						//Rings of minutes, hours and days
+
+		CountHistory(const CountHistory&);
+		CountHistory& operator=(const CountHistory&);
+	};
+
+}
+
+#endif //_hlds_counthistory_H
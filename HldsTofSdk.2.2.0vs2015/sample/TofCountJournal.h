@@ -0,0 +1,665 @@
+/**
+* @file			TofCountJournal.h
+* @brief		Append-only binary journal of count events and its memory mapped reader
+* @date			2026.10.16
+* @version		v1.0.0
+*
+* @par Change History:
+* - 2026.10.16 New
+*
+* @remarks
+*	- CountJournal: The counting thread puts each count event as a fixed size record (32 bytes) into
+*	  a lock-free ring (Append()). It never waits. When the ring is full the record is dropped and counted.
+*	  A background thread writes records to segment files "<base>.000000.cej", "<base>.000001.cej", ...
+*	- A new segment is started when a segment has JOURNAL_SEGMENT_RECORDS records, or when the time of
+*	  a record is older than the previous record (clock of the sensor is set). So records in a segment
+*	  are always in order of time.
+*	- CountJournalReader: Maps all segments to memory and finds records of a time range by binary search
+*	  of each segment, without reading the files. Open() again to see records written after Open().
+*	- Records are written in little endian of the machine. A partial record at the end of a segment
+*	  (the program was stopped while writing) is ignored.
+*/
+#ifndef _hlds_countjournal_H
+#define _hlds_countjournal_H
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "TofCountEvent.h"
+#include "TofCountHistory.h"
+#include "TofPipeline.h"
+
+#define JOURNAL_MAGIC				"HLDSCEJ"		//Magic of segment file (8 bytes with terminator)
+#define JOURNAL_VERSION				(1)				//Version of segment file
+#define JOURNAL_RING_RECORDS		(65536)			//Records waiting for the writer thread
+#define JOURNAL_SEGMENT_RECORDS		(1048576)		//Records in a segment (32MB)
+#define JOURNAL_BATCH				(4096)			//Records written at once
+#define JOURNAL_WAIT_MSEC			(10)			//Wait of writer thread when there is no record
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Record of a count event (fixed size, 32 bytes)
+	*/
+	struct JournalRecord {
+		long long time;				///< Time of the frame (msec from 1970-01-01 00:00 UTC, -1: no timestamp)
+		int		framenumber;		///< Frame number of the frame
+		int		appid;				///< Human ID managed in application
+		int		id;					///< Human ID managed in SDK
+		short	zone;				///< Zone of CountEvent
+		signed char type;			///< CountEventType
+		signed char direction;		///< Direction (0: up, 1: right, 2: down, 3: left, -1: none)
+		float	x;					///< X-coordinate of the human [mm]
+		float	y;					///< Y-coordinate of the human [mm]
+	};
+	static_assert(sizeof(JournalRecord) == 32, "JournalRecord must be 32 bytes");
+
+	/**
+	* @brief
+	* 	Header of a segment file (same size as a record)
+	*/
+	struct JournalHeader {
+		char	magic[8];			///< JOURNAL_MAGIC
+		int		version;			///< JOURNAL_VERSION
+		int		recordsize;			///< sizeof(JournalRecord)
+		long long created;			///< Time of the first record
+		long long reserved;
+	};
+	static_assert(sizeof(JournalHeader) == sizeof(JournalRecord), "JournalHeader must be the size of a record");
+
+	/**
+	* @brief
+	* 	Counts summed from records
+	*/
+	struct JournalCount {
+		int		Enter[4];			///< Humans who enter to the zone from each direction (cancels are subtracted)
+		int		Exit[4];			///< Humans who exit from the zone to each direction (cancels are subtracted)
+		int		TotalEnter;			///< Total number of humans entering
+		int		TotalExit;			///< Total number of humans exiting
+		int		In;					///< Crossings of the tripwire to the right side
+		int		Out;				///< Crossings of the tripwire to the left side
+		long long events;			///< Number of records
+	};
+
+	/**
+	* @brief
+	* 	Records in a segment
+	*/
+	struct JournalSpan {
+		const JournalRecord* records;	///< First record
+		long long num;					///< Number of records
+	};
+
+	/**
+	* @brief
+	* 	Msec from 1970-01-01 00:00 UTC of a timestamp (-1: before 1970 or no timestamp)
+	*/
+	inline long long TimeStampMsec(const TimeStamp& timestamp)
+	{
+		long long minutes = TimeStampMinutes(timestamp);
+		if (minutes < 0){
+			return -1;
+		}
+		return minutes * 60000 + timestamp.second * 1000 + timestamp.msecond;
+	}
+
+	/**
+	* @brief
+	* 	Make a record of a count event
+	*/
+	inline void MakeJournalRecord(const CountEvent& event, JournalRecord& record)
+	{
+		record.time = TimeStampMsec(event.timestamp);
+		record.framenumber = (int)event.framenumber;
+		record.appid = event.appid;
+		record.id = (int)event.id;
+		record.zone = (short)event.zone;
+		record.type = (signed char)event.type;
+		record.direction = (signed char)event.direction;
+		record.x = event.x;
+		record.y = event.y;
+	}
+
+	/**
+	* @brief
+	* 	File name of a segment
+	*/
+	inline std::string JournalSegmentName(const std::string& base, int segment)
+	{
+		char buff[32];
+		snprintf(buff, sizeof(buff), ".%06d.cej", segment);
+		return base + buff;
+	}
+
+	/**
+	* @brief
+	* 	Writer of the journal
+	*/
+	class CountJournal {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		* @param	ringsize	Records waiting for the writer thread
+		*/
+		CountJournal(int ringsize = JOURNAL_RING_RECORDS) : ring(ringsize){
+			brun = false;
+			file = NULL;
+			segment = 0;
+			segmentrecords = JOURNAL_SEGMENT_RECORDS;
+			records = 0;
+			lasttime = 0;
+			written = 0;
+			errors = 0;
+		};
+
+		/**
+		* @brief
+		* 	Destructor (remaining records are written)
+		*/
+		~CountJournal(){
+			Close();
+		};
+
+		/**
+		* @brief
+		* 	Start the writer thread
+		* @param	base			Base of file names (segments after the existing ones are written)
+		* @param	maxrecords		Records in a segment
+		* @return	true: OK
+		*/
+		bool Open(const std::string& base, long long maxrecords = JOURNAL_SEGMENT_RECORDS){
+			Close();
+			name = base;
+			segmentrecords = (maxrecords > 0) ? maxrecords : JOURNAL_SEGMENT_RECORDS;
+
+			//Next of the existing segments
+			segment = 0;
+			for (;;){
+				FILE* fp = fopen(JournalSegmentName(name, segment).c_str(), "rb");
+				if (fp == NULL){
+					break;
+				}
+				fclose(fp);
+				segment++;
+			}
+			file = NULL;
+			records = 0;
+
+			brun = true;
+			writer = std::thread(&CountJournal::Run, this);
+			return true;
+		}
+
+		/**
+		* @brief
+		* 	Write remaining records and stop the writer thread
+		*/
+		void Close(void){
+			if (!writer.joinable()){
+				return;
+			}
+			brun.store(false, std::memory_order_release);
+			writer.join();
+		}
+
+		/**
+		* @brief
+		* 	Whether the writer thread is running
+		*/
+		bool IsOpen(void) const {
+			return writer.joinable();
+		}
+
+		/**
+		* @brief
+		* 	Put a count event (counting thread only, never waits)
+		* @return	true: OK, false: dropped (ring is full or not opened)
+		*/
+		bool Append(const CountEvent& event){
+			if (!writer.joinable()){
+				return false;
+			}
+			JournalRecord* record = ring.Claim();
+			if (record == NULL){
+				ring.Drop();
+				return false;
+			}
+			MakeJournalRecord(event, *record);
+			ring.Publish();
+			return true;
+		}
+
+		/**
+		* @brief
+		* 	Records put, dropped and waiting (any thread)
+		*/
+		PipelineStat Stat(void) const {
+			return ring.Stat();
+		}
+
+		/**
+		* @brief
+		* 	Records written to files (any thread)
+		*/
+		long long Written(void) const {
+			return written.load(std::memory_order_relaxed);
+		}
+
+		/**
+		* @brief
+		* 	Errors of file (any thread)
+		*/
+		long Errors(void) const {
+			return errors.load(std::memory_order_relaxed);
+		}
+
+	private:
+		SpscRing<JournalRecord> ring;		//Records from the counting thread
+		std::thread writer;
+		std::atomic<bool> brun;
+		std::string name;					//Base of file names
+		FILE*	file;						//Current segment (writer thread)
+		int		segment;					//Number of current segment
+		long long segmentrecords;			//Max records in a segment
+		long long records;					//Records in current segment
+		long long lasttime;					//Time of the last record
+		std::atomic<long long> written;
+		std::atomic<long> errors;
+
+		//Writer thread
+		void Run(void){
+			std::vector<JournalRecord> batch;
+			batch.reserve(JOURNAL_BATCH);
+			bool bdirty = false;
+			for (;;){
+				//Read the flag first, so that records put before Close() are written
+				bool bstop = !brun.load(std::memory_order_acquire);
+				JournalRecord* record;
+				while ((batch.size() < JOURNAL_BATCH) && ((record = ring.Front()) != NULL)){
+					batch.push_back(*record);
+					ring.Pop();
+				}
+				if (!batch.empty()){
+					Write(&batch[0], (long long)batch.size());
+					batch.clear();
+					bdirty = true;
+					continue;
+				}
+				if (bstop){
+					break;
+				}
+				if (bdirty){
+					//Visible to readers
+					if ((file != NULL) && (fflush(file) != 0)){
+						errors.fetch_add(1, std::memory_order_relaxed);
+					}
+					bdirty = false;
+				}
+				std::this_thread::sleep_for(std::chrono::milliseconds(JOURNAL_WAIT_MSEC));
+			}
+			if (file != NULL){
+				fclose(file);
+				file = NULL;
+			}
+		}
+
+		//Write records (writer thread)
+		void Write(const JournalRecord* batch, long long num){
+			long long start = 0;
+			for (long long rno = 0; rno <= num; rno++){
+				bool bnext = (rno < num) && ((file == NULL) || (records + (rno - start) >= segmentrecords) || (batch[rno].time < lasttime));
+				if ((rno == num) || bnext){
+					//Write records before rno to the current segment
+					if ((rno > start) && (file != NULL)){
+						size_t n = fwrite(&batch[start], sizeof(JournalRecord), (size_t)(rno - start), file);
+						records += (long long)n;
+						written.fetch_add((long long)n, std::memory_order_relaxed);
+						if (n != (size_t)(rno - start)){
+							errors.fetch_add(1, std::memory_order_relaxed);
+						}
+					}
+					start = rno;
+					if (bnext && !NextSegment(batch[rno].time)){
+						//Records are lost until a segment can be created
+						errors.fetch_add(1, std::memory_order_relaxed);
+						start = rno + 1;
+					}
+				}
+				if (rno < num){
+					lasttime = batch[rno].time;
+				}
+			}
+		}
+
+		//Start a new segment (writer thread)
+		bool NextSegment(long long time){
+			if (file != NULL){
+				fclose(file);
+				segment++;
+			}
+			records = 0;
+			file = fopen(JournalSegmentName(name, segment).c_str(), "wb");
+			if (file == NULL){
+				return false;
+			}
+			JournalHeader header;
+			memset(&header, 0, sizeof(header));
+			memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+			header.version = JOURNAL_VERSION;
+			header.recordsize = (int)sizeof(JournalRecord);
+			header.created = time;
+			if (fwrite(&header, sizeof(header), 1, file) != 1){
+				fclose(file);
+				file = NULL;
+				return false;
+			}
+			return true;
+		}
+
+		CountJournal(const CountJournal&);
+		CountJournal& operator=(const CountJournal&);
+	};
+
+	/**
+	* @brief
+	* 	Reader of the journal (segment files are mapped to memory)
+	*/
+	class CountJournalReader {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		*/
+		CountJournalReader(){
+			total = 0;
+		};
+
+		/**
+		* @brief
+		* 	Destructor
+		*/
+		~CountJournalReader(){
+			Close();
+		};
+
+		/**
+		* @brief
+		* 	Map all segments (records written after this are not seen until Open() again)
+		* @param	base	Base of file names
+		* @return	true: OK (one or more segments)
+		*/
+		bool Open(const std::string& base){
+			Close();
+			for (int segment = 0;; segment++){
+				std::string filename = JournalSegmentName(base, segment);
+				Segment seg;
+				if (!Map(filename, seg)){
+					FILE* fp = fopen(filename.c_str(), "rb");
+					if (fp == NULL){
+						break;
+					}
+					//Empty or broken segment
+					fclose(fp);
+					continue;
+				}
+				segments.push_back(seg);
+				total += seg.num;
+			}
+			return !segments.empty();
+		}
+
+		/**
+		* @brief
+		* 	Unmap all segments
+		*/
+		void Close(void){
+			for (size_t sno = 0; sno < segments.size(); sno++){
+				Unmap(segments[sno]);
+			}
+			segments.clear();
+			total = 0;
+		}
+
+		/**
+		* @brief
+		* 	Number of segments
+		*/
+		int Segments(void) const {
+			return (int)segments.size();
+		}
+
+		/**
+		* @brief
+		* 	Number of records
+		*/
+		long long Size(void) const {
+			return total;
+		}
+
+		/**
+		* @brief
+		* 	Find records of a time range
+		* @param	from	Start time (msec from 1970-01-01 00:00 UTC, included)
+		* @param	to		End time (not included)
+		* @param	spans	Output: records in each segment (valid until Close())
+		* @return	Number of records
+		*/
+		long long Find(long long from, long long to, std::vector<JournalSpan>& spans) const {
+			spans.clear();
+			long long num = 0;
+			for (size_t sno = 0; sno < segments.size(); sno++){
+				const Segment& seg = segments[sno];
+				if ((seg.num == 0) || (seg.records[0].time >= to) || (seg.records[seg.num - 1].time < from)){
+					continue;
+				}
+				long long first = LowerBound(seg, from);
+				long long last = LowerBound(seg, to);
+				if (last > first){
+					JournalSpan span;
+					span.records = seg.records + first;
+					span.num = last - first;
+					spans.push_back(span);
+					num += span.num;
+				}
+			}
+			return num;
+		}
+
+		/**
+		* @brief
+		* 	Sum counts of a zone in a time range
+		* @param	from	Start time (msec from 1970-01-01 00:00 UTC, included)
+		* @param	to		End time (not included)
+		* @param	zone	Zone (0: count area, 1 to: count zones or tripwires)
+		* @param	count	Output
+		* @return	Number of records in the range (all zones)
+		*/
+		long long Sum(long long from, long long to, int zone, JournalCount& count) const {
+			memset(&count, 0, sizeof(count));
+			std::vector<JournalSpan> spans;
+			long long num = Find(from, to, spans);
+			for (size_t sno = 0; sno < spans.size(); sno++){
+				const JournalRecord* records = spans[sno].records;
+				for (long long rno = 0; rno < spans[sno].num; rno++){
+					const JournalRecord& record = records[rno];
+					if (record.zone != zone){
+						continue;
+					}
+					count.events++;
+					int dir = record.direction;
+					CountEventType type = (CountEventType)record.type;
+					if (type == CountEventType::CrossIn){
+						count.In++;
+						continue;
+					}
+					if (type == CountEventType::CrossOut){
+						count.Out++;
+						continue;
+					}
+					if ((dir < 0) || (dir >= 4)){
+						continue;
+					}
+					switch (type){
+					case CountEventType::Enter:
+						count.Enter[dir]++;
+						break;
+					case CountEventType::CancelEnter:
+						count.Enter[dir]--;
+						break;
+					case CountEventType::Exit:
+						count.Exit[dir]++;
+						break;
+					case CountEventType::CancelExit:
+						count.Exit[dir]--;
+						break;
+					default:
+						break;
+					}
+				}
+			}
+			for (int dir = 0; dir < 4; dir++){
+				count.TotalEnter += count.Enter[dir];
+				count.TotalExit += count.Exit[dir];
+			}
+			return num;
+		}
+
+	private:
+		//Mapped segment
+		struct Segment {
+			const JournalRecord* records;		//Records after the header
+			long long num;						//Number of records
+			const void* view;					//Mapped memory
+			long long size;						//Size of mapped memory
+#ifdef _WIN32
+			HANDLE	hfile;
+			HANDLE	hmap;
+#else
+			int		fd;
+#endif
+		};
+
+		std::vector<Segment> segments;
+		long long total;					//Records of all segments
+
+		//First record at or after the time
+		static long long LowerBound(const Segment& seg, long long time){
+			long long lo = 0;
+			long long hi = seg.num;
+			while (lo < hi){
+				long long mid = lo + (hi - lo) / 2;
+				if (seg.records[mid].time < time){
+					lo = mid + 1;
+				}
+				else {
+					hi = mid;
+				}
+			}
+			return lo;
+		}
+
+		//Check the header and count records
+		static bool Check(Segment& seg){
+			if (seg.size < (long long)sizeof(JournalHeader)){
+				return false;
+			}
+			const JournalHeader* header = (const JournalHeader*)seg.view;
+			if ((memcmp(header->magic, JOURNAL_MAGIC, sizeof(header->magic)) != 0) ||
+				(header->version != JOURNAL_VERSION) || (header->recordsize != (int)sizeof(JournalRecord))){
+				return false;
+			}
+			seg.records = (const JournalRecord*)(header + 1);
+			seg.num = (seg.size - (long long)sizeof(JournalHeader)) / (long long)sizeof(JournalRecord);
+			return true;
+		}
+
+#ifdef _WIN32
+		static bool Map(const std::string& filename, Segment& seg){
+			seg.view = NULL;
+			seg.hmap = NULL;
+			seg.hfile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (seg.hfile == INVALID_HANDLE_VALUE){
+				return false;
+			}
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(seg.hfile, &size) || (size.QuadPart < (LONGLONG)sizeof(JournalHeader))){
+				CloseHandle(seg.hfile);
+				return false;
+			}
+			seg.size = size.QuadPart;
+			seg.hmap = CreateFileMapping(seg.hfile, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (seg.hmap != NULL){
+				seg.view = MapViewOfFile(seg.hmap, FILE_MAP_READ, 0, 0, 0);
+			}
+			if ((seg.view == NULL) || !Check(seg)){
+				Unmap(seg);
+				return false;
+			}
+			return true;
+		}
+
+		static void Unmap(Segment& seg){
+			if (seg.view != NULL){
+				UnmapViewOfFile(seg.view);
+			}
+			if (seg.hmap != NULL){
+				CloseHandle(seg.hmap);
+			}
+			CloseHandle(seg.hfile);
+		}
+#else
+		static bool Map(const std::string& filename, Segment& seg){
+			seg.view = NULL;
+			seg.fd = open(filename.c_str(), O_RDONLY);
+			if (seg.fd < 0){
+				return false;
+			}
+			struct stat st;
+			if ((fstat(seg.fd, &st) != 0) || (st.st_size < (off_t)sizeof(JournalHeader))){
+				close(seg.fd);
+				return false;
+			}
+			seg.size = (long long)st.st_size;
+			void* view = mmap(NULL, (size_t)seg.size, PROT_READ, MAP_SHARED, seg.fd, 0);
+			if (view != MAP_FAILED){
+				seg.view = view;
+			}
+			if ((seg.view == NULL) || !Check(seg)){
+				Unmap(seg);
+				return false;
+			}
+			return true;
+		}
+
+		static void Unmap(Segment& seg){
+			if (seg.view != NULL){
+				munmap((void*)seg.view, (size_t)seg.size);
+			}
+			close(seg.fd);
+		}
+#endif
+
+		CountJournalReader(const CountJournalReader&);
+		CountJournalReader& operator=(const CountJournalReader&);
+	};
+
+}
+
+#endif //_hlds_countjournal_H
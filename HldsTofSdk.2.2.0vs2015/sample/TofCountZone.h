@@ -0,0 +1,585 @@
+/**
+* @file			TofCountZone.h
+* @brief		Named count zones with a uniform grid index
+* @date			2026.10.16
+* @version		v1.0.1
+*
+* @par Change History:
+* - 2026.10.16 New
+* - 2026.10.16 v1.0.1
+*	- State of humans to a rectangle by AVX2/SSE2 (AreaStates(), count area of HumanCounter)
+*
+* @remarks
+*	- A zone is a rectangle with a name. Enter, exit and number of humans in the zone are counted
+*	  for each zone in the same way as the count area of HumanCounter (4 directions, cancel of the
+*	  previous enter or exit of a human who enters or exits again).
+*	- Geometry of a zone (bounds and 2 diagonal lines for the direction) is made once when the zone
+*	  is added, not for each test.
+*	- Zones are registered to the cells of a uniform grid that they overlap. A human is tested only
+*	  with the zones of its cell (and of its previous cell), so the cost of a frame depends on the number
+*	  of humans and not on humans x zones.
+*	- Last enter/exit direction of a human in a zone is kept by the handle of HumanStore
+*	  (a few zones for each human), so it is forgotten when the human is removed.
+*	- AreaStates() tests the now and previous positions of 8 (AVX2) or 4 (SSE2, all x64 targets) humans
+*	  at once with the arrays of HumanStore (see TofSimd.h) and lists the few humans who entered or exited,
+*	  so the counting loop visits only them (g++ -O2 does not vectorize the scalar loop).
+*/
+#ifndef _hlds_countzone_H
+#define _hlds_countzone_H
+
+#include <stdio.h>
+#include <math.h>
+#include <string>
+#include <vector>
+
+#include "TofCountEvent.h"
+#include "TofHumanStore.h"
+#include "TofSimd.h"
+
+#define COUNTZONE_NO			(-1)			//Not counted (same as COUNT_NO of HumanCounter)
+#define COUNTZONE_CELL_SIZE		(500.0f)		//Default size of a grid cell [mm]
+#define COUNTZONE_MAX_CELLS		(65536)			//Max cells of grid (cell size is enlarged if more)
+#define COUNTZONE_MEMORY		(8)				//Zones remembered for each human
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Geometry of a rectangle zone
+	*/
+	struct ZoneShape {
+		float	left_x;				///< Left [mm]
+		float	top_y;				///< Top [mm]
+		float	right_x;			///< Right [mm]
+		float	bottom_y;			///< Bottom [mm]
+		float	a1;					///< Line from upper left to lower right: y = a1 * x + b1
+		float	b1;
+		float	a2;					///< Line from lower left to upper right: y = a2 * x + b2
+		float	b2;
+
+		/**
+		* @brief
+		* 	Make the geometry of a rectangle
+		*/
+		void Compile(float left, float top, float right, float bottom){
+			left_x = left;
+			top_y = top;
+			right_x = right;
+			bottom_y = bottom;
+			a1 = (bottom - top) / (right - left);
+			b1 = top - a1 * left;
+			a2 = (bottom - top) / (left - right);
+			b2 = top - a2 * right;
+		}
+
+		/**
+		* @brief
+		* 	Point is in the zone (bounds are included)
+		*/
+		bool Inside(float x, float y) const {
+			return (x >= left_x) & (x <= right_x) & (y >= top_y) & (y <= bottom_y);
+		}
+
+		/**
+		* @brief
+		* 	Direction of a point from the center of the zone (0: up, 1: right, 2: down, 3: left)
+		*/
+		int Direction(float x, float y) const {
+			float y1 = a1 * x + b1;
+			float y2 = a2 * x + b2;
+			if ((y <= y1) && (y <= y2)){
+				return 0;
+			}
+			else if ((y >= y1) && (y >= y2)){
+				return 2;
+			}
+			else if ((y >= y1) && (y <= y2)){
+				return 3;
+			}
+			return 1;
+		}
+	};
+
+	/**
+	* @brief
+	* 	State of humans to a rectangle (now and previous position)
+	* @param	shape		Rectangle
+	* @param	x, y		Position of each human
+	* @param	prex, prey	Previous position of each human
+	* @param	num			Number of humans
+	* @param	state		[out] State of each human (bit0: in the rectangle, bit1: was in the rectangle)
+	* @param	changed		[out] Index of the humans who entered or exited (state 1 or 2, num entries at most)
+	* @param	numchanged	[out] Number of changed
+	* @return	Number of humans in the rectangle
+	*/
+	inline int AreaStates(const ZoneShape& shape, const float* x, const float* y, const float* prex, const float* prey,
+		int num, unsigned char* state, int* changed, int& numchanged)
+	{
+		int inarea = 0;
+		int nchanged = 0;
+		int i = 0;
+
+#if defined(TOF_SIMD_AVX2)
+		const __m256 left = _mm256_set1_ps(shape.left_x);
+		const __m256 right = _mm256_set1_ps(shape.right_x);
+		const __m256 top = _mm256_set1_ps(shape.top_y);
+		const __m256 bottom = _mm256_set1_ps(shape.bottom_y);
+		const __m256i one = _mm256_set1_epi32(1);
+		const __m256i two = _mm256_set1_epi32(2);
+		__m256i count = _mm256_setzero_si256();
+		for (; i + 8 <= num; i += 8){
+			__m256 vx = _mm256_loadu_ps(x + i);
+			__m256 vy = _mm256_loadu_ps(y + i);
+			__m256 now = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(vx, left, _CMP_GE_OQ), _mm256_cmp_ps(vx, right, _CMP_LE_OQ)),
+				_mm256_and_ps(_mm256_cmp_ps(vy, top, _CMP_GE_OQ), _mm256_cmp_ps(vy, bottom, _CMP_LE_OQ)));
+			vx = _mm256_loadu_ps(prex + i);
+			vy = _mm256_loadu_ps(prey + i);
+			__m256 pre = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(vx, left, _CMP_GE_OQ), _mm256_cmp_ps(vx, right, _CMP_LE_OQ)),
+				_mm256_and_ps(_mm256_cmp_ps(vy, top, _CMP_GE_OQ), _mm256_cmp_ps(vy, bottom, _CMP_LE_OQ)));
+			__m256i st = _mm256_or_si256(_mm256_and_si256(_mm256_castps_si256(now), one), _mm256_and_si256(_mm256_castps_si256(pre), two));
+			__m128i st16 = _mm_packus_epi32(_mm256_castsi256_si128(st), _mm256_extracti128_si256(st, 1));
+			_mm_storel_epi64((__m128i*)(state + i), _mm_packus_epi16(st16, st16));
+			count = _mm256_sub_epi32(count, _mm256_castps_si256(now));		//mask is -1
+			unsigned int bits = (unsigned int)_mm256_movemask_ps(_mm256_xor_ps(now, pre));
+			while (bits != 0){
+				changed[nchanged++] = i + TofBitScan(bits);
+				bits &= bits - 1;
+			}
+		}
+		__m128i count4 = _mm_add_epi32(_mm256_castsi256_si128(count), _mm256_extracti128_si256(count, 1));
+		count4 = _mm_hadd_epi32(count4, count4);
+		inarea = _mm_cvtsi128_si32(_mm_hadd_epi32(count4, count4));
+#elif defined(TOF_SIMD_SSE2)
+		//SSE2 only (the states are 0 to 3, so signed saturation of packs is same as packus)
+		const __m128 left = _mm_set1_ps(shape.left_x);
+		const __m128 right = _mm_set1_ps(shape.right_x);
+		const __m128 top = _mm_set1_ps(shape.top_y);
+		const __m128 bottom = _mm_set1_ps(shape.bottom_y);
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i two = _mm_set1_epi32(2);
+		__m128i count = _mm_setzero_si128();
+		for (; i + 4 <= num; i += 4){
+			__m128 vx = _mm_loadu_ps(x + i);
+			__m128 vy = _mm_loadu_ps(y + i);
+			__m128 now = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(vx, left), _mm_cmple_ps(vx, right)),
+				_mm_and_ps(_mm_cmpge_ps(vy, top), _mm_cmple_ps(vy, bottom)));
+			vx = _mm_loadu_ps(prex + i);
+			vy = _mm_loadu_ps(prey + i);
+			__m128 pre = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(vx, left), _mm_cmple_ps(vx, right)),
+				_mm_and_ps(_mm_cmpge_ps(vy, top), _mm_cmple_ps(vy, bottom)));
+			__m128i st = _mm_or_si128(_mm_and_si128(_mm_castps_si128(now), one), _mm_and_si128(_mm_castps_si128(pre), two));
+			st = _mm_packs_epi32(st, st);
+			*(int*)(state + i) = _mm_cvtsi128_si32(_mm_packus_epi16(st, st));
+			count = _mm_sub_epi32(count, _mm_castps_si128(now));				//mask is -1
+			unsigned int bits = (unsigned int)_mm_movemask_ps(_mm_xor_ps(now, pre));
+			while (bits != 0){
+				changed[nchanged++] = i + TofBitScan(bits);
+				bits &= bits - 1;
+			}
+		}
+		count = _mm_add_epi32(count, _mm_shuffle_epi32(count, _MM_SHUFFLE(1, 0, 3, 2)));
+		inarea = _mm_cvtsi128_si32(_mm_add_epi32(count, _mm_shuffle_epi32(count, _MM_SHUFFLE(2, 3, 0, 1))));
+#endif
+		//Rest of the humans
+		for (; i < num; i++){
+			int now = shape.Inside(x[i], y[i]);
+			int pre = shape.Inside(prex[i], prey[i]);
+			state[i] = (unsigned char)(now | (pre << 1));
+			inarea += now;
+			if (now != pre){
+				changed[nchanged++] = i;
+			}
+		}
+		numchanged = nchanged;
+		return inarea;
+	}
+
+	/**
+	* @brief
+	* 	Count of a zone
+	*/
+	struct ZoneCount {
+		int		Enter[4];			///< Humans who enter to the zone from each direction
+		int		Exit[4];			///< Humans who exit from the zone to each direction
+		int		TotalEnter;			///< Total number of humans entering
+		int		TotalExit;			///< Total number of humans exiting
+		int		InArea;				///< Number of humans in the zone
+	};
+
+	/**
+	* @brief
+	* 	Change of count in a zone by a human (result of CountZones::Count())
+	*/
+	struct ZoneCrossing {
+		int		index;				///< Index of the human in HumanStore
+		int		zone;				///< Zone number
+		CountEventType type;		///< Type
+		int		direction;			///< Direction
+	};
+
+	/**
+	* @brief
+	* 	Named count zones
+	*/
+	class CountZones {
+	public:
+		std::vector<ZoneCount> counts;			///< Count of each zone
+		std::vector<ZoneCrossing> crossings;	///< Changes of count by the last Count()
+
+		/**
+		* @brief
+		* 	Constructor
+		* @param	cellsize	Size of a grid cell [mm]
+		*/
+		CountZones(float cellsize = COUNTZONE_CELL_SIZE){
+			this->cellsize = cellsize;
+			bdirty = false;
+			Build();
+		};
+
+		/**
+		* @brief
+		* 	Add a zone (the grid is made again by the next Count())
+		* @return	Zone number (0 to Size() - 1)
+		*/
+		int Add(const std::string& name, float left, float top, float right, float bottom){
+			ZoneShape shape;
+			shape.Compile(left, top, right, bottom);
+			ZoneCount count = {};
+			names.push_back(name);
+			shapes.push_back(shape);
+			counts.push_back(count);
+			bdirty = true;
+			return (int)shapes.size() - 1;
+		}
+
+		/**
+		* @brief
+		* 	Remove all zones
+		*/
+		void Clear(void){
+			names.clear();
+			shapes.clear();
+			counts.clear();
+			bdirty = true;
+		}
+
+		/**
+		* @brief
+		* 	Number of zones
+		*/
+		int Size(void) const {
+			return (int)shapes.size();
+		}
+
+		/**
+		* @brief
+		* 	Zone number by name
+		* @return	Zone number (-1: not found)
+		*/
+		int Find(const std::string& name) const {
+			for (int zone = 0; zone < Size(); zone++){
+				if (names[zone] == name){
+					return zone;
+				}
+			}
+			return -1;
+		}
+
+		const std::string& Name(int zone) const {
+			return names[zone];
+		}
+
+		const ZoneShape& Shape(int zone) const {
+			return shapes[zone];
+		}
+
+		/**
+		* @brief
+		* 	Reset counts of all zones
+		*/
+		void ResetCounts(void){
+			for (int zone = 0; zone < Size(); zone++){
+				ZoneCount count = {};
+				counts[zone] = count;
+			}
+			for (size_t i = 0; i < memory.size(); i++){
+				memory[i].handle = HUMANSTORE_NO_HANDLE;
+			}
+		}
+
+		/**
+		* @brief
+		* 	Count humans of a frame in all zones
+		*
+		*	- x, y and prex, prey of HumanStore are the current and previous positions.
+		*	- Changes are in crossings (cleared by each call).
+		*/
+		template <class T>
+		void Count(const HumanStore<T>& humans){
+			if (bdirty){
+				Build();
+			}
+			crossings.clear();
+			for (int zone = 0; zone < Size(); zone++){
+				counts[zone].InArea = 0;
+			}
+
+			for (int ahno = 0; ahno < humans.Size(); ahno++){
+				float x = humans.x[ahno];
+				float y = humans.y[ahno];
+				float prex = humans.prex[ahno];
+				float prey = humans.prey[ahno];
+				int cell = Cell(x, y);
+				int precell = Cell(prex, prey);
+
+				//Zones of the current cell (entering, in the zone, exiting)
+				if (cell >= 0){
+					for (int n = cellstart[cell]; n < cellstart[cell + 1]; n++){
+						int zone = cellzones[n];
+						const ZoneShape& shape = shapes[zone];
+						bool bnow = shape.Inside(x, y);
+						bool bpre = shape.Inside(prex, prey);
+						if (bnow){
+							counts[zone].InArea++;
+						}
+						if (bnow != bpre){
+							Cross(humans, ahno, zone, bnow);
+						}
+					}
+				}
+
+				//Zones only of the previous cell (only exiting, a zone including the current point is in the current cell)
+				if ((precell >= 0) && (precell != cell)){
+					for (int n = cellstart[precell]; n < cellstart[precell + 1]; n++){
+						int zone = cellzones[n];
+						if (shapes[zone].Inside(prex, prey) && !InCell(zone, cell)){
+							Cross(humans, ahno, zone, false);
+						}
+					}
+				}
+			}
+		}
+
+	private:
+		//Last directions of a human in a zone
+		struct Memory {
+			HumanHandle handle;				//Handle of the human (HUMANSTORE_NO_HANDLE: empty)
+			int		zone;
+			int		enterdir;
+			int		exitdir;
+		};
+
+		float	cellsize;						//Size of a cell [mm]
+		float	invcell;						//1 / cellsize
+		float	minx;							//Left of grid
+		float	miny;							//Top of grid
+		int		cols;							//Columns of grid
+		int		rows;							//Rows of grid
+		bool	bdirty;							//Grid must be made again
+		std::vector<std::string> names;
+		std::vector<ZoneShape> shapes;
+		std::vector<int> cellstart;				//First entry of each cell in cellzones (cols * rows + 1)
+		std::vector<int> cellzones;				//Zones of cells
+		std::vector<Memory> memory;				//COUNTZONE_MEMORY entries for each slot of HumanStore
+		std::vector<int> memorynext;			//Entry to overwrite next of each slot
+
+		//Cell of a point (-1: out of grid)
+		int Cell(float x, float y) const {
+			int cx = (int)floorf((x - minx) * invcell);
+			int cy = (int)floorf((y - miny) * invcell);
+			if ((cx < 0) || (cx >= cols) || (cy < 0) || (cy >= rows)){
+				return -1;
+			}
+			return cy * cols + cx;
+		}
+
+		//Zone is registered in the cell
+		bool InCell(int zone, int cell) const {
+			if (cell < 0){
+				return false;
+			}
+			for (int n = cellstart[cell]; n < cellstart[cell + 1]; n++){
+				if (cellzones[n] == zone){
+					return true;
+				}
+			}
+			return false;
+		}
+
+		//Range of cells of a zone
+		void CellRange(const ZoneShape& shape, int& x0, int& y0, int& x1, int& y1) const {
+			x0 = (int)floorf((shape.left_x - minx) * invcell);
+			y0 = (int)floorf((shape.top_y - miny) * invcell);
+			x1 = (int)floorf((shape.right_x - minx) * invcell);
+			y1 = (int)floorf((shape.bottom_y - miny) * invcell);
+			x0 = (x0 < 0) ? 0 : x0;
+			y0 = (y0 < 0) ? 0 : y0;
+			x1 = (x1 >= cols) ? cols - 1 : x1;
+			y1 = (y1 >= rows) ? rows - 1 : y1;
+		}
+
+		//Make the grid
+		void Build(void){
+			bdirty = false;
+			cols = 0;
+			rows = 0;
+			minx = 0;
+			miny = 0;
+			invcell = 1.0f / cellsize;
+			if (shapes.empty()){
+				cellstart.assign(1, 0);
+				cellzones.clear();
+				return;
+			}
+
+			//Bounds of all zones
+			float maxx = shapes[0].right_x;
+			float maxy = shapes[0].bottom_y;
+			minx = shapes[0].left_x;
+			miny = shapes[0].top_y;
+			for (size_t zone = 1; zone < shapes.size(); zone++){
+				minx = (shapes[zone].left_x < minx) ? shapes[zone].left_x : minx;
+				miny = (shapes[zone].top_y < miny) ? shapes[zone].top_y : miny;
+				maxx = (shapes[zone].right_x > maxx) ? shapes[zone].right_x : maxx;
+				maxy = (shapes[zone].bottom_y > maxy) ? shapes[zone].bottom_y : maxy;
+			}
+
+			//Size of grid
+			float size = cellsize;
+			for (;;){
+				cols = (int)floorf((maxx - minx) / size) + 1;
+				rows = (int)floorf((maxy - miny) / size) + 1;
+				if ((long long)cols * rows <= COUNTZONE_MAX_CELLS){
+					break;
+				}
+				size *= 2;
+			}
+			invcell = 1.0f / size;
+
+			//Number of zones of each cell, then zones of each cell
+			cellstart.assign(cols * rows + 1, 0);
+			for (size_t zone = 0; zone < shapes.size(); zone++){
+				int x0, y0, x1, y1;
+				CellRange(shapes[zone], x0, y0, x1, y1);
+				for (int cy = y0; cy <= y1; cy++){
+					for (int cx = x0; cx <= x1; cx++){
+						cellstart[cy * cols + cx + 1]++;
+					}
+				}
+			}
+			for (int cell = 0; cell < cols * rows; cell++){
+				cellstart[cell + 1] += cellstart[cell];
+			}
+			cellzones.resize(cellstart[cols * rows]);
+			std::vector<int> next(cellstart.begin(), cellstart.end() - 1);
+			for (size_t zone = 0; zone < shapes.size(); zone++){
+				int x0, y0, x1, y1;
+				CellRange(shapes[zone], x0, y0, x1, y1);
+				for (int cy = y0; cy <= y1; cy++){
+					for (int cx = x0; cx <= x1; cx++){
+						cellzones[next[cy * cols + cx]++] = (int)zone;
+					}
+				}
+			}
+		}
+
+		//Last directions of a human in a zone (made if not found)
+		Memory& Remember(HumanHandle handle, int zone){
+			unsigned int slot = HandleSlot(handle);
+			if (slot >= memorynext.size()){
+				Memory empty = { HUMANSTORE_NO_HANDLE, 0, COUNTZONE_NO, COUNTZONE_NO };
+				memory.resize((slot + 1) * COUNTZONE_MEMORY, empty);
+				memorynext.resize(slot + 1, 0);
+			}
+			Memory* entries = &memory[slot * COUNTZONE_MEMORY];
+			int entry = -1;
+			for (int n = 0; n < COUNTZONE_MEMORY; n++){
+				if (entries[n].handle == handle){
+					if (entries[n].zone == zone){
+						return entries[n];
+					}
+				}
+				else if (entry < 0){
+					//Empty or a removed human
+					entry = n;
+				}
+			}
+			if (entry < 0){
+				//Forget the oldest zone of the human
+				entry = memorynext[slot];
+				memorynext[slot] = (entry + 1) % COUNTZONE_MEMORY;
+			}
+			entries[entry].handle = handle;
+			entries[entry].zone = zone;
+			entries[entry].enterdir = COUNTZONE_NO;
+			entries[entry].exitdir = COUNTZONE_NO;
+			return entries[entry];
+		}
+
+		//Count a human crossing the border of a zone
+		template <class T>
+		void Cross(const HumanStore<T>& humans, int ahno, int zone, bool benter){
+			Memory& mem = Remember(humans.Handle(ahno), zone);
+			ZoneCount& count = counts[zone];
+			ZoneCrossing crossing;
+			crossing.index = ahno;
+			crossing.zone = zone;
+			if (benter){
+				if (mem.enterdir != COUNTZONE_NO){
+					//Cancel previous entering count
+					count.Enter[mem.enterdir]--;
+					count.TotalEnter--;
+					crossing.type = CountEventType::CancelEnter;
+					crossing.direction = mem.enterdir;
+					crossings.push_back(crossing);
+				}
+				int dir = shapes[zone].Direction(humans.prex[ahno], humans.prey[ahno]);
+				count.Enter[dir]++;
+				count.TotalEnter++;
+				mem.enterdir = dir;
+				crossing.type = CountEventType::Enter;
+				crossing.direction = dir;
+				crossings.push_back(crossing);
+			}
+			else {
+				if (mem.exitdir != COUNTZONE_NO){
+					//Cancel previous exiting count
+					count.Exit[mem.exitdir]--;
+					count.TotalExit--;
+					crossing.type = CountEventType::CancelExit;
+					crossing.direction = mem.exitdir;
+					crossings.push_back(crossing);
+				}
+				int dir = shapes[zone].Direction(humans.x[ahno], humans.y[ahno]);
+				count.Exit[dir]++;
+				count.TotalExit++;
+				mem.exitdir = dir;
+				crossing.type = CountEventType::Exit;
+				crossing.direction = dir;
+				crossings.push_back(crossing);
+			}
+		}
+	};
+
+	/**
+	* @brief
+	* 	Read a zone from a text "name,left_x,top_y,right_x,bottom_y"
+	* @return	true: OK
+	*/
+	inline bool ParseZone(const char* text, std::string& name, float& left, float& top, float& right, float& bottom)
+	{
+		char buff[64];
+		if (sscanf(text, " %63[^,],%f,%f,%f,%f", buff, &left, &top, &right, &bottom) != 5){
+			return false;
+		}
+		if ((left >= right) || (top >= bottom)){
+			return false;
+		}
+		name = buff;
+		return true;
+	}
+
+}
+
+#endif //_hlds_countzone_H
@@ -0,0 +1,246 @@
+/**
+* @file			TofDepthGate.h
+* @brief		Distance range gate on raw 16-bit depth data
+* @date			2026.10.16
+* @version		v1.0.0
+*
+* @par Change History:
+* - 2026.10.16 New
+*
+* @remarks
+*	- Length of every raw value (0x0000 to 0xffff) is calculated once into a 65536 entries table
+*	  when distance range of the frame or of the gate is changed.
+*	- Since length increases with raw value, a distance range [min, max] is a raw value range [rawmin, rawmax].
+*	  Validity test of a frame is an integer compare of FrameMatrix::databuf (16 (AVX2) or 8 (SSE4.1) pixels at once)
+*	  and the result is a packed mask (bit n of word n/32 = pixel n).
+*	- 0xffff (invalid data) never passes the gate.
+*/
+#ifndef _hlds_depthgate_H
+#define _hlds_depthgate_H
+
+#include <vector>
+
+#include "tof.h"
+#include "TofSimd.h"
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Distance range gate
+	*/
+	class DepthGate {
+	public:
+		float	depth_min;					///< distance_min of the depth frame (Length of 0x0000)
+		float	depth_max;					///< distance_max of the depth frame (Length of 0xfffe)
+		float	distance_min;				///< Min distance of the gate [mm]
+		float	distance_max;				///< Max distance of the gate [mm]
+		std::vector<float> length;			///< Length of each raw value [mm] (0xffff = -1)
+		unsigned short rawmin;				///< Min raw value in the range
+		unsigned short rawmax;				///< Max raw value in the range
+		bool	bempty;						///< true: no raw value is in the range
+		std::vector<unsigned int> mask;		///< Packed validity mask of the last Gate(const FrameMatrix&)
+		int		numofvalid;					///< Number of valid pixels of the last Gate(const FrameMatrix&)
+
+		/**
+		* @brief
+		* 	Constructor
+		*/
+		DepthGate(){
+			depth_min = 0;
+			depth_max = 0;
+			distance_min = 0;
+			distance_max = -1;
+			rawmin = 1;
+			rawmax = 0;
+			bempty = true;
+			numofvalid = 0;
+		};
+
+		/**
+		* @brief
+		* 	Make the table and thresholds with the formula of FrameDepth::CalculateLength()
+		*
+		*	- Nothing is done if the ranges are not changed.
+		* @param	dmin	distance_min of the depth frame
+		* @param	dmax	distance_max of the depth frame
+		* @param	gmin	Min distance of the gate [mm]
+		* @param	gmax	Max distance of the gate [mm]
+		* @return	true: table was rebuilt
+		*/
+		bool Build(float dmin, float dmax, float gmin, float gmax){
+			if (IsSame(dmin, dmax, gmin, gmax)){
+				return false;
+			}
+			length.resize(MAX_INT16 + 1);
+			float lscale = (dmax - dmin) / (float)(MAX_INT16 - 1);
+			for (int raw = 0; raw < MAX_INT16; raw++){
+				length[raw] = dmin + raw * lscale;
+			}
+			length[MAX_INT16] = -1;
+			SetRange(dmin, dmax, gmin, gmax);
+			return true;
+		}
+
+		/**
+		* @brief
+		* 	Make the table and thresholds by FrameDepth::CalculateLength() of the SDK
+		*
+		*	- Nothing is done if the ranges are not changed.
+		* @param	frame	Depth frame
+		* @param	gmin	Min distance of the gate [mm]
+		* @param	gmax	Max distance of the gate [mm]
+		* @return	true: table was rebuilt
+		*/
+		bool Build(FrameDepth* frame, float gmin, float gmax){
+			if (IsSame(frame->distance_min, frame->distance_max, gmin, gmax)){
+				return false;
+			}
+			length.resize(MAX_INT16 + 1);
+			for (int raw = 0; raw <= MAX_INT16; raw++){
+				length[raw] = frame->CalculateLength((unsigned short)raw);
+			}
+			SetRange(frame->distance_min, frame->distance_max, gmin, gmax);
+			return true;
+		}
+
+		/**
+		* @brief
+		* 	Length of a raw value [mm] (-1: invalid data)
+		*/
+		float Length(unsigned short raw) const {
+			return length[raw];
+		}
+
+		/**
+		* @brief
+		* 	Check a raw value is in the range
+		*/
+		bool IsValid(unsigned short raw) const {
+			return !bempty && (raw >= rawmin) && (raw <= rawmax);
+		}
+
+		/**
+		* @brief
+		* 	Make packed validity mask of depth data
+		* @param	depth	Depth data
+		* @param	num		Number of pixels
+		* @param	out		Output mask ((num + 31) / 32 words, bit n of word n/32 = pixel n)
+		* @return	Number of valid pixels
+		*/
+		int Gate(const unsigned short* depth, int num, unsigned int* out) const {
+			int words = num / 32;
+			int count = 0;
+			if (bempty){
+				for (int w = 0; w < (num + 31) / 32; w++){
+					out[w] = 0;
+				}
+				return 0;
+			}
+
+#if defined(TOF_SIMD_AVX2)
+			const __m256i lo = _mm256_set1_epi16((short)rawmin);
+			const __m256i range = _mm256_set1_epi16((short)(rawmax - rawmin));
+			for (int w = 0; w < words; w++){
+				__m256i a = _mm256_sub_epi16(_mm256_loadu_si256((const __m256i*)(depth + w * 32)), lo);
+				__m256i b = _mm256_sub_epi16(_mm256_loadu_si256((const __m256i*)(depth + w * 32 + 16)), lo);
+				a = _mm256_cmpeq_epi16(_mm256_min_epu16(a, range), a);
+				b = _mm256_cmpeq_epi16(_mm256_min_epu16(b, range), b);
+				__m256i ab = _mm256_permute4x64_epi64(_mm256_packs_epi16(a, b), _MM_SHUFFLE(3, 1, 2, 0));
+				out[w] = (unsigned int)_mm256_movemask_epi8(ab);
+				count += TofPopCount(out[w]);
+			}
+#elif defined(TOF_SIMD_SSE4)
+			const __m128i lo = _mm_set1_epi16((short)rawmin);
+			const __m128i range = _mm_set1_epi16((short)(rawmax - rawmin));
+			for (int w = 0; w < words; w++){
+				unsigned int bits = 0;
+				for (int h = 0; h < 2; h++){
+					const unsigned short* d = depth + w * 32 + h * 16;
+					__m128i a = _mm_sub_epi16(_mm_loadu_si128((const __m128i*)d), lo);
+					__m128i b = _mm_sub_epi16(_mm_loadu_si128((const __m128i*)(d + 8)), lo);
+					a = _mm_cmpeq_epi16(_mm_min_epu16(a, range), a);
+					b = _mm_cmpeq_epi16(_mm_min_epu16(b, range), b);
+					bits |= (unsigned int)_mm_movemask_epi8(_mm_packs_epi16(a, b)) << (h * 16);
+				}
+				out[w] = bits;
+				count += TofPopCount(bits);
+			}
+#else
+			words = 0;
+#endif
+			//Rest of the data
+			for (int w = words; w < (num + 31) / 32; w++){
+				unsigned int bits = 0;
+				for (int i = w * 32; (i < num) && (i < w * 32 + 32); i++){
+					bits |= (unsigned int)IsValid(depth[i]) << (i - w * 32);
+				}
+				out[w] = bits;
+				count += TofPopCount(bits);
+			}
+			return count;
+		}
+
+		/**
+		* @brief
+		* 	Make packed validity mask of a frame into DepthGate::mask
+		* @return	Number of valid pixels
+		*/
+		int Gate(const FrameMatrix& frame){
+			int num = frame.width * frame.height;
+			mask.resize((num + 31) / 32);
+			numofvalid = Gate(&frame.databuf[0], num, &mask[0]);
+			return numofvalid;
+		}
+
+	private:
+		bool IsSame(float dmin, float dmax, float gmin, float gmax) const {
+			return !length.empty() && (dmin == depth_min) && (dmax == depth_max) &&
+				(gmin == distance_min) && (gmax == distance_max);
+		}
+
+		//Thresholds from the table
+		void SetRange(float dmin, float dmax, float gmin, float gmax){
+			depth_min = dmin;
+			depth_max = dmax;
+			distance_min = gmin;
+			distance_max = gmax;
+			bempty = true;
+			for (int raw = 0; raw < MAX_INT16; raw++){
+				if ((length[raw] >= gmin) && (length[raw] <= gmax)){
+					if (bempty){
+						rawmin = (unsigned short)raw;
+						bempty = false;
+					}
+					rawmax = (unsigned short)raw;
+				}
+			}
+		}
+	};
+
+	/**
+	* @brief
+	* 	Bit of a pixel in a packed validity mask
+	*/
+	inline bool GateBit(const unsigned int* mask, int i)
+	{
+		return ((mask[i >> 5] >> (i & 31)) & 1) != 0;
+	}
+
+	/**
+	* @brief
+	* 	Bits of consecutive pixels in a packed validity mask (lanes <= 32)
+	*/
+	inline unsigned int GateBits(const unsigned int* mask, int i, int lanes)
+	{
+		unsigned long long bits = mask[i >> 5];
+		if ((i & 31) + lanes > 32){
+			bits |= (unsigned long long)mask[(i >> 5) + 1] << 32;
+		}
+		bits >>= (i & 31);
+		return (unsigned int)bits & (unsigned int)((1ull << lanes) - 1);
+	}
+
+}
+
+#endif //_hlds_depthgate_H
@@ -0,0 +1,906 @@
+/**
+* @file			TofEmulator.h
+* @brief		Synthetic TOF sensor with walking humans (frame source without hardware)
+* @date			2026.10.16
+* @version		v1.0.0
+*
+* @par Change History:
+* - 2026.10.16 New
+*
+* @remarks
+*	- TofEmulator has the same methods as Tof to set a sensor and to read frames
+*	  (SetCameraMode(), SetCameraPixel(), SetFrameRate(), SetAttribute(), Run(), GetFrameStatus(), ReadFrame()).
+*	  FrameDepth, FrameIr and FrameHumans are made without the SDK DLL, so it works on Linux also.
+*	- The scene is a floor (z = 0) and humans (z = -head height to 0) walking across a rectangle on the floor.
+*	  A human is a vertical cylinder or an ellipsoid. A human leaving the rectangle is replaced by a new human
+*	  (new ID) entering from an edge, so humans are counted in and out continuously.
+*	- Coordinate is the same as Tof::SetAttribute(): the sensor is at (x, y, z) (z = -1 * height from floor)
+*	  and rotated in Z,Y,X order (RotationZYX() of TofRayTable.h). rx = 0 looks straight down.
+*	- Each pixel is rendered by the ray of the lens model (LensRay()) with depth noise (sigma [mm]),
+*	  invalid pixels (dropout) and IR by reflectivity, angle and distance. Noise of a pixel is decided by
+*	  the frame number, so a frame is the same for every read (e.g. Depth_Motion and Depth_Ir).
+*	- Streams of CameraMode: Depth is floor and humans, Motion is humans only, Background is floor only.
+*	- Frame number is decided by the time after Run() x EmulatorParam::timescale x frame rate
+*	  (1: real time, 10: 10 times faster). With timescale 0, a new frame is ready as soon as
+*	  the previous frame is read (as fast as the program reads).
+*	- Not thread safe. Set and read from one thread (e.g. acquisition thread of HumanCounter).
+*/
+#ifndef _hlds_emulator_H
+#define _hlds_emulator_H
+
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "tof.h"
+#include "TofRayTable.h"
+
+#define EMULATOR_HUMANS			(10)			//Default number of humans
+#define EMULATOR_SPEED			(1200.0f)		//Default walking speed [mm/s]
+#define EMULATOR_HEIGHT			(1650.0f)		//Default head height [mm]
+#define EMULATOR_RADIUS			(250.0f)		//Default radius of a human (half of shoulder width) [mm]
+#define EMULATOR_AREA			(4000.0f)		//Default width and depth of walking area [mm]
+#define EMULATOR_NOISE			(10.0f)			//Default sigma of depth noise [mm]
+#define EMULATOR_DROPOUT		(0.002f)		//Default ratio of invalid pixels
+#define EMULATOR_IR_NOISE		(200.0f)		//Default sigma of IR noise
+#define EMULATOR_IR_SCALE		(200000.0f)		//IR of reflectivity 1 facing the sensor at 1m
+#define EMULATOR_FLOOR_REFLECT	(0.3f)			//Reflectivity of floor
+#define EMULATOR_FLOOR_MARGIN	(100.0f)		//Detection range ends above the floor [mm]
+#define EMULATOR_TURN_SEC		(5.0f)			//Mean time between turns of a human [sec]
+#define EMULATOR_MAX_STEPS		(10000)			//Max frames simulated at once (after a long pause)
+#define EMULATOR_FRAME_WRAP		(0x7fffffffL)	//Frame number after 0x7ffffffe is 0
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Shape of emulated humans
+	*/
+	enum class EmulatorShape {
+		Cylinder	= 0,		///< Vertical cylinder
+		Ellipsoid	= 1,		///< Ellipsoid (long axis is vertical, short axis is the walking direction)
+		Mixed		= 2,		///< Cylinder and ellipsoid in turn
+	};
+
+	/**
+	* @brief
+	* 	Settings of the emulated scene (read at Run())
+	*/
+	struct EmulatorParam {
+		int		numofhuman;				///< Number of humans in the area
+		float	speed;					///< Mean walking speed [mm/s]
+		float	speedrange;				///< Speed is speed +- speedrange [mm/s]
+		float	height;					///< Mean head height [mm]
+		float	heightrange;			///< Head height is height +- heightrange [mm]
+		float	radius;					///< Radius of a human [mm]
+		EmulatorShape shape;			///< Shape of humans
+		float	area_x;					///< X-coordinate of the center of walking area [mm]
+		float	area_y;					///< Y-coordinate of the center of walking area [mm]
+		float	area_width;				///< Width (x) of walking area [mm]
+		float	area_depth;				///< Depth (y) of walking area [mm]
+		float	noise;					///< Sigma of depth noise [mm]
+		float	dropout;				///< Ratio of invalid pixels (0 to 1)
+		float	irnoise;				///< Sigma of IR noise
+		float	distance_min;			///< Length of 0x0000 [mm]
+		float	distance_max;			///< Length of 0xfffe [mm]
+		double	timescale;				///< Speed of time (1: real time, 0: a new frame after each read)
+		unsigned int seed;				///< Seed of random numbers (same seed, same scene)
+		LensParam lens;					///< Lens of the sensor
+
+		/**
+		* @brief
+		* 	Constructor (default scene)
+		*/
+		EmulatorParam(){
+			numofhuman = EMULATOR_HUMANS;
+			speed = EMULATOR_SPEED;
+			speedrange = EMULATOR_SPEED / 4;
+			height = EMULATOR_HEIGHT;
+			heightrange = 150.0f;
+			radius = EMULATOR_RADIUS;
+			shape = EmulatorShape::Mixed;
+			area_x = 0;
+			area_y = 0;
+			area_width = EMULATOR_AREA;
+			area_depth = EMULATOR_AREA;
+			noise = EMULATOR_NOISE;
+			dropout = EMULATOR_DROPOUT;
+			irnoise = EMULATOR_IR_NOISE;
+			distance_min = 0;
+			distance_max = 12000.0f;
+			timescale = 1.0;
+			seed = 1;
+			memset(&lens, 0, sizeof(lens));
+			lens.focallength = 2.8f;
+			lens.fov_x = 90;
+			lens.fov_y = 70;
+			lens.ellipticity = 1;
+		};
+	};
+
+	/**
+	* @brief
+	* 	Synthetic TOF sensor
+	*/
+	class TofEmulator {
+	public:
+		TofInfo		tofinfo;			///< TOF information of the emulated sensor
+		EmulatorParam param;			///< Scene (read at Run())
+
+		/**
+		* @brief
+		* 	Constructor
+		*/
+		TofEmulator(){
+			tofinfo.tofid = "EMULATOR";
+			tofinfo.tofmac = "00:00:00:00:00:00";
+			tofinfo.tofip = "127.0.0.1";
+			tofinfo.rtp_port = 0;
+			tofinfo.distance_min = param.distance_min;
+			tofinfo.distance_max = param.distance_max;
+			tofinfo.tofver = TofVersion::TOFv2;
+			mode = CameraMode::CameraModeDepth;
+			pixel = CameraPixel::w320h240;
+			width = 320;
+			height = 240;
+			fps = FrameRate::fr30fps;
+			RayPose p = { 0, 0, -2500.0f, 0, 0, 0 };
+			pose = p;
+			brun = false;
+			lastread = -1;
+			simulated = 0;
+			rendered = -1;
+			nextid = 1;
+			random = 1;
+			basemsec = 0;
+			memset(&raykey, 0, sizeof(raykey));
+		};
+
+		/**
+		* @brief
+		* 	Start to use the emulator (TOF information is kept for frames)
+		*/
+		Result Open(TofInfo tofinfo){
+			this->tofinfo = tofinfo;
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Replay of capture files is not emulated
+		*/
+		Result Open(CaptureInfo /*info*/){
+			return Result::Unsupported;
+		}
+
+		/**
+		* @brief
+		* 	End to use the emulator
+		*/
+		Result Close(void){
+			return Stop();
+		}
+
+		/**
+		* @brief
+		* 	Start frames (humans are placed by EmulatorParam)
+		*/
+		Result Run(void){
+			if (brun){
+				return Result::SequenceError;
+			}
+			tofinfo.distance_min = param.distance_min;
+			tofinfo.distance_max = param.distance_max;
+			random = (param.seed != 0) ? param.seed : 1;
+			humans.resize(std::max(param.numofhuman, 0));
+			nextid = 1;
+			for (size_t hno = 0; hno < humans.size(); hno++){
+				Enter(humans[hno], true);
+			}
+			start = std::chrono::steady_clock::now();
+			basemsec = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+			lastread = -1;
+			simulated = 0;
+			rendered = -1;
+			brun = true;
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Start frames (human detection is always emulated)
+		*/
+		Result Run(RunMode mode){
+			if ((mode != RunMode::Normal) && (mode != RunMode::HumanDetect)){
+				return Result::Unsupported;
+			}
+			return Run();
+		}
+
+		/**
+		* @brief
+		* 	Stop frames
+		*/
+		Result Stop(void){
+			brun = false;
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Set camera mode
+		*/
+		Result SetCameraMode(CameraMode mode){
+			if (StreamOf(mode, 0) == Stream::None){
+				return Result::ArgumentInvalid;
+			}
+			this->mode = mode;
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Get camera mode
+		*/
+		Result GetCameraMode(CameraMode* mode){
+			*mode = this->mode;
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Set camera resolution
+		*/
+		Result SetCameraPixel(CameraPixel pixel){
+			static const int size[][2] = { { 640, 480 }, { 320, 240 }, { 160, 120 }, { 80, 60 }, { 64, 48 }, { 40, 30 }, { 32, 24 } };
+			int p = (int)pixel;
+			if ((p < 0) || (p >= (int)(sizeof(size) / sizeof(size[0])))){
+				return Result::ArgumentInvalid;
+			}
+			this->pixel = pixel;
+			width = size[p][0];
+			height = size[p][1];
+			rendered = -1;
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Get camera resolution
+		*/
+		Result GetCameraPixel(CameraPixel* pixel){
+			*pixel = this->pixel;
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Set frame rate
+		*/
+		Result SetFrameRate(FrameRate fps){
+			if (((int)fps < 0) || ((int)fps > (int)FrameRate::fr1fps)){
+				return Result::ArgumentInvalid;
+			}
+			if (brun){
+				//Frame number continues from the current frame
+				long long now = Latest();
+				this->fps = fps;
+				start = std::chrono::steady_clock::now() - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double>(now / (FramesPerSecond() * std::max(param.timescale, 1e-9))));
+			}
+			this->fps = fps;
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Get frame rate
+		*/
+		Result GetFrameRate(FrameRate* fps){
+			*fps = this->fps;
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Edge noise reduction is not emulated
+		*/
+		Result SetEdgeSignalCutoff(EdgeSignalCutoff /*mode*/){
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Set position of the sensor (same as Tof::SetAttribute())
+		* @param	x		x-coordinate of TOF sensor [mm]
+		* @param	y		y-coordinate of TOF sensor [mm]
+		* @param	z		z-coordinate of TOF sensor(-1 * height from floor) [mm]
+		* @param	rx		X-axis rotation angle (degree)
+		* @param	ry		Y-axis rotation angle (degree)
+		* @param	rz		Z-axis rotation angle (degree)
+		*/
+		Result SetAttribute(float x, float y, float z, float rx, float ry, float rz){
+			RayPose p = { x, y, z, rx, ry, rz };
+			pose = p;
+			rendered = -1;
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Get position of the sensor
+		*/
+		Result GetAttribute(float* x, float* y, float* z, float* rx, float* ry, float* rz){
+			*x = pose.x;
+			*y = pose.y;
+			*z = pose.z;
+			*rx = pose.rx;
+			*ry = pose.ry;
+			*rz = pose.rz;
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Get status of the latest frame
+		* @param	frameno		Frame number of the latest frame (-1: not running)
+		* @param	timestamp	Timestamp of the latest frame (UTC, time of the emulated sensor)
+		*/
+		Result GetFrameStatus(long* frameno, TimeStamp* timestamp){
+			if (!brun){
+				*frameno = -1;
+				memset(timestamp, 0, sizeof(TimeStamp));
+				return Result::OK;
+			}
+			long long now = Latest();
+			*frameno = (long)(now % EMULATOR_FRAME_WRAP);
+			*timestamp = StampOf(now);
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Read the latest Depth/Motion/Background frame (first stream of camera mode)
+		*/
+		Result ReadFrame(FrameDepth* frame){
+			Stream stream = StreamOf(mode, 0);
+			if (stream == Stream::Ir){
+				return Result::ArgumentInvalid;
+			}
+			Result ret = Prepare();
+			if (ret == Result::OK){
+				Fill(frame, stream);
+			}
+			return ret;
+		}
+
+		/**
+		* @brief
+		* 	Read the latest two Depth/Motion/Background frames (dual output)
+		*/
+		Result ReadFrame(FrameDepth* frame1, FrameDepth* frame2){
+			Stream stream1 = StreamOf(mode, 0);
+			Stream stream2 = StreamOf(mode, 1);
+			if ((stream1 == Stream::Ir) || (stream2 == Stream::Ir) || (stream2 == Stream::None)){
+				return Result::ArgumentInvalid;
+			}
+			Result ret = Prepare();
+			if (ret == Result::OK){
+				Fill(frame1, stream1);
+				Fill(frame2, stream2);
+			}
+			return ret;
+		}
+
+		/**
+		* @brief
+		* 	Read the latest Depth/Motion/Background frame and IR frame (dual output)
+		*/
+		Result ReadFrame(FrameDepth* frame1, FrameIr* frame2){
+			Stream stream1 = StreamOf(mode, 0);
+			if ((stream1 == Stream::Ir) || (StreamOf(mode, 1) != Stream::Ir)){
+				return Result::ArgumentInvalid;
+			}
+			Result ret = Prepare();
+			if (ret == Result::OK){
+				Fill(frame1, stream1);
+				Fill(frame2, Stream::Ir);
+			}
+			return ret;
+		}
+
+		/**
+		* @brief
+		* 	Read the latest IR frame
+		*/
+		Result ReadFrame(FrameIr* frame){
+			if ((StreamOf(mode, 0) != Stream::Ir) && (StreamOf(mode, 1) != Stream::Ir)){
+				return Result::ArgumentInvalid;
+			}
+			Result ret = Prepare();
+			if (ret == Result::OK){
+				Fill(frame, Stream::Ir);
+			}
+			return ret;
+		}
+
+		/**
+		* @brief
+		* 	Read the latest humans (humans whose position on the floor is in the field of view)
+		*
+		*	- z_min and z_max are the range of points rotated without position (as HumanCounter uses),
+		*	  from the sensor to EMULATOR_FLOOR_MARGIN above the floor.
+		*/
+		Result ReadFrame(FrameHumans* frame){
+			if (!brun){
+				return Result::SequenceError;
+			}
+			long long now = Latest();
+			Simulate(now);
+			lastread = now;
+			Header(frame, now);
+			frame->z_min = 0;
+			frame->z_max = -pose.z - EMULATOR_FLOOR_MARGIN;
+
+			float m[3][3];
+			RotationZYX(pose.rx, pose.ry, pose.rz, m);
+			double ax = tan(param.lens.fov_x / 2.0 / 180.0 * 3.14159265358979);
+			double ay = tan(param.lens.fov_y / 2.0 / 180.0 * 3.14159265358979);
+			frame->humans.clear();
+			for (size_t hno = 0; hno < humans.size(); hno++){
+				const Walker& w = humans[hno];
+
+				//Position on the floor in coordinate of the sensor (inverse rotation)
+				float px = w.x - pose.x;
+				float py = w.y - pose.y;
+				float pz = -pose.z;
+				float sx = m[0][0] * px + m[1][0] * py + m[2][0] * pz;
+				float sy = m[0][1] * px + m[1][1] * py + m[2][1] * pz;
+				float sz = m[0][2] * px + m[1][2] * py + m[2][2] * pz;
+				float length = sqrt(px * px + py * py + pz * pz);
+				if ((sz <= 0) || (fabs(sx) > sz * ax) || (fabs(sy) > sz * ay) ||
+					(length < param.distance_min) || (length > param.distance_max)){
+					continue;
+				}
+				Human h;
+				h.id = w.id;
+				h.x = w.x;
+				h.y = w.y;
+				h.direction = (float)(atan2(w.vy, w.vx) / 3.14159265358979 * 180.0);
+				if (h.direction < 0){
+					h.direction += 360.0f;
+				}
+				h.headheight = w.height;
+				h.handheight = 0;
+				h.status = HumanStatus::Walk;
+				frame->humans.push_back(h);
+			}
+			frame->numofhuman = (int)frame->humans.size();
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Frames per second of the frame rate
+		*/
+		double FramesPerSecond(void) const {
+			static const double rate[] = { 30, 16, 10, 8, 4, 2, 1 };
+			return rate[(int)fps];
+		}
+
+	private:
+		enum class Stream { None, Depth, Ir, Motion, Background };
+
+		//Human walking in the area
+		struct Walker {
+			long	id;
+			float	x;					//Position on floor [mm]
+			float	y;
+			float	vx;					//Velocity [mm/s]
+			float	vy;
+			float	height;				//Head height [mm]
+			float	radius;				//Radius (half of shoulder width) [mm]
+			float	reflect;			//Reflectivity
+			bool	bellipsoid;
+		};
+
+		CameraMode	mode;
+		CameraPixel	pixel;
+		int			width;
+		int			height;
+		FrameRate	fps;
+		RayPose		pose;
+		bool		brun;
+		std::chrono::steady_clock::time_point start;
+		long long	basemsec;			//UTC of frame 0 [msec]
+		long long	lastread;			//Frames counted from Run() (-1: not read yet)
+		long long	simulated;			//Frame of the positions of humans
+		long long	rendered;			//Frame of hit (-1: none)
+		long		nextid;
+		unsigned int random;
+		std::vector<Walker> humans;
+
+		//Rays of pixels (rotated by the pose) and the floor
+		RayTableKey	raykey;
+		RayPose		raypose;
+		std::vector<TofPoint> rays;
+		std::vector<float> floorlength;	//Length to floor (0: floor is not seen)
+		std::vector<float> floorir;		//IR of floor at 1m
+
+		//Nearest human of each pixel in the rendered frame
+		std::vector<float> hitlength;	//Length to human (0: no human)
+		std::vector<float> hitir;		//IR of human at 1m
+
+		//Streams of camera mode
+		static Stream StreamOf(CameraMode mode, int no){
+			static const Stream streams[][2] = {
+				{ Stream::Depth, Stream::None },			//CameraModeDepth
+				{ Stream::Ir, Stream::None },				//CameraModeIr
+				{ Stream::Motion, Stream::None },			//CameraModeMotion
+				{ Stream::Background, Stream::None },		//CameraModeBackground
+				{ Stream::Depth, Stream::Motion },			//Depth_Motion
+				{ Stream::Depth, Stream::Background },		//Depth_Background
+				{ Stream::Depth, Stream::Ir },				//Depth_Ir
+				{ Stream::Motion, Stream::Background },		//Motion_Background
+				{ Stream::Motion, Stream::Ir },				//Motion_Ir
+				{ Stream::Background, Stream::Ir },			//Background_Ir
+			};
+			int m = (int)mode;
+			if ((m < 0) || (m >= (int)(sizeof(streams) / sizeof(streams[0])))){
+				return Stream::None;
+			}
+			return streams[m][no];
+		}
+
+		//Random number (xorshift32)
+		unsigned int Random(void){
+			random ^= random << 13;
+			random ^= random >> 17;
+			random ^= random << 5;
+			return random;
+		}
+
+		//Uniform random number (0 to 1)
+		float Uniform(void){
+			return (Random() >> 8) * (1.0f / 16777216.0f);
+		}
+
+		//Hash of a pixel of a frame (noise is the same for every read of the frame)
+		static unsigned int Hash(unsigned int h){
+			h ^= h >> 16;
+			h *= 0x85ebca6bU;
+			h ^= h >> 13;
+			h *= 0xc2b2ae35U;
+			h ^= h >> 16;
+			return h;
+		}
+
+		//Approximately normal random number (sigma 1) from a hash (sum of two uniforms)
+		static float Normal(unsigned int h){
+			return (((h & 0xffff) + (h >> 16)) * (1.0f / 65536.0f) - 1.0f) * 2.449f;
+		}
+
+		//Latest frame counted from Run()
+		long long Latest(void) const {
+			if (param.timescale <= 0){
+				return lastread + 1;
+			}
+			double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			return (long long)(sec * param.timescale * FramesPerSecond());
+		}
+
+		//Timestamp of a frame
+		TimeStamp StampOf(long long frame) const {
+			long long msec = basemsec + (long long)(frame * 1000 / FramesPerSecond());
+			time_t sec = (time_t)(msec / 1000);
+			struct tm t;
+#ifdef _WIN32
+			gmtime_s(&t, &sec);
+#else
+			gmtime_r(&sec, &t);
+#endif
+			TimeStamp ts;
+			ts.year = (unsigned short)(t.tm_year + 1900);
+			ts.month = (unsigned short)(t.tm_mon + 1);
+			ts.dayofweek = (unsigned short)t.tm_wday;
+			ts.day = (unsigned short)t.tm_mday;
+			ts.hour = (unsigned short)t.tm_hour;
+			ts.minute = (unsigned short)t.tm_min;
+			ts.second = (unsigned short)t.tm_sec;
+			ts.msecond = (unsigned short)(msec % 1000);
+			return ts;
+		}
+
+		//Place a human (binside: anywhere in the area, else at an edge walking into the area)
+		void Enter(Walker& w, bool binside){
+			w.id = nextid;
+			nextid = (nextid >= EMULATOR_FRAME_WRAP - 1) ? 1 : nextid + 1;
+			w.height = param.height + (Uniform() * 2 - 1) * param.heightrange;
+			w.radius = param.radius * (0.9f + Uniform() * 0.2f);
+			w.reflect = 0.3f + Uniform() * 0.4f;
+			w.bellipsoid = (param.shape == EmulatorShape::Ellipsoid) || ((param.shape == EmulatorShape::Mixed) && (w.id % 2 == 0));
+			float speed = param.speed + (Uniform() * 2 - 1) * param.speedrange;
+			float angle = Uniform() * 6.2831853f;
+			float hw = param.area_width / 2;
+			float hd = param.area_depth / 2;
+			if (binside){
+				w.x = param.area_x + (Uniform() * 2 - 1) * hw;
+				w.y = param.area_y + (Uniform() * 2 - 1) * hd;
+			}
+			else {
+				//Edge and direction into the area (+-45 degree)
+				int edge = (int)(Random() % 4);
+				float along = Uniform() * 2 - 1;
+				float turn = (Uniform() - 0.5f) * 1.5707963f;
+				static const float angles[] = { 0, 1.5707963f, 3.1415927f, 4.7123890f };
+				static const float ex[] = { -1, 0, 1, 0 };
+				static const float ey[] = { 0, -1, 0, 1 };
+				angle = angles[edge] + turn;
+				w.x = param.area_x + ((ex[edge] != 0) ? ex[edge] * hw : along * hw);
+				w.y = param.area_y + ((ey[edge] != 0) ? ey[edge] * hd : along * hd);
+			}
+			w.vx = speed * cos(angle);
+			w.vy = speed * sin(angle);
+		}
+
+		//Walk humans until a frame
+		void Simulate(long long frame){
+			if (frame <= simulated){
+				return;
+			}
+			long long steps = std::min(frame - simulated, (long long)EMULATOR_MAX_STEPS);
+			simulated = frame;
+			float dt = (float)(1.0 / FramesPerSecond());
+			float turn = dt / EMULATOR_TURN_SEC;
+			float hw = param.area_width / 2;
+			float hd = param.area_depth / 2;
+			for (long long s = 0; s < steps; s++){
+				for (size_t hno = 0; hno < humans.size(); hno++){
+					Walker& w = humans[hno];
+					w.x += w.vx * dt;
+					w.y += w.vy * dt;
+					if (Uniform() < turn){
+						//Turn by +-30 degree
+						float a = (Uniform() - 0.5f) * 1.0471976f;
+						float vx = w.vx * cos(a) - w.vy * sin(a);
+						w.vy = w.vx * sin(a) + w.vy * cos(a);
+						w.vx = vx;
+					}
+					if ((fabs(w.x - param.area_x) > hw + w.radius) || (fabs(w.y - param.area_y) > hd + w.radius)){
+						Enter(w, false);
+					}
+				}
+			}
+		}
+
+		//Rays and floor of the resolution and the pose
+		void UpdateRays(void){
+			RayTableKey k;
+			memset(&k, 0, sizeof(k));
+			k.width = width;
+			k.height = height;
+			k.distance_min = param.distance_min;
+			k.distance_max = param.distance_max;
+			k.lens = param.lens;
+			if ((k == raykey) && (pose == raypose) && !rays.empty()){
+				return;
+			}
+			raykey = k;
+			raypose = pose;
+
+			float m[3][3];
+			RotationZYX(pose.rx, pose.ry, pose.rz, m);
+			int num = width * height;
+			rays.resize(num);
+			floorlength.resize(num);
+			floorir.resize(num);
+			hitlength.resize(num);
+			hitir.resize(num);
+			for (int y = 0; y < height; y++){
+				for (int x = 0; x < width; x++){
+					int i = y * width + x;
+					TofPoint r = LensRay(x, y, width, height, param.lens);
+					rays[i].x = m[0][0] * r.x + m[0][1] * r.y + m[0][2] * r.z;
+					rays[i].y = m[1][0] * r.x + m[1][1] * r.y + m[1][2] * r.z;
+					rays[i].z = m[2][0] * r.x + m[2][1] * r.y + m[2][2] * r.z;
+					floorlength[i] = 0;
+					floorir[i] = 0;
+					if ((pose.z < 0) && (rays[i].z > 1e-6f)){
+						floorlength[i] = -pose.z / rays[i].z;
+						floorir[i] = EMULATOR_FLOOR_REFLECT * rays[i].z;
+					}
+				}
+			}
+		}
+
+		//Nearest human of each pixel
+		void Render(void){
+			struct Target {
+				float ox, oy, oz;		//Sensor from the center (cylinder: foot, ellipsoid: scaled by axes)
+				float c;				//|o|^2 - 1 (ellipsoid) or ox^2 + oy^2 - r^2 (cylinder)
+				float cs, sn;			//Walking direction
+				float a, b, h;			//Axes (ellipsoid: side, front, half height) or radius and height (cylinder)
+				float reflect;
+				bool bellipsoid;
+			};
+			std::vector<Target> targets(humans.size());
+			for (size_t hno = 0; hno < humans.size(); hno++){
+				const Walker& w = humans[hno];
+				Target& t = targets[hno];
+				float speed = sqrt(w.vx * w.vx + w.vy * w.vy);
+				t.cs = (speed > 0) ? w.vx / speed : 1.0f;
+				t.sn = (speed > 0) ? w.vy / speed : 0.0f;
+				t.reflect = w.reflect;
+				t.bellipsoid = w.bellipsoid;
+				float ox = pose.x - w.x;
+				float oy = pose.y - w.y;
+				if (w.bellipsoid){
+					t.a = w.radius;
+					t.b = w.radius * 0.6f;
+					t.h = w.height / 2;
+					t.ox = (ox * t.cs + oy * t.sn) / t.b;
+					t.oy = (-ox * t.sn + oy * t.cs) / t.a;
+					t.oz = (pose.z + t.h) / t.h;
+					t.c = t.ox * t.ox + t.oy * t.oy + t.oz * t.oz - 1;
+				}
+				else {
+					t.a = w.radius;
+					t.h = w.height;
+					t.ox = ox;
+					t.oy = oy;
+					t.oz = pose.z;
+					t.c = ox * ox + oy * oy - t.a * t.a;
+				}
+			}
+
+			int num = width * height;
+			for (int i = 0; i < num; i++){
+				const TofPoint& d = rays[i];
+				float best = 0;
+				float ir = 0;
+				for (size_t tno = 0; tno < targets.size(); tno++){
+					const Target& t = targets[tno];
+					if (t.bellipsoid){
+						float du = d.x * t.cs + d.y * t.sn;
+						float dv = -d.x * t.sn + d.y * t.cs;
+						float lx = du / t.b;
+						float ly = dv / t.a;
+						float lz = d.z / t.h;
+						float qa = lx * lx + ly * ly + lz * lz;
+						float qb = t.ox * lx + t.oy * ly + t.oz * lz;
+						float disc = qb * qb - qa * t.c;
+						if (disc < 0){
+							continue;
+						}
+						float len = (-qb - sqrt(disc)) / qa;
+						if ((len <= 0) || ((best > 0) && (len >= best))){
+							continue;
+						}
+						//Normal by gradient
+						float nx = (t.ox + len * lx) / t.b;
+						float ny = (t.oy + len * ly) / t.a;
+						float nz = (t.oz + len * lz) / t.h;
+						float cosine = -(nx * du + ny * dv + nz * d.z) / sqrt(nx * nx + ny * ny + nz * nz);
+						best = len;
+						ir = t.reflect * std::max(cosine, 0.0f);
+					}
+					else {
+						float qa = d.x * d.x + d.y * d.y;
+						float qb = t.ox * d.x + t.oy * d.y;
+						float disc = qb * qb - qa * t.c;
+						if ((qa > 0) && (disc < 0)){
+							continue;
+						}
+						//Side
+						float len = 0;
+						float cosine = -1;
+						if (qa > 0){
+							len = (-qb - sqrt(disc)) / qa;
+							float z = t.oz + len * d.z;
+							if ((len > 0) && (z >= -t.h) && (z <= 0)){
+								cosine = -((t.ox + len * d.x) * d.x + (t.oy + len * d.y) * d.y) / t.a;
+							}
+						}
+						//Top
+						if ((cosine < 0) && (d.z > 0) && (t.oz < -t.h)){
+							len = (-t.h - t.oz) / d.z;
+							float px = t.ox + len * d.x;
+							float py = t.oy + len * d.y;
+							if (px * px + py * py <= t.a * t.a){
+								cosine = d.z;
+							}
+						}
+						if ((cosine < 0) || ((best > 0) && (len >= best))){
+							continue;
+						}
+						best = len;
+						ir = t.reflect * cosine;
+					}
+				}
+				hitlength[i] = best;
+				hitir[i] = ir;
+			}
+		}
+
+		//Simulate and render the latest frame
+		Result Prepare(void){
+			if (!brun){
+				return Result::SequenceError;
+			}
+			long long now = Latest();
+			Simulate(now);
+			UpdateRays();
+			if (rendered != now){
+				Render();
+				rendered = now;
+			}
+			lastread = now;
+			return Result::OK;
+		}
+
+		//Common members of frames
+		void Header(FrameData* frame, long long now) const {
+			frame->tofinfo = tofinfo;
+			frame->timestamp = StampOf(now);
+			frame->framenumber = (long)(now % EMULATOR_FRAME_WRAP);
+			frame->modelname = "Emulator";
+			frame->distance_min = param.distance_min;
+			frame->distance_max = param.distance_max;
+			frame->lens = param.lens;
+		}
+
+		//Output a stream of the rendered frame
+		void Fill(FrameMatrix* frame, Stream stream){
+			Header(frame, rendered);
+			frame->width = width;
+			frame->height = height;
+			frame->picbyte = BYTE_PER_PIXEL;
+			frame->pixel = width * height;
+			frame->databuf.resize(frame->pixel);
+			unsigned short* out = &frame->databuf[0];
+
+			float scale = (MAX_INT16 - 1) / (param.distance_max - param.distance_min);
+			unsigned int key = Hash((unsigned int)rendered * 0x9e3779b9U ^ param.seed);
+			unsigned int drop = (unsigned int)(param.dropout * 4294967295.0);
+			for (int i = 0; i < frame->pixel; i++){
+				float len = 0;
+				float ir = 0;
+				if ((stream != Stream::Background) && (hitlength[i] > 0)){
+					len = hitlength[i];
+					ir = hitir[i];
+				}
+				else if ((stream != Stream::Motion) && (floorlength[i] > 0)){
+					len = floorlength[i];
+					ir = floorir[i];
+				}
+				unsigned int h = Hash(key ^ (unsigned int)i);
+				if (stream == Stream::Ir){
+					float m = len / 1000.0f;
+					float v = (len > 0) ? EMULATOR_IR_SCALE * ir / (m * m) : 0.0f;
+					v += Normal(Hash(h)) * param.irnoise;
+					out[i] = (unsigned short)std::min(std::max(v, 0.0f), (float)MAX_INT16);
+					continue;
+				}
+				if (len <= 0){
+					out[i] = MAX_INT16;
+					continue;
+				}
+				len += Normal(h) * param.noise;
+				if ((len <= param.distance_min) || (len > param.distance_max) || (Hash(h ^ 0x5bd1e995U) < drop)){
+					out[i] = MAX_INT16;
+					continue;
+				}
+				out[i] = (unsigned short)std::min((len - param.distance_min) * scale, (float)(MAX_INT16 - 1));
+			}
+		}
+
+		TofEmulator(const TofEmulator&);
+		TofEmulator& operator=(const TofEmulator&);
+	};
+
+}
+
+#endif //_hlds_emulator_H
@@ -0,0 +1,193 @@
+/**
+* @file			TofFramePool.h
+* @brief		Reused images and allocation counter for each frame
+* @date			2026.10.16
+* @version		v1.0.0
+*
+* @par Change History:
+* - 2026.10.16 New
+*
+* @remarks
+*	- MatPool keeps images by number (e.g. TOF sensor number) and gives the same buffer every frame.
+*	  A buffer is allocated again only when the size or the type is changed.
+*	- Frames of the SDK (FrameDepth, Frame3d, FrameHumans, FrameIr) are reused by keeping them in
+*	  arrays or in slots of SpscRing (TofPipeline.h), and not by this file.
+*	- Define TOF_COUNT_ALLOCATIONS before including this file (in one source file only) to count
+*	  "new" of each thread. AllocationCheck uses the count to check that no memory is allocated
+*	  in a frame after warming up.
+*/
+#ifndef _hlds_framepool_H
+#define _hlds_framepool_H
+
+#include <stdlib.h>
+#include <new>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#define FRAMEPOOL_WARMUP		(30)		//Frames until the first allocation check
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Number of "new" in this thread (Counted only if TOF_COUNT_ALLOCATIONS is defined)
+	*/
+	inline long long& ThreadNewCount(void)
+	{
+		static thread_local long long count = 0;
+		return count;
+	}
+
+	/**
+	* @brief
+	* 	Number of images allocated by ReuseMat() in this thread
+	*/
+	inline long long& ThreadMatCount(void)
+	{
+		static thread_local long long count = 0;
+		return count;
+	}
+
+	/**
+	* @brief
+	* 	Number of allocations in this thread
+	*/
+	inline long long AllocationCount(void)
+	{
+		return ThreadNewCount() + ThreadMatCount();
+	}
+
+	/**
+	* @brief
+	* 	Make an image with the size and the type by reusing the buffer
+	* @return	true: buffer was allocated
+	*/
+	inline bool ReuseMat(cv::Mat& mat, int rows, int cols, int type)
+	{
+		if ((mat.rows == rows) && (mat.cols == cols) && (mat.type() == type) && (mat.data != NULL)){
+			return false;
+		}
+		mat.create(rows, cols, type);
+		ThreadMatCount()++;
+		return true;
+	}
+
+	/**
+	* @brief
+	* 	Images reused by number
+	*/
+	class MatPool {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		* @param	num		Number of images
+		*/
+		MatPool(int num = 0) : mats(num){
+		};
+
+		/**
+		* @brief
+		* 	Get an image
+		* @param	no		Image number
+		* @param	rows	Rows
+		* @param	cols	Columns
+		* @param	type	Type (CV_8UC3 etc.)
+		* @return	Image (contents of the last frame remain)
+		*/
+		cv::Mat& Get(int no, int rows, int cols, int type){
+			if (no >= (int)mats.size()){
+				mats.resize(no + 1);
+			}
+			ReuseMat(mats[no], rows, cols, type);
+			return mats[no];
+		}
+
+	private:
+		std::vector<cv::Mat> mats;
+	};
+
+	/**
+	* @brief
+	* 	Check of allocations in a frame (in one thread)
+	*/
+	class AllocationCheck {
+	public:
+		long	frames;				///< Number of checked frames
+		long	badframes;			///< Frames with allocations after warming up
+		long long allocations;		///< Allocations after warming up
+
+		/**
+		* @brief
+		* 	Constructor
+		* @param	warmup	Frames not checked (buffers are allocated in the first frames)
+		*/
+		AllocationCheck(int warmup = FRAMEPOOL_WARMUP){
+			this->warmup = warmup;
+			frames = 0;
+			badframes = 0;
+			allocations = 0;
+			start = 0;
+		};
+
+		/**
+		* @brief
+		* 	Start of a frame
+		*/
+		void Begin(void){
+			start = AllocationCount();
+		}
+
+		/**
+		* @brief
+		* 	End of a frame
+		* @return	Allocations in the frame after warming up (0: OK)
+		*/
+		long long End(void){
+			long long count = AllocationCount() - start;
+			frames++;
+			if ((frames <= warmup) || (count == 0)){
+				return 0;
+			}
+			badframes++;
+			allocations += count;
+			return count;
+		}
+
+	private:
+		int		warmup;
+		long long start;
+	};
+
+}
+
+#ifdef TOF_COUNT_ALLOCATIONS
+//Count "new" of each thread (replacement of global operator new/delete)
+void* operator new(size_t size)
+{
+	hlds::ThreadNewCount()++;
+	void* p = malloc(size ? size : 1);
+	if (p == NULL){
+		throw std::bad_alloc();
+	}
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+#endif //TOF_COUNT_ALLOCATIONS
+
+#endif //_hlds_framepool_H
@@ -0,0 +1,239 @@
+/**
+* @file			TofFrameTelemetry.h
+* @brief		Timestamps of each frame, dropped frames and rolling latency percentiles of a sensor
+* @date			2026.10.16
+* @version		v1.0.0
+*
+* @par Change History:
+* - 2026.10.16 New
+*
+* @remarks
+*	- Each frame has a FrameStamp with a monotonic clock [nsec] at read, at the end of processing
+*	  (counts and events are made) and at output (displayed).
+*	- Read() counts frames whose frame number was skipped as dropped, either skipped by the sensor or
+*	  not read because the program was late. Frame number goes back to 0 after 0x7ffffffe
+*	  (FrameNumberDiff(), same as Tofv2Viewer).
+*	- Latencies (read to processed, read to output) of the last TELEMETRY_WINDOW frames are kept in rings.
+*	  Each ring is written by one thread only (wait-free), and Stat() can be called from any thread.
+*	  Percentiles are calculated in Stat(), not in the frame loop.
+*/
+#ifndef _hlds_frametelemetry_H
+#define _hlds_frametelemetry_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#define TELEMETRY_FRAME_WRAP		(0x7fffffffL)	//Frame number after 0x7ffffffe is 0
+#define TELEMETRY_WINDOW			(4096)			//Frames of rolling percentiles
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Monotonic clock [nsec]
+	*/
+	inline long long TelemetryClock(void)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/**
+	* @brief
+	* 	Frames from a frame number to a later frame number (0x7fffffff wrap)
+	*/
+	inline long FrameNumberDiff(long from, long to)
+	{
+		if (to >= from){
+			return to - from;
+		}
+		return to + TELEMETRY_FRAME_WRAP - from;
+	}
+
+	/**
+	* @brief
+	* 	Timestamps of a frame
+	*/
+	struct FrameStamp {
+		long	framenumber;		///< Frame number
+		long long read;				///< Time when the frame was read [nsec] (TelemetryClock())
+		long long processed;		///< Time when processing of the frame finished [nsec] (0: not yet)
+		long long output;			///< Time when the frame was output [nsec] (0: not yet)
+	};
+
+	/**
+	* @brief
+	* 	Percentiles of latency [nsec]
+	*/
+	struct LatencyStat {
+		int		num;				///< Number of frames in the window
+		long long p50;				///< 50 percentile
+		long long p99;				///< 99 percentile
+		long long p999;				///< 99.9 percentile
+		long long max;				///< Max
+	};
+
+	/**
+	* @brief
+	* 	Statistics of a sensor
+	*/
+	struct TelemetryStat {
+		long long frames;			///< Frames read
+		long long dropped;			///< Frames skipped (gaps of frame number)
+		LatencyStat processed;		///< Latency from read to the end of processing
+		LatencyStat output;			///< Latency from read to output
+	};
+
+	/**
+	* @brief
+	* 	Telemetry of a sensor
+	*/
+	class FrameTelemetry {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		* @param	window	Frames of rolling percentiles
+		*/
+		FrameTelemetry(int window = TELEMETRY_WINDOW) : processed(window), output(window){
+			lastframeno = -1;
+			frames = 0;
+			dropped = 0;
+		};
+
+		/**
+		* @brief
+		* 	Stamp a frame that was read (reading thread only)
+		* @param	framenumber		Frame number of the frame
+		* @param	stamp			Output
+		* @param	period			Frame numbers between frames used (e.g. 3 if every third frame is used)
+		*/
+		void Read(long framenumber, FrameStamp& stamp, long period = 1){
+			stamp.framenumber = framenumber;
+			stamp.read = TelemetryClock();
+			stamp.processed = 0;
+			stamp.output = 0;
+			if (framenumber < 0){
+				//End of replay
+				return;
+			}
+			long last = lastframeno.load(std::memory_order_relaxed);
+			if (last >= 0){
+				long diff = FrameNumberDiff(last, framenumber);
+				if (diff > period){
+					dropped.fetch_add(diff - period, std::memory_order_relaxed);
+				}
+			}
+			lastframeno.store(framenumber, std::memory_order_relaxed);
+			frames.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/**
+		* @brief
+		* 	Stamp the end of processing (processing thread only)
+		* @return	Latency from read [nsec]
+		*/
+		long long Processed(FrameStamp& stamp){
+			stamp.processed = TelemetryClock();
+			long long latency = stamp.processed - stamp.read;
+			processed.Add(latency);
+			return latency;
+		}
+
+		/**
+		* @brief
+		* 	Stamp output (output thread only)
+		* @return	Latency from read [nsec]
+		*/
+		long long Output(FrameStamp& stamp){
+			stamp.output = TelemetryClock();
+			long long latency = stamp.output - stamp.read;
+			output.Add(latency);
+			return latency;
+		}
+
+		/**
+		* @brief
+		* 	Statistics (any thread, sorts the windows)
+		*/
+		TelemetryStat Stat(void) const {
+			TelemetryStat stat;
+			stat.frames = frames.load(std::memory_order_relaxed);
+			stat.dropped = dropped.load(std::memory_order_relaxed);
+			stat.processed = processed.Stat(work);
+			stat.output = output.Stat(work);
+			return stat;
+		}
+
+	private:
+		//Ring of latencies (one writer)
+		class Window {
+		public:
+			Window(int size) : values(new std::atomic<long long>[size]){
+				this->size = size;
+				count = 0;
+			};
+			~Window(){
+				delete[] values;
+			};
+
+			void Add(long long value){
+				unsigned int n = count.load(std::memory_order_relaxed);
+				values[n % size].store(value, std::memory_order_relaxed);
+				count.store(n + 1, std::memory_order_release);
+			}
+
+			LatencyStat Stat(std::vector<long long>& work) const {
+				LatencyStat stat;
+				unsigned int n = count.load(std::memory_order_acquire);
+				int num = (n < (unsigned int)size) ? (int)n : size;
+				stat.num = num;
+				stat.p50 = stat.p99 = stat.p999 = stat.max = 0;
+				if (num == 0){
+					return stat;
+				}
+				work.resize(num);
+				for (int i = 0; i < num; i++){
+					work[i] = values[i].load(std::memory_order_relaxed);
+				}
+				stat.p50 = Percentile(work, 0.5);
+				stat.p99 = Percentile(work, 0.99);
+				stat.p999 = Percentile(work, 0.999);
+				stat.max = *std::max_element(work.begin(), work.end());
+				return stat;
+			}
+
+		private:
+			std::atomic<long long>* values;
+			int		size;
+			std::atomic<unsigned int> count;
+
+			//Nearest rank
+			static long long Percentile(std::vector<long long>& work, double p){
+				size_t rank = (size_t)(p * work.size());
+				if (rank >= work.size()){
+					rank = work.size() - 1;
+				}
+				std::nth_element(work.begin(), work.begin() + rank, work.end());
+				return work[rank];
+			}
+
+			Window(const Window&);
+			Window& operator=(const Window&);
+		};
+
+		std::atomic<long> lastframeno;
+		std::atomic<long long> frames;
+		std::atomic<long long> dropped;
+		Window	processed;
+		Window	output;
+		mutable std::vector<long long> work;	//Work of Stat() (one thread calls Stat() at a time)
+
+		FrameTelemetry(const FrameTelemetry&);
+		FrameTelemetry& operator=(const FrameTelemetry&);
+	};
+
+}
+
+#endif //_hlds_frametelemetry_H
@@ -0,0 +1,462 @@
+/**
+* @file			TofHumanStore.h
+* @brief		Humans indexed by human ID
+* @date			2026.10.16
+* @version		v1.1.1
+*
+* @par Change History:
+* - 2026.10.16 New
+* - 2026.10.16 v1.1.0
+*	- Fields used every frame are kept as arrays (struct of arrays)
+*	- Track of each human is kept in TrackArena (indexed by handle)
+* - 2026.10.16 v1.1.1
+*	- Handle is 64 bits with 32 bit generation (16 bit generation wrapped after 65536 reuses of a slot)
+*
+* @remarks
+*	- Humans are kept in dense arrays (same order of use as std::vector), so loops over all humans stay simple.
+*	- Fields used for every human in every frame (id, x, y, prex, prey, enterdir, exitdir) are arrays
+*	  of HumanStore, so a loop over the humans reads only the arrays it uses.
+*	  Other fields are in T (one T per human, same index).
+*	- Human ID of SDK -> index of the arrays is an open addressing hash table (linear probing),
+*	  so a human is found in O(1) instead of a loop over all humans.
+*	- Removal moves the last human into the hole (swap and pop). Index of a human may change by removal,
+*	  but the handle of the human does not change until the human is removed.
+*	- Handle = slot number (lower 32 bits) + generation of the slot (upper 32 bits).
+*	  A handle of a removed human is not valid again until its slot is reused 2^32 times
+*	  (more than a year at 100 removals per second from one slot), so a stale handle is never taken for another human.
+*	- Track of a human is in the block of its slot in TrackArena, so a track is never moved by removal.
+*/
+#ifndef _hlds_humanstore_H
+#define _hlds_humanstore_H
+
+#include <stddef.h>
+#include <vector>
+
+#define HUMANSTORE_NO_HANDLE		(0xffffffffffffffffull)	//Invalid handle
+#define HUMANSTORE_MIN_TABLE		(16)				//Min size of hash table
+
+namespace hlds{
+
+	typedef unsigned long long HumanHandle;	///< Stable handle of a human
+
+	/**
+	* @brief
+	* 	Slot of a handle
+	*/
+	inline unsigned int HandleSlot(HumanHandle handle)
+	{
+		return (unsigned int)handle;
+	}
+
+	/**
+	* @brief
+	* 	Point of a track
+	*/
+	struct TrackPoint {
+		float	x;				///< X-coordinate [mm]
+		float	y;				///< Y-coordinate [mm]
+	};
+
+	/**
+	* @brief
+	* 	Tracks of humans (ring of a fixed number of points for each slot)
+	*/
+	class TrackArena {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		* @param	slots	Number of slots reserved
+		* @param	length	Max points in a track
+		*/
+		TrackArena(int slots = 0, int length = 100){
+			this->length = length;
+			Resize(slots);
+		};
+
+		/**
+		* @brief
+		* 	Number of slots (memory is allocated only when slots are increased)
+		*/
+		void Resize(int slots){
+			if (slots > (int)next.size()){
+				points.resize(slots * length);
+				next.resize(slots, 0);
+				count.resize(slots, 0);
+			}
+		}
+
+		/**
+		* @brief
+		* 	Max points in a track
+		*/
+		int Length(void) const {
+			return length;
+		}
+
+		/**
+		* @brief
+		* 	Clear the track of a slot
+		*/
+		void Reset(unsigned int slot){
+			Resize(slot + 1);
+			next[slot] = 0;
+			count[slot] = 0;
+		}
+
+		/**
+		* @brief
+		* 	Add a point to the track of a slot (the oldest point is overwritten when full)
+		*/
+		void Push(unsigned int slot, float x, float y){
+			TrackPoint& p = points[slot * length + next[slot]];
+			p.x = x;
+			p.y = y;
+			next[slot]++;
+			if (next[slot] == length){
+				next[slot] = 0;
+			}
+			if (count[slot] < length){
+				count[slot]++;
+			}
+		}
+
+		/**
+		* @brief
+		* 	Number of points in the track of a slot
+		*/
+		int Count(unsigned int slot) const {
+			return count[slot];
+		}
+
+		/**
+		* @brief
+		* 	Point of the track of a slot
+		* @param	slot	Slot
+		* @param	n		0: the oldest point to Count() - 1: the newest point
+		*/
+		const TrackPoint& Point(unsigned int slot, int n) const {
+			int tno = (count[slot] == length) ? next[slot] + n : n;
+			if (tno >= length){
+				tno -= length;
+			}
+			return points[slot * length + tno];
+		}
+
+		/**
+		* @brief
+		* 	Copy the track of a slot from another arena (same length)
+		*/
+		void Copy(const TrackArena& src, unsigned int slot){
+			Resize(slot + 1);
+			next[slot] = src.next[slot];
+			count[slot] = src.count[slot];
+			const TrackPoint* s = &src.points[slot * length];
+			TrackPoint* d = &points[slot * length];
+			for (int i = 0; i < count[slot]; i++){
+				d[i] = s[i];
+			}
+		}
+
+	private:
+		int		length;							//Max points in a track
+		std::vector<TrackPoint> points;			//Points (length points for each slot)
+		std::vector<int> next;					//Next point to write of each slot
+		std::vector<int> count;					//Number of points of each slot
+	};
+
+	/**
+	* @brief
+	* 	Humans indexed by human ID (T is the other fields of a human)
+	*/
+	template <class T>
+	class HumanStore {
+	public:
+		std::vector<long> id;					///< Human ID managed in SDK
+		std::vector<float> x;					///< X-coordinate
+		std::vector<float> y;					///< Y-coordinate
+		std::vector<float> prex;				///< Previous X-coordinate
+		std::vector<float> prey;				///< Previous Y-coordinate
+		std::vector<int> enterdir;				///< Direction entering to the count area
+		std::vector<int> exitdir;				///< Direction exiting from the count area
+		TrackArena tracks;						///< Track of each human (by Slot())
+
+		/**
+		* @brief
+		* 	Constructor
+		* @param	capacity	Humans reserved
+		* @param	tracklength	Max points in a track
+		*/
+		HumanStore(int capacity = 64, int tracklength = 100) : tracks(capacity, tracklength){
+			mask = 0;
+			Reserve(capacity);
+		};
+
+		/**
+		* @brief
+		* 	Reserve memory for humans (no allocation until more humans)
+		*/
+		void Reserve(int capacity){
+			id.reserve(capacity);
+			x.reserve(capacity);
+			y.reserve(capacity);
+			prex.reserve(capacity);
+			prey.reserve(capacity);
+			enterdir.reserve(capacity);
+			exitdir.reserve(capacity);
+			items.reserve(capacity);
+			handles.reserve(capacity);
+			slotindex.reserve(capacity);
+			generation.reserve(capacity);
+			freeslots.reserve(capacity);
+			tracks.Resize(capacity);
+			unsigned int size = HUMANSTORE_MIN_TABLE;
+			while (size < (unsigned int)capacity * 2){
+				size *= 2;
+			}
+			if (size > mask + 1){
+				Rehash(size);
+			}
+		}
+
+		/**
+		* @brief
+		* 	Number of humans
+		*/
+		int Size(void) const {
+			return (int)items.size();
+		}
+
+		/**
+		* @brief
+		* 	Other fields of a human of an index (0 to Size() - 1)
+		*/
+		T& operator[](int i){
+			return items[i];
+		}
+		const T& operator[](int i) const {
+			return items[i];
+		}
+
+		/**
+		* @brief
+		* 	Handle of a human of an index
+		*/
+		HumanHandle Handle(int i) const {
+			return handles[i];
+		}
+
+		/**
+		* @brief
+		* 	Slot of a human of an index (for tracks)
+		*/
+		unsigned int Slot(int i) const {
+			return HandleSlot(handles[i]);
+		}
+
+		/**
+		* @brief
+		* 	Find a human by human ID
+		* @return	Index (-1: not found)
+		*/
+		int Find(long humanid) const {
+			int pos = Position(humanid);
+			return (pos < 0) ? -1 : values[pos];
+		}
+
+		/**
+		* @brief
+		* 	Index of a human by handle
+		* @return	Index (-1: the human was removed)
+		*/
+		int IndexOf(HumanHandle handle) const {
+			unsigned int slot = HandleSlot(handle);
+			if ((handle == HUMANSTORE_NO_HANDLE) || (slot >= slotindex.size()) || (generation[slot] != (unsigned int)(handle >> 32))){
+				return -1;
+			}
+			return slotindex[slot];
+		}
+
+		/**
+		* @brief
+		* 	Add a human (all fields are 0 except id, track is empty)
+		*
+		*	- The ID must not be in the store (check by Find()).
+		* @param	humanid		Human ID
+		* @return	Index of the added human (Size() - 1)
+		*/
+		int Add(long humanid){
+			if ((items.size() + 1) * 2 > mask + 1){
+				Rehash((mask + 1) * 2);
+			}
+
+			//Slot
+			unsigned int slot;
+			if (!freeslots.empty()){
+				slot = freeslots.back();
+				freeslots.pop_back();
+			}
+			else {
+				slot = (unsigned int)slotindex.size();
+				slotindex.push_back(-1);
+				generation.push_back(0);
+			}
+			int index = (int)items.size();
+			slotindex[slot] = index;
+			handles.push_back(((HumanHandle)generation[slot] << 32) | slot);
+			tracks.Reset(slot);
+
+			//Human
+			id.push_back(humanid);
+			x.push_back(0);
+			y.push_back(0);
+			prex.push_back(0);
+			prey.push_back(0);
+			enterdir.push_back(0);
+			exitdir.push_back(0);
+			items.emplace_back();
+			Insert(humanid, index);
+			return index;
+		}
+
+		/**
+		* @brief
+		* 	Remove a human (the last human is moved to the index)
+		*
+		*	- When removing in a loop, loop from the last index to 0.
+		*/
+		void RemoveAt(int i){
+			Erase(id[i]);
+
+			unsigned int slot = HandleSlot(handles[i]);
+			slotindex[slot] = -1;
+			generation[slot]++;
+			freeslots.push_back(slot);
+
+			int last = (int)items.size() - 1;
+			if (i != last){
+				id[i] = id[last];
+				x[i] = x[last];
+				y[i] = y[last];
+				prex[i] = prex[last];
+				prey[i] = prey[last];
+				enterdir[i] = enterdir[last];
+				exitdir[i] = exitdir[last];
+				items[i] = items[last];
+				handles[i] = handles[last];
+				slotindex[HandleSlot(handles[i])] = i;
+				values[Position(id[i])] = i;
+			}
+			id.pop_back();
+			x.pop_back();
+			y.pop_back();
+			prex.pop_back();
+			prey.pop_back();
+			enterdir.pop_back();
+			exitdir.pop_back();
+			items.pop_back();
+			handles.pop_back();
+		}
+
+		/**
+		* @brief
+		* 	Remove all humans (all handles become invalid)
+		*/
+		void Clear(void){
+			for (int i = Size() - 1; i >= 0; i--){
+				RemoveAt(i);
+			}
+		}
+
+		/**
+		* @brief
+		* 	Copy all humans and their tracks (tracks of removed humans are not copied)
+		*
+		*	- No memory is allocated if this store has enough capacity.
+		*/
+		void CopyFrom(const HumanStore& src){
+			id = src.id;
+			x = src.x;
+			y = src.y;
+			prex = src.prex;
+			prey = src.prey;
+			enterdir = src.enterdir;
+			exitdir = src.exitdir;
+			items = src.items;
+			handles = src.handles;
+			slotindex = src.slotindex;
+			generation = src.generation;
+			freeslots = src.freeslots;
+			keys = src.keys;
+			values = src.values;
+			mask = src.mask;
+			for (int i = 0; i < Size(); i++){
+				tracks.Copy(src.tracks, Slot(i));
+			}
+		}
+
+	private:
+		std::vector<T> items;					//Other fields of humans
+		std::vector<HumanHandle> handles;		//Handle of each human
+		std::vector<int> slotindex;				//Index of human of each slot (-1: free)
+		std::vector<unsigned int> generation;	//Generation of each slot
+		std::vector<unsigned int> freeslots;	//Free slots
+		std::vector<long> keys;					//Hash table: human ID
+		std::vector<int> values;				//Hash table: index of human (-1: empty)
+		unsigned int mask;						//Size of hash table - 1
+
+		unsigned int Hash(long humanid) const {
+			return ((unsigned int)humanid * 2654435761u) & mask;
+		}
+
+		//Position in hash table (-1: not found)
+		int Position(long humanid) const {
+			for (unsigned int pos = Hash(humanid); values[pos] >= 0; pos = (pos + 1) & mask){
+				if (keys[pos] == humanid){
+					return (int)pos;
+				}
+			}
+			return -1;
+		}
+
+		void Insert(long humanid, int index){
+			unsigned int pos = Hash(humanid);
+			while (values[pos] >= 0){
+				pos = (pos + 1) & mask;
+			}
+			keys[pos] = humanid;
+			values[pos] = index;
+		}
+
+		//Remove from hash table (following entries are shifted back, no tombstone)
+		void Erase(long humanid){
+			int found = Position(humanid);
+			if (found < 0){
+				return;
+			}
+			unsigned int hole = (unsigned int)found;
+			for (unsigned int pos = (hole + 1) & mask; values[pos] >= 0; pos = (pos + 1) & mask){
+				//Move the entry to the hole if the hole is between its home position and its position
+				unsigned int home = Hash(keys[pos]);
+				if (((pos - home) & mask) >= ((pos - hole) & mask)){
+					keys[hole] = keys[pos];
+					values[hole] = values[pos];
+					hole = pos;
+				}
+			}
+			values[hole] = -1;
+		}
+
+		void Rehash(unsigned int size){
+			mask = size - 1;
+			keys.assign(size, 0);
+			values.assign(size, -1);
+			for (int i = 0; i < (int)items.size(); i++){
+				Insert(id[i], i);
+			}
+		}
+	};
+
+}
+
+#endif //_hlds_humanstore_H
@@ -3,7 +3,7 @@
 * @brief		Sample program for Hitachi-LG Data Storage (HLDS)'s TOF Motion Sensor
 * @author		Hitachi-LG Data Storage, Inc. (HLDS)
 * @date			2018.02.13
-* @version		v1.1.0
+* @version		v1.2.0
 * @copyright	Hitachi-LG Data Storage,Inc.
 *
 * @par Change History:
@@ -14,6 +14,8 @@
 *					- Delete unnecessary comment
 * - 2018.02.13 v1.1.0
 *					- Add close window function
+* - 2026.10.16 v1.2.0
+*					- Reuse picture buffer of each TOF sensor
 */
 
 #include <stdio.h>
@@ -22,6 +24,10 @@
 #include <Windows.h>
 
 #include "tof.h"
+#ifdef _DEBUG
+#define TOF_COUNT_ALLOCATIONS	// Count allocations (to check no allocation in a frame)
+#endif
+#include "TofFramePool.h"
 
 #include <opencv2/opencv.hpp>
 //#include <opencv2/opencv_lib.hpp>
@@ -126,6 +132,12 @@ void main(void)
 	// Create instances for reading frames
 	FrameIr * frame = new FrameIr[numoftof];
 
+	// Picture of each TOF sensor (buffer is reused every frame)
+	MatPool subpool(numoftof);
+#ifdef _DEBUG
+	AllocationCheck alloccheck;
+#endif
+
 	// For measure FPS
 	struct Timer {
 		float fps;
@@ -155,6 +167,9 @@ void main(void)
 
 		// Loop for each TOF sensor
 		for (int tofno = 0; tofno < numoftof; tofno++){
+#ifdef _DEBUG
+			alloccheck.Begin();
+#endif
 
 			if (tofenable[tofno] == true){
 
@@ -188,8 +203,8 @@ void main(void)
 				}
 
 				// Create picture
-				std::vector<unsigned short> buf;
-				buf.resize(frame[tofno].width * frame[tofno].height);
+				cv::Mat& sub = subpool.Get(tofno, frame[tofno].height, frame[tofno].width, CV_16UC1);
+				unsigned short* buf = (unsigned short*)sub.data;
 
 				if (isFlip == false){
 					// Reverse(Mirror) mode
@@ -206,9 +221,6 @@ void main(void)
 					}
 				}
 
-				// Make OpenCV matrix (16bits 1 color) from IR data
-				cv::Mat sub(frame[tofno].height, frame[tofno].width, CV_16UC1, &buf[0]);
-
 				// Set ROI to the position in multi display
 				int col = tofno % screen_col;
 				int row = tofno / screen_row;
@@ -216,6 +228,11 @@ void main(void)
 
 				// Copy and adjust size the matrix of depth data to ROI(display position)
 				cv::resize(sub, roi, roi.size(), cv::INTER_LINEAR);
+#ifdef _DEBUG
+				if (alloccheck.End() != 0){
+					std::cout << "TOF ID " << tof[tofno].tofinfo.tofid << " allocated memory in a frame" << endl;
+				}
+#endif
 
 				string text;
 
@@ -236,16 +253,13 @@ void main(void)
 			}
 			else{
 				// Create gray picture
-				std::vector<unsigned short> buf;
-				buf.resize(frame[tofno].width * frame[tofno].height);
+				cv::Mat& sub = subpool.Get(tofno, frame[tofno].height, frame[tofno].width, CV_16UC1);
+				unsigned short* buf = (unsigned short*)sub.data;
 
 				for (int i = 0; i < frame[tofno].width * frame[tofno].height; i++){
 					buf[i] = 100 << 8;	// 8 bit -> 16 bit
 				}
 
-				// Make OpenCV matrix(16 bits 1 color)
-				cv::Mat sub(frame[tofno].height, frame[tofno].width, CV_16UC1, &buf[0]);
-
 				// Set ROI to the position in multi display
 				int col = tofno % screen_col;
 				int row = tofno / screen_row;
@@ -253,6 +267,11 @@ void main(void)
 
 				// Copy and adjust size the matrix of depth data to ROI(display position)
 				cv::resize(sub, roi, roi.size(), cv::INTER_LINEAR);
+#ifdef _DEBUG
+				if (alloccheck.End() != 0){
+					std::cout << "TOF ID " << tof[tofno].tofinfo.tofid << " allocated memory in a frame" << endl;
+				}
+#endif
 
 				string text;
 
@@ -357,6 +376,10 @@ void main(void)
 	delete[] tofenable;
 	cv::destroyAllWindows();
 
+#ifdef _DEBUG
+	std::cout << alloccheck.badframes << " of " << alloccheck.frames << " frames allocated memory" << endl;
+#endif
+
 	if (berror){
 		system("pause");
 	}
@@ -0,0 +1,466 @@
+/**
+* @file			TofMetrics.h
+* @brief		Counters, gauges and histograms of the pipeline, and HTTP server of Prometheus text format
+* @date			2026.10.16
+* @version		v1.0.1
+*
+* @par Change History:
+* - 2026.10.16 New
+* - 2026.10.16 v1.0.1
+*					- No SIGPIPE when a client disconnects before the answer is sent (Linux, macOS)
+*
+* @remarks
+*	- Metrics are registered once before the threads start (MetricsRegistry::Counter(), Gauge(), Histogram()).
+*	  After that no memory is allocated by recording.
+*	- Recording is wait-free: Add() and Observe() are one or two atomic additions, Set() is one atomic store.
+*	  Each metric has its own cache lines, so threads recording different metrics do not share a cache line.
+*	- Histograms have fixed buckets of integer values (e.g. usec). Values are written multiplied by the scale
+*	  (e.g. 0.000001 for seconds).
+*	- MetricsServer answers every HTTP request to 127.0.0.1:port with all metrics in Prometheus text format
+*	  (e.g. curl http://127.0.0.1:9464/metrics). Only the local host can connect.
+*	- When Windows.h is included before this file, include WinSock2.h before Windows.h.
+*/
+#ifndef _hlds_metrics_H
+#define _hlds_metrics_H
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+#include <WinSock2.h>
+#include <Windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#define METRICS_MAX_METRICS		(64)			//Max number of metrics in a registry
+#define METRICS_MAX_BUCKETS		(16)			//Max number of buckets of a histogram (without +Inf)
+#define METRICS_CACHE_LINE		(64)			//Size of cache line (each metric is aligned)
+#define METRICS_PORT			(9464)			//Default port of HTTP server
+#define METRICS_WAIT_MSEC		(100)			//Wait of server thread for a connection (to check stop)
+#ifdef MSG_NOSIGNAL
+#define METRICS_SEND_FLAGS		(MSG_NOSIGNAL)	//send() returns an error instead of SIGPIPE (Linux)
+#else
+#define METRICS_SEND_FLAGS		(0)				//Flags of send()
+#endif
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Type of metric
+	*/
+	enum class MetricType {
+		Counter = 0,		///< Value only increases
+		Gauge,				///< Value is set
+		Histogram,			///< Number of values in each bucket
+	};
+
+	/**
+	* @brief
+	* 	Upper bounds of latency histograms [usec] (11 buckets, 0.1 msec to 250 msec)
+	*/
+	inline const long long* MetricLatencyBuckets(int& num)
+	{
+		static const long long bounds[] = { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000 };
+		num = (int)(sizeof(bounds) / sizeof(bounds[0]));
+		return bounds;
+	}
+
+	/**
+	* @brief
+	* 	Current time for latency [usec] (steady clock)
+	*/
+	inline long long MetricClock(void)
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/**
+	* @brief
+	* 	Metric (counter, gauge or histogram)
+	*/
+	class alignas(METRICS_CACHE_LINE) Metric {
+	public:
+		/**
+		* @brief
+		* 	Add to counter (wait-free)
+		*/
+		void Add(long long value = 1){
+			count.fetch_add(value, std::memory_order_relaxed);
+		}
+
+		/**
+		* @brief
+		* 	Set gauge (wait-free)
+		*/
+		void Set(double value){
+			gauge.store(value, std::memory_order_relaxed);
+		}
+
+		/**
+		* @brief
+		* 	Add a value to histogram (wait-free)
+		*/
+		void Observe(long long value){
+			int bno = 0;
+			while ((bno < numofbucket) && (value > bounds[bno])){
+				bno++;
+			}
+			buckets[bno].fetch_add(1, std::memory_order_relaxed);
+			sum.fetch_add(value, std::memory_order_relaxed);
+		}
+
+		/**
+		* @brief
+		* 	Value of counter
+		*/
+		long long Count(void) const {
+			return count.load(std::memory_order_relaxed);
+		}
+
+		/**
+		* @brief
+		* 	Value of gauge
+		*/
+		double Value(void) const {
+			return gauge.load(std::memory_order_relaxed);
+		}
+
+	private:
+		friend class MetricsRegistry;
+
+		MetricType type;
+		const char* name;
+		const char* help;
+		double	scale;										//Scale of values of histogram in text
+		int		numofbucket;
+		long long bounds[METRICS_MAX_BUCKETS];				//Upper bounds of buckets (included)
+		std::atomic<long long> count;						//Counter
+		std::atomic<double> gauge;							//Gauge
+		std::atomic<long long> sum;							//Sum of values of histogram
+		std::atomic<long long> buckets[METRICS_MAX_BUCKETS + 1];	//Last one is +Inf
+	};
+
+	/**
+	* @brief
+	* 	Fixed set of metrics
+	*/
+	class MetricsRegistry {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		*/
+		MetricsRegistry(){
+			size = 0;
+		};
+
+		/**
+		* @brief
+		* 	Register a counter (before recording threads start)
+		* @param	name	Name (string literal, kept as pointer)
+		* @param	help	Description (string literal, kept as pointer)
+		* @return	Metric (NULL: too many metrics)
+		*/
+		Metric* Counter(const char* name, const char* help){
+			return New(MetricType::Counter, name, help);
+		}
+
+		/**
+		* @brief
+		* 	Register a gauge (before recording threads start)
+		*/
+		Metric* Gauge(const char* name, const char* help){
+			return New(MetricType::Gauge, name, help);
+		}
+
+		/**
+		* @brief
+		* 	Register a histogram (before recording threads start)
+		* @param	bounds	Upper bounds of buckets (ascending, METRICS_MAX_BUCKETS or less)
+		* @param	num		Number of bounds
+		* @param	scale	Scale of values in text (e.g. 0.000001 for usec to seconds)
+		*/
+		Metric* Histogram(const char* name, const char* help, const long long* bounds, int num, double scale){
+			Metric* metric = New(MetricType::Histogram, name, help);
+			if (metric == NULL){
+				return NULL;
+			}
+			if (num > METRICS_MAX_BUCKETS){
+				num = METRICS_MAX_BUCKETS;
+			}
+			metric->numofbucket = num;
+			memcpy(metric->bounds, bounds, sizeof(long long) * num);
+			metric->scale = scale;
+			return metric;
+		}
+
+		/**
+		* @brief
+		* 	Number of metrics
+		*/
+		int Size(void) const {
+			return size.load(std::memory_order_acquire);
+		}
+
+		/**
+		* @brief
+		* 	Write all metrics in Prometheus text format (any thread)
+		* @param	out		Output (cleared, capacity is reused)
+		*/
+		void Format(std::string& out) const {
+			out.clear();
+			char buff[256];
+			int num = Size();
+			for (int mno = 0; mno < num; mno++){
+				const Metric& m = metrics[mno];
+				static const char* types[3] = { "counter", "gauge", "histogram" };
+				snprintf(buff, sizeof(buff), "# HELP %s %s\n# TYPE %s %s\n", m.name, m.help, m.name, types[(int)m.type]);
+				out += buff;
+				switch (m.type){
+				case MetricType::Counter:
+					snprintf(buff, sizeof(buff), "%s %lld\n", m.name, m.Count());
+					out += buff;
+					break;
+				case MetricType::Gauge:
+					snprintf(buff, sizeof(buff), "%s %.10g\n", m.name, m.Value());
+					out += buff;
+					break;
+				case MetricType::Histogram:
+				{
+					//Buckets are cumulative, count is the sum of buckets
+					long long total = 0;
+					for (int bno = 0; bno <= m.numofbucket; bno++){
+						total += m.buckets[bno].load(std::memory_order_relaxed);
+						if (bno < m.numofbucket){
+							snprintf(buff, sizeof(buff), "%s_bucket{le=\"%.10g\"} %lld\n", m.name, m.bounds[bno] * m.scale, total);
+						}
+						else {
+							snprintf(buff, sizeof(buff), "%s_bucket{le=\"+Inf\"} %lld\n", m.name, total);
+						}
+						out += buff;
+					}
+					snprintf(buff, sizeof(buff), "%s_sum %.10g\n%s_count %lld\n", m.name,
+						m.sum.load(std::memory_order_relaxed) * m.scale, m.name, total);
+					out += buff;
+					break;
+				}
+				}
+			}
+		}
+
+	private:
+		Metric	metrics[METRICS_MAX_METRICS];
+		std::atomic<int> size;
+
+		Metric* New(MetricType type, const char* name, const char* help){
+			int mno = size.load(std::memory_order_relaxed);
+			if (mno >= METRICS_MAX_METRICS){
+				return NULL;
+			}
+			Metric& m = metrics[mno];
+			m.type = type;
+			m.name = name;
+			m.help = help;
+			m.scale = 1.0;
+			m.numofbucket = 0;
+			m.count.store(0, std::memory_order_relaxed);
+			m.gauge.store(0.0, std::memory_order_relaxed);
+			m.sum.store(0, std::memory_order_relaxed);
+			for (int bno = 0; bno <= METRICS_MAX_BUCKETS; bno++){
+				m.buckets[bno].store(0, std::memory_order_relaxed);
+			}
+			size.store(mno + 1, std::memory_order_release);
+			return &m;
+		}
+
+		MetricsRegistry(const MetricsRegistry&);
+		MetricsRegistry& operator=(const MetricsRegistry&);
+	};
+
+	/**
+	* @brief
+	* 	HTTP server of metrics on the loopback address
+	*/
+	class MetricsServer {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		*/
+		MetricsServer(){
+			brun = false;
+			requests = 0;
+		};
+
+		/**
+		* @brief
+		* 	Destructor
+		*/
+		~MetricsServer(){
+			Stop();
+		};
+
+		/**
+		* @brief
+		* 	Start server thread
+		* @param	registry	Metrics (must live until Stop())
+		* @param	port		Port of 127.0.0.1
+		* @return	true: OK
+		*/
+		bool Start(const MetricsRegistry* registry, int port = METRICS_PORT){
+			Stop();
+#ifdef _WIN32
+			WSADATA wsadata;
+			if (WSAStartup(MAKEWORD(2, 2), &wsadata) != 0){
+				return false;
+			}
+#endif
+			listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+			if (!IsValid(listener)){
+				Cleanup();
+				return false;
+			}
+			int reuse = 1;
+			setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+			sockaddr_in addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sin_family = AF_INET;
+			addr.sin_port = htons((unsigned short)port);
+			addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			if ((bind(listener, (const sockaddr*)&addr, sizeof(addr)) != 0) || (listen(listener, 4) != 0)){
+				CloseSocket(listener);
+				Cleanup();
+				return false;
+			}
+			metrics = registry;
+			brun = true;
+			server = std::thread(&MetricsServer::Run, this);
+			return true;
+		}
+
+		/**
+		* @brief
+		* 	Stop server thread
+		*/
+		void Stop(void){
+			if (!server.joinable()){
+				return;
+			}
+			brun.store(false, std::memory_order_release);
+			server.join();
+			CloseSocket(listener);
+			Cleanup();
+		}
+
+		/**
+		* @brief
+		* 	Number of answered requests
+		*/
+		long Requests(void) const {
+			return requests.load(std::memory_order_relaxed);
+		}
+
+	private:
+#ifdef _WIN32
+		typedef SOCKET Socket;
+		static bool IsValid(Socket s){ return s != INVALID_SOCKET; }
+		static void CloseSocket(Socket s){ closesocket(s); }
+		static void Cleanup(void){ WSACleanup(); }
+#else
+		typedef int Socket;
+		static bool IsValid(Socket s){ return s >= 0; }
+		static void CloseSocket(Socket s){ close(s); }
+		static void Cleanup(void){}
+#endif
+
+		const MetricsRegistry* metrics;
+		Socket	listener;
+		std::thread server;
+		std::atomic<bool> brun;
+		std::atomic<long> requests;
+
+		//Server thread
+		void Run(void){
+			std::string body;
+			std::string response;
+			char request[2048];
+			while (brun.load(std::memory_order_acquire)){
+				//Wait for a connection (timeout to check stop)
+				fd_set fds;
+				FD_ZERO(&fds);
+				FD_SET(listener, &fds);
+				timeval timeout;
+				timeout.tv_sec = 0;
+				timeout.tv_usec = METRICS_WAIT_MSEC * 1000;
+				if (select((int)listener + 1, &fds, NULL, NULL, &timeout) <= 0){
+					continue;
+				}
+				Socket client = accept(listener, NULL, NULL);
+				if (!IsValid(client)){
+					continue;
+				}
+#ifdef SO_NOSIGPIPE
+				//send() returns an error instead of SIGPIPE (macOS, no MSG_NOSIGNAL)
+				int nosigpipe = 1;
+				setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&nosigpipe, sizeof(nosigpipe));
+#endif
+
+				//Read the request header (contents are not used)
+				int received = 0;
+				while (received < (int)sizeof(request) - 1){
+					FD_ZERO(&fds);
+					FD_SET(client, &fds);
+					timeout.tv_sec = 1;
+					timeout.tv_usec = 0;
+					if (select((int)client + 1, &fds, NULL, NULL, &timeout) <= 0){
+						break;
+					}
+					int n = (int)recv(client, request + received, sizeof(request) - 1 - received, 0);
+					if (n <= 0){
+						break;
+					}
+					received += n;
+					request[received] = 0;
+					if (strstr(request, "\r\n\r\n") != NULL){
+						break;
+					}
+				}
+
+				//Answer all metrics
+				metrics->Format(body);
+				char header[128];
+				snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+					"Content-Length: %d\r\nConnection: close\r\n\r\n", (int)body.size());
+				response = header;
+				response += body;
+				int sent = 0;
+				while (sent < (int)response.size()){
+					int n = (int)send(client, response.data() + sent, (int)response.size() - sent, METRICS_SEND_FLAGS);
+					if (n <= 0){
+						break;
+					}
+					sent += n;
+				}
+				CloseSocket(client);
+				requests.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		MetricsServer(const MetricsServer&);
+		MetricsServer& operator=(const MetricsServer&);
+	};
+
+}
+
+#endif //_hlds_metrics_H
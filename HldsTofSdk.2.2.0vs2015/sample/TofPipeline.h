@@ -0,0 +1,177 @@
+/**
+* @file			TofPipeline.h
+* @brief		Bounded lock-free ring of preallocated slots between pipeline stages
+* @date			2026.10.16
+* @version		v1.0.1
+*
+* @par Change History:
+* - 2026.10.16 New
+* - 2026.10.16 v1.0.1
+*					- Indexes wrap at twice the number of slots (any number of slots, no 2^32 wrap)
+*
+* @remarks
+*	- Single producer / single consumer. One thread writes slots, one other thread reads them.
+*	- Slots are created once. The producer fills a slot in place (Claim() and Publish()) and
+*	  the consumer uses it in place (Front() and Pop()), so no frame is copied or allocated.
+*	- When the ring is full the producer drops the frame (Drop()) instead of waiting,
+*	  so a slow stage never stops the stage before it.
+*	- Indexes of head and tail run from 0 to 2 * size - 1, so full (size apart) and empty (same)
+*	  are different for any number of slots.
+*/
+#ifndef _hlds_pipeline_H
+#define _hlds_pipeline_H
+
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+
+#define PIPELINE_CACHE_LINE		(64)		//Size of cache line (to separate indexes of producer and consumer)
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Statistics of a ring
+	*/
+	struct PipelineStat {
+		long	published;			///< Number of frames passed to the next stage
+		long	dropped;			///< Number of frames dropped because the ring was full
+		int		depth;				///< Number of frames waiting in the ring
+		int		maxdepth;			///< Max number of frames waiting in the ring
+		int		size;				///< Number of slots
+	};
+
+	/**
+	* @brief
+	* 	Bounded single producer / single consumer ring
+	*/
+	template <class T>
+	class SpscRing {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		* @param	size	Number of slots
+		*/
+		SpscRing(int size) : slots(size){
+			wrap = 2 * (unsigned int)size;
+			head = 0;
+			tail = 0;
+			published = 0;
+			dropped = 0;
+			maxdepth = 0;
+		};
+
+		/**
+		* @brief
+		* 	Get a free slot to fill (producer)
+		* @return	Slot (NULL: ring is full)
+		*/
+		T* Claim(void){
+			unsigned int t = tail.load(std::memory_order_relaxed);
+			if (Distance(head.load(std::memory_order_acquire), t) >= slots.size()){
+				return NULL;
+			}
+			return Slot(t);
+		}
+
+		/**
+		* @brief
+		* 	Pass the slot got by Claim() to the consumer (producer)
+		*/
+		void Publish(void){
+			unsigned int t = Next(tail.load(std::memory_order_relaxed));
+			tail.store(t, std::memory_order_release);
+			published.fetch_add(1, std::memory_order_relaxed);
+			int depth = (int)Distance(head.load(std::memory_order_relaxed), t);
+			if (depth > maxdepth.load(std::memory_order_relaxed)){
+				maxdepth.store(depth, std::memory_order_relaxed);
+			}
+		}
+
+		/**
+		* @brief
+		* 	Count a frame dropped because the ring was full (producer)
+		*/
+		void Drop(void){
+			dropped.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		/**
+		* @brief
+		* 	Get the oldest published slot (consumer)
+		* @return	Slot (NULL: ring is empty)
+		*/
+		T* Front(void){
+			unsigned int h = head.load(std::memory_order_relaxed);
+			if (h == tail.load(std::memory_order_acquire)){
+				return NULL;
+			}
+			return Slot(h);
+		}
+
+		/**
+		* @brief
+		* 	Return the slot got by Front() to the producer (consumer)
+		*/
+		void Pop(void){
+			head.store(Next(head.load(std::memory_order_relaxed)), std::memory_order_release);
+		}
+
+		/**
+		* @brief
+		* 	Number of frames waiting (any thread)
+		*/
+		int Depth(void) const {
+			unsigned int h = head.load(std::memory_order_acquire);
+			return (int)Distance(h, tail.load(std::memory_order_acquire));
+		}
+
+		/**
+		* @brief
+		* 	Statistics (any thread)
+		*/
+		PipelineStat Stat(void) const {
+			PipelineStat stat;
+			stat.published = published.load(std::memory_order_relaxed);
+			stat.dropped = dropped.load(std::memory_order_relaxed);
+			stat.depth = Depth();
+			stat.maxdepth = maxdepth.load(std::memory_order_relaxed);
+			stat.size = (int)slots.size();
+			return stat;
+		}
+
+	private:
+		std::vector<T> slots;					//Preallocated slots
+		unsigned int wrap;						//Indexes wrap at this (2 * number of slots)
+		std::atomic<unsigned int> head;			//Next slot to read (written by consumer)
+		char	pad1[PIPELINE_CACHE_LINE];
+		std::atomic<unsigned int> tail;			//Next slot to write (written by producer)
+		char	pad2[PIPELINE_CACHE_LINE];
+		std::atomic<long> published;
+		std::atomic<long> dropped;
+		std::atomic<int> maxdepth;
+
+		//Index after i
+		unsigned int Next(unsigned int i) const {
+			return (i + 1 == wrap) ? 0 : i + 1;
+		}
+
+		//Number of indexes from h to t
+		unsigned int Distance(unsigned int h, unsigned int t) const {
+			return (t >= h) ? t - h : t + wrap - h;
+		}
+
+		//Slot of index i
+		T* Slot(unsigned int i){
+			unsigned int size = wrap / 2;
+			return &slots[(i < size) ? i : i - size];
+		}
+
+		SpscRing(const SpscRing&);
+		SpscRing& operator=(const SpscRing&);
+	};
+
+}
+
+#endif //_hlds_pipeline_H
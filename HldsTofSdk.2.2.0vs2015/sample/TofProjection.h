@@ -0,0 +1,462 @@
+/**
+* @file			TofProjection.h
+* @brief		Fused depth-to-top-view projection kernel for the TOF samples
+* @date			2026.10.16
+* @version		v1.5.0
+*
+* @par Change History:
+* - 2026.10.16 New
+* - 2026.10.16 v1.1.0
+*					- Distance gate by packed validity mask of DepthGate
+* - 2026.10.16 v1.2.0
+*					- Row major epoch stamped Z-buffer (ZBuffer) with color index as depth
+* - 2026.10.16 v1.3.0
+*					- Packed color table (ColorLut) in place of FrameDepth::ColorTable
+* - 2026.10.16 v1.4.0
+*					- ColorLut is given as it is (quality / speed mode of ColorLut::SetQuantize())
+* - 2026.10.16 v1.5.0
+*					- Points of the top view as splats (RasterSplat of TofRasterizer.h), drawn by ResolveTopView()
+*
+* @remarks
+*	- One pass over the frame does the distance gate (or reads the mask of DepthGate), zoom/shift, Z range test,
+*	  Z-buffer test, coloring of the top view and of the sub display.
+*	- The gate, projection and color index are calculated for 8 (AVX2) or 4 (SSE4.1)
+*	  pixels at once. Z-buffer test and writes are done only for the pixels that passed.
+*	- Points larger than a pixel (TopViewParam::splat) are only written to the Z-buffer, and the top view is
+*	  drawn from the Z-buffer after all rows (ResolveTopView()), so each pixel has the color of the front point.
+*	- No dependency on the SDK DLL, Windows or OpenCV (images are given as raw BGR buffers).
+*/
+#ifndef _hlds_projection_H
+#define _hlds_projection_H
+
+#include <stddef.h>
+
+#include "tof.h"
+#include "TofSimd.h"
+#include "TofDepthGate.h"
+#include "TofZBuffer.h"
+#include "TofColorizer.h"
+#include "TofRasterizer.h"
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Parameters of a top view projection
+	*/
+	struct TopViewParam {
+		//Depth frame
+		const unsigned short* depth;					///< Depth data (FrameMatrix::databuf)
+		float	depth_min;								///< distance_min of the depth frame (Length of 0x0000)
+		float	depth_max;								///< distance_max of the depth frame (Length of 0xfffe)
+		const ColorLut* colorlut;						///< Packed color table
+		const unsigned int* mask;						///< Packed validity mask of DepthGate::Gate() (NULL = gate by distance_min/max)
+
+		//3D frame(after conversion and rotation)
+		TofPoint* points;								///< 3D points (Frame3d::frame3d), invalid points are set to (0,0,0)
+		int		width;									///< Width of the frame
+		int		height;									///< Height of the frame
+
+		//Valid range (FrameHumans)
+		float	distance_min;							///< Min distance from sensor [mm]
+		float	distance_max;							///< Max distance from sensor [mm]
+		float	z_min;									///< Min Z-coordinate [mm]
+		float	z_max;									///< Max Z-coordinate [mm] (Not included)
+
+		//Display
+		float	zoom;									///< Zoom ratio
+		float	dx;										///< Shift to X direction on display
+		float	dy;										///< Shift to Y direction on display
+		bool	bpoint;									///< Draw points on the top view
+		const RasterSplat* splat;						///< Shape of points on the top view (NULL: a pixel)
+
+		//Top view (BGR 8bit x 3)
+		unsigned char* img;								///< Top view image
+		size_t	imgstep;								///< Bytes per row of the top view image
+		int		imgcols;								///< Width of the top view image
+		int		imgrows;								///< Height of the top view image
+
+		//Z-buffer (same size as the top view image, cleared by ZBuffer::Clear())
+		ZBuffer* zbuffer;								///< Z-buffer (depth = color index of Z)
+
+		//Sub display (BGR 8bit x 3), NULL = not drawn
+		unsigned char* sub;								///< Sub display image
+		size_t	substep;								///< Bytes per row of the sub display
+		int		subcols;								///< Width of the sub display
+		int		subrows;								///< Height of the sub display
+	};
+
+	/**
+	* @brief
+	* 	Register a projected pixel to Z-buffer, top view and sub display
+	*
+	*	- Color index (0 to 65530) is used as depth. Points with the same index have the same color,
+	*	  so the top view is the same as the depth test of float Z.
+	*/
+	inline void TopViewPlot(const TopViewParam& p, int x, int y, unsigned short raw, int px, int py, int color)
+	{
+		if ((p.splat != NULL) && (p.splat->size > 1)){
+			//Drawn by ResolveTopView()
+			if (p.bpoint){
+				ZBuffer& zb = *p.zbuffer;
+				RasterSplatCells(&zb.cells[0], zb.width, zb.height, px, py, zb.stamp | (unsigned short)color, *p.splat);
+			}
+		}
+		else if (p.zbuffer->Test(px, py, (unsigned short)color)){
+			//Front than data already registered in Z-buffer
+			if (p.bpoint){
+				PutColor(p.img + py * p.imgstep + px * 3, (*p.colorlut)[(unsigned short)color]);
+			}
+		}
+		if (p.sub != NULL){
+			PutColor(p.sub + (y * p.subrows / p.height) * p.substep + (x * p.subcols / p.width) * 3, (*p.colorlut)[raw]);
+		}
+	}
+
+	/**
+	* @brief
+	* 	Project a pixel to the top view (scalar code)
+	*
+	*	- Length of depth data is calculated as FrameDepth::CalculateLength()
+	*	  (0x0000 = depth_min, 0xfffe = depth_max, 0xffff = invalid).
+	* @param	p		Parameters
+	* @param	x		X of the pixel
+	* @param	y		Y of the pixel
+	* @param	lscale	Length per a step of depth data
+	*/
+	inline void ProjectTopViewPixel(const TopViewParam& p, int x, int y, float lscale)
+	{
+		int i = y * p.width + x;
+		unsigned short raw = p.depth[i];
+		bool bvalid;
+		if (p.mask != NULL){
+			bvalid = GateBit(p.mask, i);
+		}
+		else {
+			float length = p.depth_min + raw * lscale;
+			bvalid = (raw != MAX_INT16) && (length >= p.distance_min) && (length <= p.distance_max);
+		}
+
+		if (!bvalid){
+			//Invalid point is (x,y,z) = (0,0,0)
+			p.points[i].x = 0;
+			p.points[i].y = 0;
+			p.points[i].z = 0;
+			return;
+		}
+
+		float fx = p.points[i].x * p.zoom + p.dx;
+		float fy = p.points[i].y * p.zoom + p.dy;
+		float z = p.points[i].z;
+		if ((fx >= 0) && (fx < p.imgcols) && (fy >= 0) && (fy < p.imgrows) &&
+			(z >= p.z_min) && (z < p.z_max)){
+			TopViewPlot(p, x, y, raw, (int)fx, (int)fy, (int)(65530.0f * (z - p.z_min) / (p.z_max - p.z_min)));
+		}
+	}
+
+	/**
+	* @brief
+	* 	Project a 3D frame to the top view (scalar code)
+	*
+	*	- Same result as the per-pixel loop of HumanCounter.cpp.
+	* @param	p		Parameters
+	* @param	ystart	First row to process
+	* @param	yend	Last row to process + 1
+	*/
+	inline void ProjectTopViewScalar(const TopViewParam& p, int ystart, int yend)
+	{
+		const float lscale = (p.depth_max - p.depth_min) / (float)(MAX_INT16 - 1);
+
+		for (int y = ystart; y < yend; y++){
+			for (int x = 0; x < p.width; x++){
+				ProjectTopViewPixel(p, x, y, lscale);
+			}
+		}
+	}
+
+	/**
+	* @brief
+	* 	Register the result of a block of pixels calculated at once
+	* @param	p		Parameters
+	* @param	x		X of the first pixel in the block
+	* @param	y		Row of the block
+	* @param	lanes	Number of pixels in the block
+	* @param	valid	Bit mask of pixels which passed the distance gate
+	* @param	draw	Bit mask of pixels which are in the top view and in the Z range
+	* @param	px		X on the top view of each pixel
+	* @param	py		Y on the top view of each pixel
+	* @param	color	Color index of each pixel
+	*/
+	inline void TopViewPlotBlock(const TopViewParam& p, int x, int y, int lanes, unsigned int valid, unsigned int draw,
+		const int* px, const int* py, const int* color)
+	{
+		int i = y * p.width + x;
+
+		//Invalid point is (x,y,z) = (0,0,0)
+		unsigned int invalid = ~valid & ((1u << lanes) - 1);
+		while (invalid != 0){
+			int lane = TofBitScan(invalid);
+			invalid &= invalid - 1;
+			p.points[i + lane].x = 0;
+			p.points[i + lane].y = 0;
+			p.points[i + lane].z = 0;
+		}
+
+		draw &= valid;
+		while (draw != 0){
+			int lane = TofBitScan(draw);
+			draw &= draw - 1;
+			TopViewPlot(p, x + lane, y, p.depth[i + lane], px[lane], py[lane], color[lane]);
+		}
+	}
+
+#ifdef TOF_SIMD_SSE4
+	/**
+	* @brief
+	* 	Constants of a projection broadcast to SSE registers
+	*/
+	struct TopViewConst4 {
+		__m128	depth_min;
+		__m128	lscale;
+		__m128	distance_min;
+		__m128	distance_max;
+		__m128	zoom;
+		__m128	dx;
+		__m128	dy;
+		__m128	cols;
+		__m128	rows;
+		__m128	z_min;
+		__m128	z_max;
+		__m128	cmax;
+		__m128	crange;
+
+		TopViewConst4(const TopViewParam& p){
+			depth_min = _mm_set1_ps(p.depth_min);
+			lscale = _mm_set1_ps((p.depth_max - p.depth_min) / (float)(MAX_INT16 - 1));
+			distance_min = _mm_set1_ps(p.distance_min);
+			distance_max = _mm_set1_ps(p.distance_max);
+			zoom = _mm_set1_ps(p.zoom);
+			dx = _mm_set1_ps(p.dx);
+			dy = _mm_set1_ps(p.dy);
+			cols = _mm_set1_ps((float)p.imgcols);
+			rows = _mm_set1_ps((float)p.imgrows);
+			z_min = _mm_set1_ps(p.z_min);
+			z_max = _mm_set1_ps(p.z_max);
+			cmax = _mm_set1_ps(65530.0f);
+			crange = _mm_set1_ps(p.z_max - p.z_min);
+		}
+	};
+
+	/**
+	* @brief
+	* 	Project 4 pixels from x of row y (SSE4.1)
+	*/
+	inline void ProjectTopView4(const TopViewParam& p, const TopViewConst4& k, int x, int y)
+	{
+		int i = y * p.width + x;
+
+		//Distance gate
+		unsigned int validmask;
+		if (p.mask != NULL){
+			validmask = GateBits(p.mask, i, 4);
+		}
+		else {
+			__m128i raw = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)(p.depth + i)));
+			__m128 length = _mm_add_ps(k.depth_min, _mm_mul_ps(_mm_cvtepi32_ps(raw), k.lscale));
+			__m128 valid = _mm_and_ps(_mm_cmpge_ps(length, k.distance_min), _mm_cmple_ps(length, k.distance_max));
+			valid = _mm_andnot_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(raw, _mm_set1_epi32(MAX_INT16))), valid);
+			validmask = (unsigned int)_mm_movemask_ps(valid);
+		}
+
+		//Zoom, shift and range
+		__m128 fx, fy, z;
+		TofLoadPoints4(&p.points[i].x, fx, fy, z);
+		fx = _mm_add_ps(_mm_mul_ps(fx, k.zoom), k.dx);
+		fy = _mm_add_ps(_mm_mul_ps(fy, k.zoom), k.dy);
+		__m128 zero = _mm_setzero_ps();
+		__m128 draw = _mm_and_ps(_mm_cmpge_ps(fx, zero), _mm_cmplt_ps(fx, k.cols));
+		draw = _mm_and_ps(draw, _mm_and_ps(_mm_cmpge_ps(fy, zero), _mm_cmplt_ps(fy, k.rows)));
+		draw = _mm_and_ps(draw, _mm_and_ps(_mm_cmpge_ps(z, k.z_min), _mm_cmplt_ps(z, k.z_max)));
+
+		unsigned int drawmask = (unsigned int)_mm_movemask_ps(draw);
+		if ((validmask == 0xF) && ((drawmask & validmask) == 0)){
+			//Nothing to register
+			return;
+		}
+
+		int px[4], py[4], color[4];
+		_mm_storeu_si128((__m128i*)px, _mm_cvttps_epi32(fx));
+		_mm_storeu_si128((__m128i*)py, _mm_cvttps_epi32(fy));
+		_mm_storeu_si128((__m128i*)color, _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(k.cmax, _mm_sub_ps(z, k.z_min)), k.crange)));
+
+		TopViewPlotBlock(p, x, y, 4, validmask, drawmask, px, py, color);
+	}
+#endif //TOF_SIMD_SSE4
+
+#ifdef TOF_SIMD_AVX2
+	/**
+	* @brief
+	* 	Constants of a projection broadcast to AVX registers
+	*/
+	struct TopViewConst8 {
+		__m256	depth_min;
+		__m256	lscale;
+		__m256	distance_min;
+		__m256	distance_max;
+		__m256	zoom;
+		__m256	dx;
+		__m256	dy;
+		__m256	cols;
+		__m256	rows;
+		__m256	z_min;
+		__m256	z_max;
+		__m256	cmax;
+		__m256	crange;
+
+		TopViewConst8(const TopViewParam& p){
+			depth_min = _mm256_set1_ps(p.depth_min);
+			lscale = _mm256_set1_ps((p.depth_max - p.depth_min) / (float)(MAX_INT16 - 1));
+			distance_min = _mm256_set1_ps(p.distance_min);
+			distance_max = _mm256_set1_ps(p.distance_max);
+			zoom = _mm256_set1_ps(p.zoom);
+			dx = _mm256_set1_ps(p.dx);
+			dy = _mm256_set1_ps(p.dy);
+			cols = _mm256_set1_ps((float)p.imgcols);
+			rows = _mm256_set1_ps((float)p.imgrows);
+			z_min = _mm256_set1_ps(p.z_min);
+			z_max = _mm256_set1_ps(p.z_max);
+			cmax = _mm256_set1_ps(65530.0f);
+			crange = _mm256_set1_ps(p.z_max - p.z_min);
+		}
+	};
+
+	/**
+	* @brief
+	* 	Project 8 pixels from x of row y (AVX2)
+	*/
+	inline void ProjectTopView8(const TopViewParam& p, const TopViewConst8& k, int x, int y)
+	{
+		int i = y * p.width + x;
+
+		//Distance gate
+		unsigned int validmask;
+		if (p.mask != NULL){
+			validmask = GateBits(p.mask, i, 8);
+		}
+		else {
+			__m256i raw = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(p.depth + i)));
+			__m256 length = _mm256_add_ps(k.depth_min, _mm256_mul_ps(_mm256_cvtepi32_ps(raw), k.lscale));
+			__m256 valid = _mm256_and_ps(_mm256_cmp_ps(length, k.distance_min, _CMP_GE_OQ), _mm256_cmp_ps(length, k.distance_max, _CMP_LE_OQ));
+			valid = _mm256_andnot_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(raw, _mm256_set1_epi32(MAX_INT16))), valid);
+			validmask = (unsigned int)_mm256_movemask_ps(valid);
+		}
+
+		//Zoom, shift and range
+		__m128 x0, y0, z0, x1, y1, z1;
+		TofLoadPoints4(&p.points[i].x, x0, y0, z0);
+		TofLoadPoints4(&p.points[i + 4].x, x1, y1, z1);
+		__m256 fx = _mm256_insertf128_ps(_mm256_castps128_ps256(x0), x1, 1);
+		__m256 fy = _mm256_insertf128_ps(_mm256_castps128_ps256(y0), y1, 1);
+		__m256 z = _mm256_insertf128_ps(_mm256_castps128_ps256(z0), z1, 1);
+		fx = _mm256_add_ps(_mm256_mul_ps(fx, k.zoom), k.dx);
+		fy = _mm256_add_ps(_mm256_mul_ps(fy, k.zoom), k.dy);
+		__m256 zero = _mm256_setzero_ps();
+		__m256 draw = _mm256_and_ps(_mm256_cmp_ps(fx, zero, _CMP_GE_OQ), _mm256_cmp_ps(fx, k.cols, _CMP_LT_OQ));
+		draw = _mm256_and_ps(draw, _mm256_and_ps(_mm256_cmp_ps(fy, zero, _CMP_GE_OQ), _mm256_cmp_ps(fy, k.rows, _CMP_LT_OQ)));
+		draw = _mm256_and_ps(draw, _mm256_and_ps(_mm256_cmp_ps(z, k.z_min, _CMP_GE_OQ), _mm256_cmp_ps(z, k.z_max, _CMP_LT_OQ)));
+
+		unsigned int drawmask = (unsigned int)_mm256_movemask_ps(draw);
+		if ((validmask == 0xFF) && ((drawmask & validmask) == 0)){
+			//Nothing to register
+			return;
+		}
+
+		int px[8], py[8], color[8];
+		_mm256_storeu_si256((__m256i*)px, _mm256_cvttps_epi32(fx));
+		_mm256_storeu_si256((__m256i*)py, _mm256_cvttps_epi32(fy));
+		_mm256_storeu_si256((__m256i*)color, _mm256_cvttps_epi32(_mm256_div_ps(_mm256_mul_ps(k.cmax, _mm256_sub_ps(z, k.z_min)), k.crange)));
+
+		TopViewPlotBlock(p, x, y, 8, validmask, drawmask, px, py, color);
+	}
+#endif //TOF_SIMD_AVX2
+
+	/**
+	* @brief
+	* 	Project a 3D frame to the top view
+	*
+	*	- Replace the per-pixel loop of HumanCounter.cpp.
+	*	- Pixels which are not a multiple of the vector width at the end of a row are
+	*	  processed by the scalar code.
+	*	- Points of splats are drawn by ResolveTopView() after all rows.
+	* @param	p		Parameters
+	* @param	ystart	First row to process
+	* @param	yend	Last row to process + 1
+	*/
+	inline void ProjectTopView(const TopViewParam& p, int ystart, int yend)
+	{
+		const float lscale = (p.depth_max - p.depth_min) / (float)(MAX_INT16 - 1);
+#if defined(TOF_SIMD_AVX2)
+		const TopViewConst8 k(p);
+		const int lanes = 8;
+		int vwidth = p.width - p.width % lanes;
+#elif defined(TOF_SIMD_SSE4)
+		const TopViewConst4 k(p);
+		const int lanes = 4;
+		int vwidth = p.width - p.width % lanes;
+#else
+		int vwidth = 0;
+#endif
+
+		for (int y = ystart; y < yend; y++){
+#if defined(TOF_SIMD_AVX2)
+			for (int x = 0; x < vwidth; x += lanes){
+				ProjectTopView8(p, k, x, y);
+			}
+#elif defined(TOF_SIMD_SSE4)
+			for (int x = 0; x < vwidth; x += lanes){
+				ProjectTopView4(p, k, x, y);
+			}
+#endif
+			for (int x = vwidth; x < p.width; x++){
+				//Rest of the row
+				ProjectTopViewPixel(p, x, y, lscale);
+			}
+		}
+	}
+
+	/**
+	* @brief
+	* 	Draw points of splats from the Z-buffer (after all rows are projected)
+	*
+	*	- Nothing is done if points are a pixel (already drawn by ProjectTopView()).
+	*/
+	inline void ResolveTopView(const TopViewParam& p)
+	{
+		if ((p.splat == NULL) || (p.splat->size == 1) || !p.bpoint){
+			return;
+		}
+		const ZBuffer& zb = *p.zbuffer;
+		for (int y = 0; y < p.imgrows; y++){
+			const unsigned int* cell = &zb.cells[y * zb.width];
+			unsigned char* d = p.img + y * p.imgstep;
+			for (int x = 0; x < p.imgcols; x++){
+				if ((cell[x] & 0xffff0000) == zb.stamp){
+					PutColor(d + x * 3, (*p.colorlut)[(unsigned short)cell[x]]);
+				}
+			}
+		}
+	}
+
+	/**
+	* @brief
+	* 	Project a whole 3D frame to the top view
+	*/
+	inline void ProjectTopView(const TopViewParam& p)
+	{
+		ProjectTopView(p, 0, p.height);
+		ResolveTopView(p);
+	}
+
+}
+
+#endif //_hlds_projection_H
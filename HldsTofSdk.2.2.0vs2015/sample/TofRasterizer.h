@@ -0,0 +1,330 @@
+/**
+* @file			TofRasterizer.h
+* @brief		Depth-buffer rasterizer of point clouds with square/disk splats
+* @date			2026.10.16
+* @version		v1.0.0
+*
+* @par Change History:
+* - 2026.10.16 New
+*
+* @remarks
+*	- A cell is a 32 bit key, smaller is front. The depth test is only "key < cell" (integer minimum),
+*	  so a span of a splat is tested by _mm_min_epu32 (4 or 8 cells at once), and threads sharing
+*	  one raster can use RasterAtomicMin() (compare and swap) instead of a lock.
+*	- RasterKey() makes a key of 16 bit fixed-point depth (RasterDepth(), 65535 steps over the depth range,
+*	  negative depth is not wrapped) in the upper bits and 16 bit data (e.g. depth data of the sensor for color)
+*	  in the lower bits. Points of the same fixed-point depth are ordered by the data.
+*	  FloatKey() is a key of the float depth itself (no data) when 16 bits are not enough.
+*	- A splat is a square or a disk of 1 to RASTER_MAX_SPLAT pixels, made once into spans of rows
+*	  (RasterSplat), so a point is a few span minimums. A 2x2 splat is two 64 bit minimums.
+*	- Cells of ZBuffer (TofZBuffer.h) have the same order (stamp | depth), so RasterSplatCells() splats into them too.
+*	- No dependency on the SDK DLL, Windows or OpenCV.
+*/
+#ifndef _hlds_rasterizer_H
+#define _hlds_rasterizer_H
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "TofSimd.h"
+
+#define RASTER_EMPTY			(0xffffffff)	//Value of an empty cell
+#define RASTER_MAX_SPLAT		(8)				//Max size of a splat [pixels]
+#define RASTER_MAX_DEPTH		(0xffff)		//Max fixed-point depth of RasterDepth()
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Key of 16 bit fixed-point depth and 16 bit data
+	*/
+	inline unsigned int RasterKey(unsigned int depth, unsigned short data)
+	{
+		return (depth << 16) | data;
+	}
+
+	/**
+	* @brief
+	* 	16 bit fixed-point depth (0 to RASTER_MAX_DEPTH)
+	* @param	z		Depth (min to max of the range)
+	* @param	zmin	Min depth of the range
+	* @param	zscale	RASTER_MAX_DEPTH / (max - min) of the range
+	*/
+	inline unsigned int RasterDepth(float z, float zmin, float zscale)
+	{
+		float d = (z - zmin) * zscale;
+		if (d <= 0){
+			return 0;
+		}
+		if (d >= RASTER_MAX_DEPTH){
+			return RASTER_MAX_DEPTH;
+		}
+		return (unsigned int)d;
+	}
+
+	/**
+	* @brief
+	* 	Key of a float depth (same order as the float, not NaN)
+	*/
+	inline unsigned int FloatKey(float z)
+	{
+		unsigned int bits;
+		memcpy(&bits, &z, sizeof(bits));
+		return (bits & 0x80000000) ? ~bits : (bits | 0x80000000);
+	}
+
+	/**
+	* @brief
+	* 	Depth test of cells [0, num) with a key (one thread writes the cells)
+	*/
+	inline void RasterMin(unsigned int* cells, int num, unsigned int key)
+	{
+		int i = 0;
+#ifdef TOF_SIMD_AVX2
+		__m256i key8 = _mm256_set1_epi32((int)key);
+		for (; i + 8 <= num; i += 8){
+			__m256i c = _mm256_loadu_si256((const __m256i*)(cells + i));
+			_mm256_storeu_si256((__m256i*)(cells + i), _mm256_min_epu32(c, key8));
+		}
+#endif
+#ifdef TOF_SIMD_SSE4
+		__m128i key4 = _mm_set1_epi32((int)key);
+		for (; i + 4 <= num; i += 4){
+			__m128i c = _mm_loadu_si128((const __m128i*)(cells + i));
+			_mm_storeu_si128((__m128i*)(cells + i), _mm_min_epu32(c, key4));
+		}
+		if (i + 2 <= num){
+			__m128i c = _mm_loadl_epi64((const __m128i*)(cells + i));
+			_mm_storel_epi64((__m128i*)(cells + i), _mm_min_epu32(c, key4));
+			i += 2;
+		}
+#endif
+		for (; i < num; i++){
+			cells[i] = std::min(cells[i], key);
+		}
+	}
+
+	/**
+	* @brief
+	* 	Depth test of a cell shared by threads (compare and swap)
+	*/
+	inline void RasterAtomicMin(unsigned int* cell, unsigned int key)
+	{
+#ifdef _MSC_VER
+		long old = *(volatile long*)cell;
+		while (key < (unsigned int)old){
+			long prev = _InterlockedCompareExchange((volatile long*)cell, (long)key, old);
+			if (prev == old){
+				break;
+			}
+			old = prev;
+		}
+#else
+		unsigned int old = __atomic_load_n(cell, __ATOMIC_RELAXED);
+		while ((key < old) && !__atomic_compare_exchange_n(cell, &old, key, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)){
+			//old is updated by the failed exchange
+		}
+#endif
+	}
+
+	/**
+	* @brief
+	* 	Minimum of cells [0, num) of two rasters into dst (merge of rasters of threads)
+	*/
+	inline void RasterMinCells(unsigned int* dst, const unsigned int* src, int num)
+	{
+		int i = 0;
+#if defined(TOF_SIMD_AVX2)
+		for (; i + 8 <= num; i += 8){
+			__m256i a = _mm256_loadu_si256((const __m256i*)(dst + i));
+			__m256i b = _mm256_loadu_si256((const __m256i*)(src + i));
+			_mm256_storeu_si256((__m256i*)(dst + i), _mm256_min_epu32(a, b));
+		}
+#elif defined(TOF_SIMD_SSE4)
+		for (; i + 4 <= num; i += 4){
+			__m128i a = _mm_loadu_si128((const __m128i*)(dst + i));
+			__m128i b = _mm_loadu_si128((const __m128i*)(src + i));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_min_epu32(a, b));
+		}
+#endif
+		for (; i < num; i++){
+			dst[i] = std::min(dst[i], src[i]);
+		}
+	}
+
+	/**
+	* @brief
+	* 	Shape of a splat (spans of rows around a point)
+	*/
+	class RasterSplat {
+	public:
+		int		size;							///< Size [pixels] (1 to RASTER_MAX_SPLAT)
+		bool	bdisk;							///< Disk (false: square)
+		int		spans;							///< Number of spans
+		int		dy[RASTER_MAX_SPLAT];			///< Row of each span (from the point)
+		int		x0[RASTER_MAX_SPLAT];			///< First column of each span (from the point)
+		int		x1[RASTER_MAX_SPLAT];			///< Last column of each span (from the point)
+
+		/**
+		* @brief
+		* 	Constructor
+		*/
+		RasterSplat(int size = 1, bool bdisk = false){
+			Set(size, bdisk);
+		};
+
+		/**
+		* @brief
+		* 	Change shape
+		*
+		*	- The point is at the center (odd size) or at the upper left of the center (even size).
+		*	- A disk has cells whose center is within the circle of the size (3: cross, 5: 5x5 without corners).
+		*/
+		void Set(int size, bool bdisk){
+			size = std::max(1, std::min(size, RASTER_MAX_SPLAT));
+			this->size = size;
+			this->bdisk = bdisk;
+			spans = size;
+			int origin = (size - 1) / 2;
+			for (int r = 0; r < size; r++){
+				int first = 0;
+				int last = size - 1;
+				if (bdisk){
+					//(2x - (size - 1))^2 + (2y - (size - 1))^2 <= size * (size - 1)
+					int ry = 2 * r - (size - 1);
+					while ((2 * first - (size - 1)) * (2 * first - (size - 1)) + ry * ry > size * (size - 1)){
+						first++;
+						last--;
+					}
+				}
+				dy[r] = r - origin;
+				x0[r] = first - origin;
+				x1[r] = last - origin;
+			}
+		}
+	};
+
+	/**
+	* @brief
+	* 	Depth test of a splat (one thread writes the cells)
+	* @param	cells	Cells (row major)
+	* @param	width	Width
+	* @param	height	Height
+	* @param	x		X of the point (0 to width - 1)
+	* @param	y		Y of the point (0 to height - 1)
+	* @param	key		Key (smaller is front)
+	* @param	splat	Shape of splat (clipped at the edges)
+	*/
+	inline void RasterSplatCells(unsigned int* cells, int width, int height, int x, int y, unsigned int key, const RasterSplat& splat)
+	{
+		if (splat.size == 1){
+			//Without branch (front/behind is not predictable)
+			unsigned int& cell = cells[y * width + x];
+			cell = std::min(cell, key);
+			return;
+		}
+		for (int s = 0; s < splat.spans; s++){
+			int py = y + splat.dy[s];
+			int px0 = std::max(x + splat.x0[s], 0);
+			int px1 = std::min(x + splat.x1[s], width - 1);
+			if ((py >= 0) && (py < height) && (px0 <= px1)){
+				RasterMin(cells + py * width + px0, px1 - px0 + 1, key);
+			}
+		}
+	}
+
+	/**
+	* @brief
+	* 	Depth test of a splat (threads write the same cells)
+	*/
+	inline void RasterSplatCellsAtomic(unsigned int* cells, int width, int height, int x, int y, unsigned int key, const RasterSplat& splat)
+	{
+		for (int s = 0; s < splat.spans; s++){
+			int py = y + splat.dy[s];
+			int px0 = std::max(x + splat.x0[s], 0);
+			int px1 = std::min(x + splat.x1[s], width - 1);
+			if ((py >= 0) && (py < height)){
+				for (int px = px0; px <= px1; px++){
+					RasterAtomicMin(cells + py * width + px, key);
+				}
+			}
+		}
+	}
+
+	/**
+	* @brief
+	* 	Depth buffer of 32 bit keys
+	*/
+	class Raster {
+	public:
+		int		width;						///< Width
+		int		height;						///< Height
+		std::vector<unsigned int> cells;	///< Cells (row major, RASTER_EMPTY: no point)
+
+		/**
+		* @brief
+		* 	Constructor
+		*/
+		Raster(int w = 0, int h = 0){
+			Resize(w, h);
+		};
+
+		/**
+		* @brief
+		* 	Change size (All cells are cleared)
+		*/
+		void Resize(int w, int h){
+			width = w;
+			height = h;
+			cells.assign(w * h, RASTER_EMPTY);
+		}
+
+		/**
+		* @brief
+		* 	Clear all cells
+		*/
+		void Clear(void){
+			std::fill(cells.begin(), cells.end(), RASTER_EMPTY);
+		}
+
+		/**
+		* @brief
+		* 	Depth test of a splat
+		* @param	x		X of the point (0 to width - 1)
+		* @param	y		Y of the point (0 to height - 1)
+		* @param	key		Key (smaller is front)
+		* @param	splat	Shape of splat
+		*/
+		void Splat(int x, int y, unsigned int key, const RasterSplat& splat){
+			RasterSplatCells(&cells[0], width, height, x, y, key, splat);
+		}
+
+		/**
+		* @brief
+		* 	Depth test of a splat (threads may splat into this raster at the same time)
+		*/
+		void SplatAtomic(int x, int y, unsigned int key, const RasterSplat& splat){
+			RasterSplatCellsAtomic(&cells[0], width, height, x, y, key, splat);
+		}
+
+		/**
+		* @brief
+		* 	Merge rows [row0, row1) of a raster of the same size (front of both)
+		*/
+		void Merge(const Raster& other, int row0, int row1){
+			RasterMinCells(&cells[row0 * width], &other.cells[row0 * width], (row1 - row0) * width);
+		}
+
+		/**
+		* @brief
+		* 	Cell
+		*/
+		unsigned int operator()(int x, int y) const {
+			return cells[y * width + x];
+		}
+	};
+
+}
+
+#endif //_hlds_rasterizer_H
@@ -0,0 +1,536 @@
+/**
+* @file			TofRayTable.h
+* @brief		Depth to 3D conversion with a cached per-pixel ray table
+* @date			2026.10.16
+* @version		v1.2.0
+*
+* @par Change History:
+* - 2026.10.16 New
+* - 2026.10.16 v1.1.0
+*					- Add sensor pose (rotation in Z,Y,X order and position) folded into the rays
+* - 2026.10.16 v1.2.0
+*					- Use the table after RAYTABLE_LEARN_FRAMES frames even if some pixels never had valid data
+*
+* @remarks
+*	- Lens correction depends only on the pixel position, the resolution and LensParam.
+*	  The ray of each pixel is calculated once and a frame is converted as
+*	  point = length * ray (one multiply per coordinate).
+*	- The table is rebuilt automatically when the resolution, LensParam or distance range of the frame changes.
+*	- Rays are made by one of
+*		- Learn() : from the output of Frame3d::Convert() (same result as the SDK within float rounding,
+*		  less than 0.01mm up to 12m).
+*		- Build() : from LensParam with the 8 coefficients rational model (k1,k2,p1,p2,k3,k4,k5,k6).
+*		  This is an approximation of the lens correction in the SDK.
+*	- Convert(FrameDepth*, Frame3d*) learns from the SDK until every pixel is learned or for RAYTABLE_LEARN_FRAMES
+*	  frames. Pixels which never had valid data (edges, absorbing surfaces, out of range) keep the ray of LensParam,
+*	  and a frame is learned again (at most once in RAYTABLE_LEARN_FRAMES frames) when some of them have valid data.
+*	- SetPose() folds the rotation of Frame3d::RotateZYX() and the sensor position into the rays.
+*	  The rays are rotated only when the pose is changed, so a frame is converted in one pass without trigonometry.
+*	- A table can be saved and loaded, so that recorded FrameDepth buffers can be converted
+*	  without the SDK DLL (e.g. on Linux).
+*/
+#ifndef _hlds_raytable_H
+#define _hlds_raytable_H
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+#include "tof.h"
+
+#define RAYTABLE_LEARN_FRAMES	(30)			//Frames learned before the table is used with pixels not learned yet
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Key of a ray table (a table is valid while the key is the same)
+	*/
+	struct RayTableKey {
+		int		width;					///< Width of frame
+		int		height;					///< Height of frame
+		float	distance_min;			///< Length of 0x0000
+		float	distance_max;			///< Length of 0xfffe
+		LensParam lens;					///< Lens correction information
+
+		bool operator==(const RayTableKey& key) const {
+			return (width == key.width) && (height == key.height) &&
+				(distance_min == key.distance_min) && (distance_max == key.distance_max) &&
+				(lens.focallength == key.lens.focallength) && (lens.fov_x == key.lens.fov_x) &&
+				(lens.fov_y == key.lens.fov_y) && (lens.ellipticity == key.lens.ellipticity) &&
+				(memcmp(lens.distortion, key.lens.distortion, sizeof(lens.distortion)) == 0);
+		}
+		bool operator!=(const RayTableKey& key) const {
+			return !(*this == key);
+		}
+	};
+
+	/**
+	* @brief
+	* 	Ray of a pixel by the lens model
+	*
+	*	- Origin is the center of the sensor, x: right, y: down, z: front. The length of the ray is 1.
+	*	- Focal length in pixel is calculated from fov_x and fov_y (ellipticity is used if fov_y is 0).
+	*	- Distortion is removed by iteration (distortion[] = k1,k2,p1,p2,k3,k4,k5,k6).
+	*/
+	inline TofPoint LensRay(int x, int y, int width, int height, const LensParam& lens)
+	{
+		double cx = width / 2.0;
+		double cy = height / 2.0;
+		double fx = cx / tan(lens.fov_x / 2.0 / 180.0 * 3.14159265358979);
+		double fy = fx * ((lens.ellipticity != 0) ? lens.ellipticity : 1.0);
+		if (lens.fov_y > 0){
+			fy = cy / tan(lens.fov_y / 2.0 / 180.0 * 3.14159265358979);
+		}
+
+		//Distorted position
+		double xd = (x + 0.5 - cx) / fx;
+		double yd = (y + 0.5 - cy) / fy;
+
+		//Undistort
+		const double* k = lens.distortion;
+		double xu = xd;
+		double yu = yd;
+		for (int i = 0; i < 20; i++){
+			double r2 = xu * xu + yu * yu;
+			double num = 1 + ((k[4] * r2 + k[1]) * r2 + k[0]) * r2;
+			double den = 1 + ((k[7] * r2 + k[6]) * r2 + k[5]) * r2;
+			double radial = (num != 0) ? den / num : 1.0;
+			double tx = 2 * k[2] * xu * yu + k[3] * (r2 + 2 * xu * xu);
+			double ty = k[2] * (r2 + 2 * yu * yu) + 2 * k[3] * xu * yu;
+			xu = (xd - tx) * radial;
+			yu = (yd - ty) * radial;
+		}
+
+		double norm = sqrt(xu * xu + yu * yu + 1);
+		TofPoint ray;
+		ray.x = (float)(xu / norm);
+		ray.y = (float)(yu / norm);
+		ray.z = (float)(1 / norm);
+		return ray;
+	}
+
+	/**
+	* @brief
+	* 	Rotation matrix of Frame3d::RotateZYX()
+	*
+	*	- Rotation order is Z-axis, Y-axis and X-axis (p' = Rx * Ry * Rz * p).
+	*	- Rotate direction is clockwise toward the positive direction of each axis.
+	* @param	rx		X-axis rotate angle (degree)
+	* @param	ry		Y-axis rotate angle (degree)
+	* @param	rz		Z-axis rotate angle (degree)
+	* @param	m		Output matrix (row major)
+	*/
+	inline void RotationZYX(float rx, float ry, float rz, float m[3][3])
+	{
+		double ax = rx / 180.0 * 3.14159265358979;
+		double ay = ry / 180.0 * 3.14159265358979;
+		double az = rz / 180.0 * 3.14159265358979;
+		double sx = sin(ax), cx = cos(ax);
+		double sy = sin(ay), cy = cos(ay);
+		double sz = sin(az), cz = cos(az);
+
+		m[0][0] = (float)(cy * cz);
+		m[0][1] = (float)(-cy * sz);
+		m[0][2] = (float)(sy);
+		m[1][0] = (float)(sx * sy * cz + cx * sz);
+		m[1][1] = (float)(-sx * sy * sz + cx * cz);
+		m[1][2] = (float)(-sx * cy);
+		m[2][0] = (float)(-cx * sy * cz + sx * sz);
+		m[2][1] = (float)(cx * sy * sz + sx * cz);
+		m[2][2] = (float)(cx * cy);
+	}
+
+	/**
+	* @brief
+	* 	Rotate 3D points in Z,Y,X order (Same calculation as Frame3d::RotateZYX(), to check the results)
+	*/
+	inline void RotatePointsZYX(TofPoint* points, int num, float rx, float ry, float rz)
+	{
+		float m[3][3];
+		RotationZYX(rx, ry, rz, m);
+		for (int i = 0; i < num; i++){
+			TofPoint p = points[i];
+			points[i].x = m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z;
+			points[i].y = m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z;
+			points[i].z = m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z;
+		}
+	}
+
+	/**
+	* @brief
+	* 	Pose of TOF sensor (same arguments as Tof::SetAttribute())
+	*/
+	struct RayPose {
+		float	x;						///< x-coordinate of TOF sensor [mm]
+		float	y;						///< y-coordinate of TOF sensor [mm]
+		float	z;						///< z-coordinate of TOF sensor [mm]
+		float	rx;						///< X-axis rotation angle (degree)
+		float	ry;						///< Y-axis rotation angle (degree)
+		float	rz;						///< Z-axis rotation angle (degree)
+
+		bool operator==(const RayPose& pose) const {
+			return (x == pose.x) && (y == pose.y) && (z == pose.z) &&
+				(rx == pose.rx) && (ry == pose.ry) && (rz == pose.rz);
+		}
+		bool operator!=(const RayPose& pose) const {
+			return !(*this == pose);
+		}
+	};
+
+	/**
+	* @brief
+	* 	Cached per-pixel ray table
+	*/
+	class RayTable {
+	public:
+		RayTableKey key;				///< Frame information of the table
+		std::vector<TofPoint> rays;		///< Ray of each pixel (3D point of length 1mm)
+		std::vector<TofPoint> posed;	///< Ray of each pixel after rotation of the pose
+		RayPose	pose;					///< Pose of TOF sensor
+		bool	bposed;					///< true: posed is up to date
+		std::vector<unsigned char> learned;	///< 1: ray of the pixel is learned from Frame3d::Convert()
+		int		numoflearned;			///< Number of learned pixels
+		int		learnframes;			///< Frames learned since the table was made
+		int		skipframes;				///< Frames converted by the table since the last check of unlearned pixels
+
+		/**
+		* @brief
+		* 	Constructor
+		*/
+		RayTable(){
+			memset(&key, 0, sizeof(key));
+			memset(&pose, 0, sizeof(pose));
+			numoflearned = 0;
+			learnframes = 0;
+			skipframes = 0;
+			bposed = false;
+		};
+
+		/**
+		* @brief
+		* 	Key of a depth frame
+		*/
+		static RayTableKey KeyOf(const FrameDepth& frame){
+			RayTableKey k;
+			memset(&k, 0, sizeof(k));
+			k.width = frame.width;
+			k.height = frame.height;
+			k.distance_min = frame.distance_min;
+			k.distance_max = frame.distance_max;
+			k.lens = frame.lens;
+			return k;
+		}
+
+		/**
+		* @brief
+		* 	Check the table can be used for the frame
+		*/
+		bool IsValid(const FrameDepth& frame) const {
+			return (!rays.empty()) && (key == KeyOf(frame));
+		}
+
+		/**
+		* @brief
+		* 	Check all rays are learned from Frame3d::Convert()
+		*/
+		bool IsLearned(void) const {
+			return (!rays.empty()) && (numoflearned == key.width * key.height);
+		}
+
+		/**
+		* @brief
+		* 	Check the table is used by Convert(FrameDepth*, Frame3d*)
+		*	(all rays are learned, or RAYTABLE_LEARN_FRAMES frames are learned)
+		*/
+		bool IsReady(void) const {
+			return IsLearned() || ((!rays.empty()) && (learnframes >= RAYTABLE_LEARN_FRAMES));
+		}
+
+		/**
+		* @brief
+		* 	Make the table from LensParam
+		*
+		*	- Nothing is done if the table is already valid for the frame.
+		* @param	frame	Depth frame
+		* @return	true: table was rebuilt
+		*/
+		bool Build(const FrameDepth& frame){
+			if (IsValid(frame)){
+				return false;
+			}
+			key = KeyOf(frame);
+			rays.resize(key.width * key.height);
+			learned.assign(key.width * key.height, 0);
+			numoflearned = 0;
+			learnframes = 0;
+			skipframes = 0;
+			for (int y = 0; y < key.height; y++){
+				for (int x = 0; x < key.width; x++){
+					rays[y * key.width + x] = LensRay(x, y, key.width, key.height, key.lens);
+				}
+			}
+			bposed = false;
+			return true;
+		}
+
+		/**
+		* @brief
+		* 	Learn rays from the result of Frame3d::Convert()
+		*
+		*	- ray = point / length for each pixel with valid depth data.
+		*	- Pixels without valid data keep the ray made from LensParam,
+		*	  and are learned by following frames.
+		* @param	frame	Depth frame given to Frame3d::Convert()
+		* @param	points	Result of Frame3d::Convert() (Frame3d::frame3d)
+		* @return	Number of pixels which are not learned yet
+		*/
+		int Learn(const FrameDepth& frame, const TofPoint* points){
+			Build(frame);
+			learnframes++;
+			float lscale = (key.distance_max - key.distance_min) / (float)(MAX_INT16 - 1);
+			for (int i = 0; i < key.width * key.height; i++){
+				unsigned short raw = frame.databuf[i];
+				float length = key.distance_min + raw * lscale;
+				if (learned[i] || (raw == MAX_INT16) || (length <= 0)){
+					continue;
+				}
+				rays[i].x = points[i].x / length;
+				rays[i].y = points[i].y / length;
+				rays[i].z = points[i].z / length;
+				learned[i] = 1;
+				numoflearned++;
+				bposed = false;
+			}
+			return key.width * key.height - numoflearned;
+		}
+
+		/**
+		* @brief
+		* 	Check a frame should be converted by the SDK and learned
+		*
+		*	- true until all pixels are learned or RAYTABLE_LEARN_FRAMES frames are learned.
+		*	- After that, true once in RAYTABLE_LEARN_FRAMES frames if a pixel not learned yet has valid data.
+		* @param	frame	Depth frame
+		*/
+		bool NeedLearn(const FrameDepth& frame){
+			if (!IsValid(frame)){
+				return true;
+			}
+			if (IsLearned()){
+				return false;
+			}
+			if (learnframes < RAYTABLE_LEARN_FRAMES){
+				return true;
+			}
+
+			//Pixels without valid data so far are checked once in RAYTABLE_LEARN_FRAMES frames
+			if (++skipframes < RAYTABLE_LEARN_FRAMES){
+				return false;
+			}
+			skipframes = 0;
+			for (int i = 0; i < key.width * key.height; i++){
+				if (!learned[i] && (frame.databuf[i] != MAX_INT16)){
+					return true;
+				}
+			}
+			return false;
+		}
+
+		/**
+		* @brief
+		* 	Set pose of TOF sensor
+		*
+		*	- Converted points are rotated in Z,Y,X order (same as Frame3d::RotateZYX(rx, ry, rz)),
+		*	  then moved by (x, y, z).
+		*	- Rays are rotated at next Update() only if the pose is changed.
+		* @return	true: pose was changed
+		*/
+		bool SetPose(float x, float y, float z, float rx, float ry, float rz){
+			RayPose p = { x, y, z, rx, ry, rz };
+			if (p == pose){
+				return false;
+			}
+			pose = p;
+			bposed = false;
+			return true;
+		}
+
+		/**
+		* @brief
+		* 	Rotate rays by the pose if the table or the pose is changed
+		*/
+		void Update(void){
+			if (bposed){
+				return;
+			}
+			float m[3][3];
+			RotationZYX(pose.rx, pose.ry, pose.rz, m);
+			posed.resize(rays.size());
+			for (size_t i = 0; i < rays.size(); i++){
+				const TofPoint& r = rays[i];
+				posed[i].x = m[0][0] * r.x + m[0][1] * r.y + m[0][2] * r.z;
+				posed[i].y = m[1][0] * r.x + m[1][1] * r.y + m[1][2] * r.z;
+				posed[i].z = m[2][0] * r.x + m[2][1] * r.y + m[2][2] * r.z;
+			}
+			bposed = true;
+		}
+
+		/**
+		* @brief
+		* 	Convert depth data to 3D coordinate with the pose
+		*
+		*	- Update() must be called after the table or the pose is changed.
+		*	- Invalid data (0xffff) is converted to the position of the sensor (x, y, z of the pose).
+		* @param	depth	Depth data (width x height of the table)
+		* @param	points	Output 3D points (width x height of the table)
+		* @param	ystart	First row to convert
+		* @param	yend	Last row to convert + 1
+		*/
+		void Convert(const unsigned short* depth, TofPoint* points, int ystart, int yend) const {
+			const float lmin = key.distance_min;
+			const float lscale = (key.distance_max - key.distance_min) / (float)(MAX_INT16 - 1);
+			const float ox = pose.x;
+			const float oy = pose.y;
+			const float oz = pose.z;
+			const TofPoint* r = &posed[0];
+			for (int i = ystart * key.width; i < yend * key.width; i++){
+				unsigned short raw = depth[i];
+				float length = (raw == MAX_INT16) ? 0.0f : lmin + raw * lscale;
+				points[i].x = length * r[i].x + ox;
+				points[i].y = length * r[i].y + oy;
+				points[i].z = length * r[i].z + oz;
+			}
+		}
+
+		/**
+		* @brief
+		* 	Convert a depth frame to 3D coordinate (Replacement of Frame3d::Convert())
+		*
+		*	- The table is made from LensParam if it is not valid for the frame.
+		* @param	frame	Depth frame
+		* @param	points	Output 3D points (resized to pixels of the frame)
+		*/
+		void Convert(const FrameDepth& frame, std::vector<TofPoint>& points){
+			Build(frame);
+			Update();
+			points.resize(key.width * key.height);
+			Convert(&frame.databuf[0], &points[0], 0, key.height);
+		}
+
+		/**
+		* @brief
+		* 	Convert a depth frame to Frame3d
+		*
+		*	- Frame3d::Convert() and Frame3d::RotateZYX() of the SDK are used while NeedLearn() is true
+		*	  (until all rays are learned or for RAYTABLE_LEARN_FRAMES frames, and again after the resolution,
+		*	  LensParam or distance range is changed). Otherwise the cached table is used (one pass, no trigonometry).
+		* @param	frame		Depth frame
+		* @param	frame3d		Output 3D frame
+		* @return	#Result
+		*/
+		Result Convert(FrameDepth* frame, Frame3d* frame3d){
+			if (NeedLearn(*frame)){
+				Result ret = frame3d->Convert(frame);
+				if (ret == Result::OK){
+					Learn(*frame, &frame3d->frame3d[0]);
+					ret = frame3d->RotateZYX(pose.rx, pose.ry, pose.rz);
+					for (size_t i = 0; i < frame3d->frame3d.size(); i++){
+						frame3d->frame3d[i].x += pose.x;
+						frame3d->frame3d[i].y += pose.y;
+						frame3d->frame3d[i].z += pose.z;
+					}
+				}
+				return ret;
+			}
+			Update();
+			*static_cast<FrameData*>(frame3d) = *frame;
+			frame3d->width = frame->width;
+			frame3d->height = frame->height;
+			frame3d->pixel = frame->width * frame->height;
+			frame3d->frame3d.resize(frame3d->pixel);
+			Convert(&frame->databuf[0], &frame3d->frame3d[0], 0, frame->height);
+			return Result::OK;
+		}
+
+		/**
+		* @brief
+		* 	Check the table with Frame3d::Convert() and Frame3d::RotateZYX() of the SDK
+		*
+		*	- Pixels with invalid data are not checked.
+		* @param	frame		Depth frame
+		* @param	frame3d		Work frame (overwritten)
+		* @return	Maximum difference of coordinate [mm] (-1: error)
+		*/
+		float Verify(FrameDepth* frame, Frame3d* frame3d){
+			if ((frame3d->Convert(frame) != Result::OK) || (frame3d->RotateZYX(pose.rx, pose.ry, pose.rz) != Result::OK)){
+				return -1;
+			}
+			Build(*frame);
+			Update();
+			std::vector<TofPoint> points(key.width * key.height);
+			Convert(&frame->databuf[0], &points[0], 0, key.height);
+			float err = 0;
+			for (int i = 0; i < key.width * key.height; i++){
+				if (frame->databuf[i] == MAX_INT16){
+					continue;
+				}
+				err = std::max(err, (float)fabs(frame3d->frame3d[i].x + pose.x - points[i].x));
+				err = std::max(err, (float)fabs(frame3d->frame3d[i].y + pose.y - points[i].y));
+				err = std::max(err, (float)fabs(frame3d->frame3d[i].z + pose.z - points[i].z));
+			}
+			return err;
+		}
+
+		/**
+		* @brief
+		* 	Save the table to a file
+		* @return	true: success
+		*/
+		bool Save(const char* filename) const {
+			FILE* fp = fopen(filename, "wb");
+			if (fp == NULL){
+				return false;
+			}
+			bool ret = (fwrite(&key, sizeof(key), 1, fp) == 1) &&
+				(fwrite(&rays[0], sizeof(TofPoint), rays.size(), fp) == rays.size());
+			fclose(fp);
+			return ret;
+		}
+
+		/**
+		* @brief
+		* 	Load the table from a file (Loaded rays are treated as learned)
+		* @return	true: success
+		*/
+		bool Load(const char* filename){
+			bposed = false;
+			FILE* fp = fopen(filename, "rb");
+			if (fp == NULL){
+				return false;
+			}
+			RayTableKey k;
+			bool ret = (fread(&k, sizeof(k), 1, fp) == 1) &&
+				(k.width > 0) && (k.width <= IMAGE_MAX_WIDTH) && (k.height > 0) && (k.height <= IMAGE_MAX_HEIGHT);
+			if (ret){
+				std::vector<TofPoint> r(k.width * k.height);
+				ret = (fread(&r[0], sizeof(TofPoint), r.size(), fp) == r.size());
+				if (ret){
+					key = k;
+					rays.swap(r);
+					learned.assign(key.width * key.height, 1);
+					numoflearned = key.width * key.height;
+					learnframes = RAYTABLE_LEARN_FRAMES;
+					skipframes = 0;
+				}
+			}
+			fclose(fp);
+			return ret;
+		}
+	};
+
+}
+
+#endif //_hlds_raytable_H
@@ -0,0 +1,126 @@
+/**
+* @file			TofSimd.h
+* @brief		Instruction set selection for the per-pixel kernels of the TOF samples
+* @date			2026.10.16
+* @version		v1.0.1
+*
+* @par Change History:
+* - 2026.10.16 New
+* - 2026.10.16 v1.0.1
+*					- TOF_SIMD_SSE2 for kernels of SSE2 only (all x64 targets)
+*
+* @remarks
+*	- The instruction set is selected at compile time.
+*	  AVX2 is used when the compiler targets it (/arch:AVX2, -mavx2),
+*	  SSE4.1 when the compiler targets AVX or SSE4.1 (/arch:AVX, -msse4.1),
+*	  otherwise the scalar code is used.
+*	- TOF_SIMD_SSE2 is also defined for all x64 targets (and -msse2, /arch:SSE2). A few kernels that need
+*	  only SSE2 (e.g. AreaStates() of TofCountZone.h) use it, so they are not scalar with cl /O2 without /arch.
+*	- Define TOF_SIMD_SSE4 before including to force SSE4.1 on MSVC x64 without /arch.
+*	- Define TOF_NO_SIMD to force the scalar code (e.g. to compare results).
+*/
+#ifndef _hlds_simd_H
+#define _hlds_simd_H
+
+#ifdef TOF_NO_SIMD
+#	undef TOF_SIMD_AVX2
+#	undef TOF_SIMD_SSE4
+#	undef TOF_SIMD_SSE2
+#else
+#	if defined(__AVX2__) && !defined(TOF_SIMD_AVX2)
+#		define TOF_SIMD_AVX2
+#	endif
+#	if (defined(__AVX__) || defined(__SSE4_1__) || defined(TOF_SIMD_AVX2)) && !defined(TOF_SIMD_SSE4)
+#		define TOF_SIMD_SSE4
+#	endif
+#	if (defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2)) || defined(__SSE2__) || defined(TOF_SIMD_SSE4)) && !defined(TOF_SIMD_SSE2)
+#		define TOF_SIMD_SSE2
+#	endif
+#endif
+
+#if defined(TOF_SIMD_AVX2)
+#	include <immintrin.h>
+#elif defined(TOF_SIMD_SSE4)
+#	include <smmintrin.h>
+#elif defined(TOF_SIMD_SSE2)
+#	include <emmintrin.h>
+#endif
+
+#ifdef _MSC_VER
+#	include <intrin.h>
+#endif
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Index of the lowest set bit (mask must not be 0)
+	*/
+	inline int TofBitScan(unsigned int mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (int)index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+
+	/**
+	* @brief
+	* 	Number of set bits
+	*/
+	inline int TofPopCount(unsigned int mask)
+	{
+#ifdef _MSC_VER
+		//__popcnt needs POPCNT instruction, so count by bit operations
+		mask = mask - ((mask >> 1) & 0x55555555);
+		mask = (mask & 0x33333333) + ((mask >> 2) & 0x33333333);
+		return (int)((((mask + (mask >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+#else
+		return __builtin_popcount(mask);
+#endif
+	}
+
+	/**
+	* @brief
+	* 	Name of the instruction set selected at compile time
+	*/
+	inline const char* TofSimdName(void)
+	{
+#if defined(TOF_SIMD_AVX2)
+		return "AVX2";
+#elif defined(TOF_SIMD_SSE4)
+		return "SSE4.1";
+#else
+		return "Scalar";
+#endif
+	}
+
+#ifdef TOF_SIMD_SSE4
+	/**
+	* @brief
+	* 	Load 4 TofPoint (x,y,z interleaved) and split them into x, y and z vectors
+	*/
+	inline void TofLoadPoints4(const float* p, __m128& x, __m128& y, __m128& z)
+	{
+		__m128 a = _mm_loadu_ps(p);			// x0 y0 z0 x1
+		__m128 b = _mm_loadu_ps(p + 4);		// y1 z1 x2 y2
+		__m128 c = _mm_loadu_ps(p + 8);		// z2 x3 y3 z3
+
+		__m128 t = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2));	// x2 y1 x3 z2
+		x = _mm_shuffle_ps(a, t, _MM_SHUFFLE(2, 0, 3, 0));
+
+		__m128 ab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1));	// y0 y0 y1 y1
+		__m128 bc = _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 2, 0, 3));	// y2 y1 y3 z2
+		y = _mm_shuffle_ps(ab, bc, _MM_SHUFFLE(2, 0, 2, 0));
+
+		ab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2));			// z0 z0 z1 z1
+		z = _mm_shuffle_ps(ab, c, _MM_SHUFFLE(3, 0, 2, 0));
+	}
+#endif //TOF_SIMD_SSE4
+
+}
+
+#endif //_hlds_simd_H
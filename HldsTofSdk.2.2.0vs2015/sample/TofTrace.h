@@ -0,0 +1,364 @@
+/**
+* @file			TofTrace.h
+* @brief		Scoped tracing of each thread and output of Chrome trace (JSON)
+* @date			2026.10.16
+* @version		v1.0.1
+*
+* @par Change History:
+* - 2026.10.16 New
+* - 2026.10.16 v1.0.1
+*					- The event being written by Add() is not copied (was taken as valid)
+*
+* @remarks
+*	- Define TOF_TRACE before including this file to trace. Without TOF_TRACE, TOF_TRACE_SCOPE() and
+*	  TOF_TRACE_THREAD() are removed at compile time and nothing is recorded.
+*	- TOF_TRACE_SCOPE("name") records the begin and end time of the scope [nsec] into a ring of the thread
+*	  (thread_local, TRACE_RING_EVENTS events). Recording is 2 clock reads and 3 stores, no lock, no allocation
+*	  (the ring is allocated at the first scope of the thread). Old events are overwritten.
+*	- TraceSave() writes events of all threads in Chrome trace format (open by chrome://tracing or
+*	  https://ui.perfetto.dev). It may be called by any thread while other threads are recording.
+*	  Events overwritten while being copied are skipped.
+*	- TraceTrigger decides to save when a frame is slower than a threshold (not more often than an interval).
+*	- Names must be string literals (pointers are kept).
+*/
+#ifndef _hlds_trace_H
+#define _hlds_trace_H
+
+#include <stdio.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#define TRACE_RING_EVENTS		(8192)			//Events kept in each thread
+#define TRACE_MAX_THREADS		(16)			//Max number of traced threads
+#define TRACE_SLOW_MSEC			(100)			//Default threshold of slow frame [msec]
+#define TRACE_INTERVAL_MSEC		(10000)			//Min interval of saving by slow frames [msec]
+
+#ifdef TOF_TRACE
+#define TOF_TRACE_CONCAT2(a, b)		a##b
+#define TOF_TRACE_CONCAT(a, b)		TOF_TRACE_CONCAT2(a, b)
+#define TOF_TRACE_SCOPE(name)		hlds::TraceScope TOF_TRACE_CONCAT(tracescope, __LINE__)(name)	//Trace this scope
+#define TOF_TRACE_THREAD(name)		hlds::TraceThreadName(name)										//Name of this thread in trace
+#else
+#define TOF_TRACE_SCOPE(name)
+#define TOF_TRACE_THREAD(name)
+#endif
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Clock of trace [nsec] (steady clock)
+	*/
+	inline long long TraceClock(void)
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/**
+	* @brief
+	* 	Event of a scope
+	*/
+	struct TraceEvent {
+		const char* name;			///< Name of scope
+		long long begin;			///< Begin time [nsec]
+		long long end;				///< End time [nsec]
+	};
+
+	/**
+	* @brief
+	* 	Ring of events of a thread (one writer)
+	*/
+	class TraceRing {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		*/
+		TraceRing(int id) : slots(TRACE_RING_EVENTS){
+			this->id = id;
+			name = NULL;
+			count = 0;
+		};
+
+		/**
+		* @brief
+		* 	Record an event (owner thread only)
+		*/
+		void Add(const char* name, long long begin, long long end){
+			unsigned int n = count.load(std::memory_order_relaxed);
+			Slot& slot = slots[n % TRACE_RING_EVENTS];
+			slot.name.store(name, std::memory_order_relaxed);
+			slot.begin.store(begin, std::memory_order_relaxed);
+			slot.end.store(end, std::memory_order_relaxed);
+			count.store(n + 1, std::memory_order_release);
+		}
+
+		/**
+		* @brief
+		* 	Copy events (any thread)
+		* @param	out		Events are added
+		*/
+		void Copy(std::vector<TraceEvent>& out) const {
+			unsigned int last = count.load(std::memory_order_acquire);
+			unsigned int first = (last > TRACE_RING_EVENTS) ? last - TRACE_RING_EVENTS : 0;
+			size_t start = out.size();
+			for (unsigned int n = first; n != last; n++){
+				const Slot& slot = slots[n % TRACE_RING_EVENTS];
+				TraceEvent event;
+				event.name = slot.name.load(std::memory_order_relaxed);
+				event.begin = slot.begin.load(std::memory_order_relaxed);
+				event.end = slot.end.load(std::memory_order_relaxed);
+				out.push_back(event);
+			}
+
+			//Skip events overwritten while copying
+			//(the writer may be in Add() of event "now", whose slot is event now - TRACE_RING_EVENTS)
+			std::atomic_thread_fence(std::memory_order_acquire);
+			unsigned int now = count.load(std::memory_order_relaxed);
+			unsigned int valid = (now + 1 > TRACE_RING_EVENTS) ? now + 1 - TRACE_RING_EVENTS : 0;
+			if (valid > first){
+				size_t skip = std::min((size_t)(valid - first), out.size() - start);
+				out.erase(out.begin() + start, out.begin() + start + skip);
+			}
+		}
+
+		int		id;							///< Number of thread in trace
+		std::atomic<const char*> name;		///< Name of thread (NULL: no name)
+
+	private:
+		struct Slot {
+			std::atomic<const char*> name;
+			std::atomic<long long> begin;
+			std::atomic<long long> end;
+		};
+		std::vector<Slot> slots;
+		std::atomic<unsigned int> count;	//Events recorded
+
+		TraceRing(const TraceRing&);
+		TraceRing& operator=(const TraceRing&);
+	};
+
+	/**
+	* @brief
+	* 	Rings of all threads
+	*/
+	class TraceRegistry {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		*/
+		TraceRegistry(){
+			size = 0;
+		};
+
+		/**
+		* @brief
+		* 	Ring of this thread (NULL: too many threads)
+		*/
+		TraceRing* Ring(void){
+			static thread_local TraceRing* ring = NULL;
+			static thread_local bool bregistered = false;
+			if (!bregistered){
+				bregistered = true;
+				std::lock_guard<std::mutex> lock(registerlock);
+				int id = size.load(std::memory_order_relaxed);
+				if (id < TRACE_MAX_THREADS){
+					//Kept until the end of the program (events of ended threads are saved)
+					ring = new TraceRing(id + 1);
+					rings[id] = ring;
+					size.store(id + 1, std::memory_order_release);
+				}
+			}
+			return ring;
+		}
+
+		/**
+		* @brief
+		* 	Number of rings
+		*/
+		int Size(void) const {
+			return size.load(std::memory_order_acquire);
+		}
+
+		/**
+		* @brief
+		* 	Ring of a thread
+		*/
+		const TraceRing* operator[](int id) const {
+			return rings[id];
+		}
+
+	private:
+		TraceRing* rings[TRACE_MAX_THREADS];
+		std::atomic<int> size;
+		std::mutex registerlock;
+
+		TraceRegistry(const TraceRegistry&);
+		TraceRegistry& operator=(const TraceRegistry&);
+	};
+
+	/**
+	* @brief
+	* 	Registry of the program
+	*/
+	inline TraceRegistry& Tracer(void)
+	{
+		static TraceRegistry registry;
+		return registry;
+	}
+
+	/**
+	* @brief
+	* 	Name of this thread in trace (string literal)
+	*/
+	inline void TraceThreadName(const char* name)
+	{
+		TraceRing* ring = Tracer().Ring();
+		if (ring != NULL){
+			ring->name.store(name, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	* @brief
+	* 	Scope recorded into the ring of this thread (use TOF_TRACE_SCOPE())
+	*/
+	class TraceScope {
+	public:
+		TraceScope(const char* name){
+			this->name = name;
+			begin = TraceClock();
+		};
+		~TraceScope(){
+			TraceRing* ring = Tracer().Ring();
+			if (ring != NULL){
+				ring->Add(name, begin, TraceClock());
+			}
+		};
+
+	private:
+		const char* name;
+		long long begin;
+
+		TraceScope(const TraceScope&);
+		TraceScope& operator=(const TraceScope&);
+	};
+
+	/**
+	* @brief
+	* 	Save events of all threads as Chrome trace (any thread)
+	* @param	filename	File name (.json)
+	* @return	Number of events (-1: file error)
+	*/
+	inline int TraceSave(const char* filename)
+	{
+		TraceRegistry& registry = Tracer();
+		int num = registry.Size();
+		std::vector<TraceEvent> events;
+		std::vector<int> threads;
+		for (int tno = 0; tno < num; tno++){
+			registry[tno]->Copy(events);
+			threads.resize(events.size(), registry[tno]->id);
+		}
+
+		//Time from the first event [usec]
+		long long origin = 0;
+		for (size_t eno = 0; eno < events.size(); eno++){
+			if ((eno == 0) || (events[eno].begin < origin)){
+				origin = events[eno].begin;
+			}
+		}
+
+		FILE* fp = fopen(filename, "w");
+		if (fp == NULL){
+			return -1;
+		}
+		fprintf(fp, "{\"traceEvents\":[\n");
+		bool bfirst = true;
+		for (int tno = 0; tno < num; tno++){
+			const char* name = registry[tno]->name.load(std::memory_order_relaxed);
+			fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+				bfirst ? "" : ",\n", registry[tno]->id, (name != NULL) ? name : "thread");
+			bfirst = false;
+		}
+		for (size_t eno = 0; eno < events.size(); eno++){
+			const TraceEvent& event = events[eno];
+			fprintf(fp, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				bfirst ? "" : ",\n", event.name, threads[eno],
+				(event.begin - origin) / 1000.0, (event.end - event.begin) / 1000.0);
+			bfirst = false;
+		}
+		fprintf(fp, "\n],\"displayTimeUnit\":\"ms\"}\n");
+		bool bok = (ferror(fp) == 0);
+		fclose(fp);
+		return bok ? (int)events.size() : -1;
+	}
+
+	/**
+	* @brief
+	* 	Trigger of saving by slow frames
+	*/
+	class TraceTrigger {
+	public:
+		/**
+		* @brief
+		* 	Constructor
+		* @param	slowmsec		Threshold of frame time [msec] (0: never)
+		* @param	intervalmsec	Min interval of triggers [msec]
+		*/
+		TraceTrigger(int slowmsec = TRACE_SLOW_MSEC, int intervalmsec = TRACE_INTERVAL_MSEC){
+			Set(slowmsec, intervalmsec);
+			last = 0;
+			slowframes = 0;
+		};
+
+		/**
+		* @brief
+		* 	Change threshold
+		*/
+		void Set(int slowmsec, int intervalmsec = TRACE_INTERVAL_MSEC){
+			slow = (long long)slowmsec * 1000000;
+			interval = (long long)intervalmsec * 1000000;
+		}
+
+		/**
+		* @brief
+		* 	Check time of a frame (one thread)
+		* @param	nsec	Time of the frame [nsec]
+		* @return	true: save trace now
+		*/
+		bool Check(long long nsec){
+			if ((slow <= 0) || (nsec < slow)){
+				return false;
+			}
+			slowframes++;
+			long long now = TraceClock();
+			if ((last != 0) && (now - last < interval)){
+				return false;
+			}
+			last = now;
+			return true;
+		}
+
+		/**
+		* @brief
+		* 	Number of slow frames
+		*/
+		long long SlowFrames(void) const {
+			return slowframes;
+		}
+
+	private:
+		long long slow;					//Threshold [nsec]
+		long long interval;				//Min interval [nsec]
+		long long last;					//Time of the last trigger
+		long long slowframes;
+	};
+
+}
+
+#endif //_hlds_trace_H
@@ -0,0 +1,384 @@
+/**
+* @file			TofTripwire.h
+* @brief		Directed polyline tripwires (line crossing counters)
+* @date			2026.10.16
+* @version		v1.0.0
+*
+* @par Change History:
+* - 2026.10.16 New
+*
+* @remarks
+*	- A tripwire is a polyline with a name and a direction (first point to last point).
+*	  Crossing from the left side to the right side of the direction on the screen (y-axis down) is "in",
+*	  and crossing from the right side to the left side is "out".
+*	- Movement of a human in a frame (prex, prey -> x, y) is tested with all segments of all tripwires
+*	  at once by CrossSegments() (8 segments by AVX2, 4 segments by SSE4.1, see TofSimd.h) into
+*	  a packed mask. In and out are decided only for the crossed segments.
+*	- A point on a segment or a line is on the left side (half-open), so a movement passing through
+*	  a vertex of a polyline is counted only once.
+*	- A tripwire is counted once for a human in a frame (sum of the crossings of its segments).
+*/
+#ifndef _hlds_tripwire_H
+#define _hlds_tripwire_H
+
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "TofHumanStore.h"
+#include "TofSimd.h"
+
+#define TRIPWIRE_MAX_POINTS		(64)			//Max points of a tripwire read by ParseTripwire()
+
+namespace hlds{
+
+	/**
+	* @brief
+	* 	Count of a tripwire
+	*/
+	struct TripwireCount {
+		int		In;					///< Humans crossing from the left side to the right side
+		int		Out;				///< Humans crossing from the right side to the left side
+	};
+
+	/**
+	* @brief
+	* 	Crossing of a tripwire by a human (result of Tripwires::Count())
+	*/
+	struct TripwireCrossing {
+		int		index;				///< Index of the human in HumanStore
+		int		line;				///< Tripwire number
+		bool	bIn;				///< true: in, false: out
+	};
+
+	/**
+	* @brief
+	* 	Test a movement with a segment
+	* @return	1: crossed to the right side, -1: crossed to the left side, 0: not crossed
+	*/
+	inline int CrossSegment(float px, float py, float qx, float qy, float ax, float ay, float ex, float ey)
+	{
+		//Side of start and end of the movement to the segment (> 0: right side)
+		int s1 = (ex * (py - ay) - ey * (px - ax)) > 0;
+		int s2 = (ex * (qy - ay) - ey * (qx - ax)) > 0;
+		if (s1 == s2){
+			return 0;
+		}
+
+		//Side of start and end of the segment to the movement
+		float mx = qx - px;
+		float my = qy - py;
+		int s3 = (mx * (ay - py) - my * (ax - px)) > 0;
+		int s4 = (mx * (ay + ey - py) - my * (ax + ex - px)) > 0;
+
+		return (s3 ^ s4) * (s2 - s1);
+	}
+
+	/**
+	* @brief
+	* 	Test a movement with segments
+	* @param	px, py	Start of the movement
+	* @param	qx, qy	End of the movement
+	* @param	ax, ay	Start of each segment
+	* @param	ex, ey	End - start of each segment
+	* @param	num		Number of segments
+	* @param	out		Output mask ((num + 31) / 32 words, bit n of word n/32 = segment n is crossed)
+	* @return	Number of crossed segments
+	*/
+	inline int CrossSegments(float px, float py, float qx, float qy,
+		const float* ax, const float* ay, const float* ex, const float* ey, int num, unsigned int* out)
+	{
+		int count = 0;
+		int s = 0;
+		for (int w = 0; w < (num + 31) / 32; w++){
+			out[w] = 0;
+		}
+
+#if defined(TOF_SIMD_AVX2)
+		const __m256 vpx = _mm256_set1_ps(px);
+		const __m256 vpy = _mm256_set1_ps(py);
+		const __m256 vqx = _mm256_set1_ps(qx);
+		const __m256 vqy = _mm256_set1_ps(qy);
+		const __m256 vmx = _mm256_set1_ps(qx - px);
+		const __m256 vmy = _mm256_set1_ps(qy - py);
+		const __m256 zero = _mm256_setzero_ps();
+		for (; s + 8 <= num; s += 8){
+			__m256 vax = _mm256_loadu_ps(ax + s);
+			__m256 vay = _mm256_loadu_ps(ay + s);
+			__m256 vex = _mm256_loadu_ps(ex + s);
+			__m256 vey = _mm256_loadu_ps(ey + s);
+			__m256 d1 = _mm256_sub_ps(_mm256_mul_ps(vex, _mm256_sub_ps(vpy, vay)), _mm256_mul_ps(vey, _mm256_sub_ps(vpx, vax)));
+			__m256 d2 = _mm256_sub_ps(_mm256_mul_ps(vex, _mm256_sub_ps(vqy, vay)), _mm256_mul_ps(vey, _mm256_sub_ps(vqx, vax)));
+			__m256 d3 = _mm256_sub_ps(_mm256_mul_ps(vmx, _mm256_sub_ps(vay, vpy)), _mm256_mul_ps(vmy, _mm256_sub_ps(vax, vpx)));
+			__m256 d4 = _mm256_sub_ps(_mm256_mul_ps(vmx, _mm256_sub_ps(_mm256_add_ps(vay, vey), vpy)),
+				_mm256_mul_ps(vmy, _mm256_sub_ps(_mm256_add_ps(vax, vex), vpx)));
+			__m256 c12 = _mm256_xor_ps(_mm256_cmp_ps(d1, zero, _CMP_GT_OQ), _mm256_cmp_ps(d2, zero, _CMP_GT_OQ));
+			__m256 c34 = _mm256_xor_ps(_mm256_cmp_ps(d3, zero, _CMP_GT_OQ), _mm256_cmp_ps(d4, zero, _CMP_GT_OQ));
+			unsigned int bits = (unsigned int)_mm256_movemask_ps(_mm256_and_ps(c12, c34));
+			out[s / 32] |= bits << (s % 32);
+			count += TofPopCount(bits);
+		}
+#elif defined(TOF_SIMD_SSE4)
+		const __m128 vpx = _mm_set1_ps(px);
+		const __m128 vpy = _mm_set1_ps(py);
+		const __m128 vqx = _mm_set1_ps(qx);
+		const __m128 vqy = _mm_set1_ps(qy);
+		const __m128 vmx = _mm_set1_ps(qx - px);
+		const __m128 vmy = _mm_set1_ps(qy - py);
+		const __m128 zero = _mm_setzero_ps();
+		for (; s + 4 <= num; s += 4){
+			__m128 vax = _mm_loadu_ps(ax + s);
+			__m128 vay = _mm_loadu_ps(ay + s);
+			__m128 vex = _mm_loadu_ps(ex + s);
+			__m128 vey = _mm_loadu_ps(ey + s);
+			__m128 d1 = _mm_sub_ps(_mm_mul_ps(vex, _mm_sub_ps(vpy, vay)), _mm_mul_ps(vey, _mm_sub_ps(vpx, vax)));
+			__m128 d2 = _mm_sub_ps(_mm_mul_ps(vex, _mm_sub_ps(vqy, vay)), _mm_mul_ps(vey, _mm_sub_ps(vqx, vax)));
+			__m128 d3 = _mm_sub_ps(_mm_mul_ps(vmx, _mm_sub_ps(vay, vpy)), _mm_mul_ps(vmy, _mm_sub_ps(vax, vpx)));
+			__m128 d4 = _mm_sub_ps(_mm_mul_ps(vmx, _mm_sub_ps(_mm_add_ps(vay, vey), vpy)),
+				_mm_mul_ps(vmy, _mm_sub_ps(_mm_add_ps(vax, vex), vpx)));
+			__m128 c12 = _mm_xor_ps(_mm_cmpgt_ps(d1, zero), _mm_cmpgt_ps(d2, zero));
+			__m128 c34 = _mm_xor_ps(_mm_cmpgt_ps(d3, zero), _mm_cmpgt_ps(d4, zero));
+			unsigned int bits = (unsigned int)_mm_movemask_ps(_mm_and_ps(c12, c34));
+			out[s / 32] |= bits << (s % 32);
+			count += TofPopCount(bits);
+		}
+#endif
+		//Rest of the segments
+		for (; s < num; s++){
+			if (CrossSegment(px, py, qx, qy, ax[s], ay[s], ex[s], ey[s]) != 0){
+				out[s / 32] |= 1u << (s % 32);
+				count++;
+			}
+		}
+		return count;
+	}
+
+	/**
+	* @brief
+	* 	Directed polyline tripwires
+	*/
+	class Tripwires {
+	public:
+		std::vector<TripwireCount> counts;			///< Count of each tripwire
+		std::vector<TripwireCrossing> crossings;	///< Crossings by the last Count()
+
+		/**
+		* @brief
+		* 	Add a tripwire
+		* @param	name	Name
+		* @param	x, y	Points (first point to last point)
+		* @param	num		Number of points (2 or more)
+		* @return	Tripwire number (0 to Size() - 1, -1: error)
+		*/
+		int Add(const std::string& name, const float* x, const float* y, int num){
+			if (num < 2){
+				return -1;
+			}
+			int line = (int)names.size();
+			names.push_back(name);
+			first.push_back((int)ax.size());
+			for (int n = 0; n + 1 < num; n++){
+				ax.push_back(x[n]);
+				ay.push_back(y[n]);
+				ex.push_back(x[n + 1] - x[n]);
+				ey.push_back(y[n + 1] - y[n]);
+				lineof.push_back(line);
+			}
+			TripwireCount count = {};
+			counts.push_back(count);
+			mask.resize((ax.size() + 31) / 32);
+			return line;
+		}
+
+		/**
+		* @brief
+		* 	Remove all tripwires
+		*/
+		void Clear(void){
+			names.clear();
+			first.clear();
+			ax.clear();
+			ay.clear();
+			ex.clear();
+			ey.clear();
+			lineof.clear();
+			counts.clear();
+			mask.clear();
+		}
+
+		/**
+		* @brief
+		* 	Number of tripwires
+		*/
+		int Size(void) const {
+			return (int)names.size();
+		}
+
+		const std::string& Name(int line) const {
+			return names[line];
+		}
+
+		/**
+		* @brief
+		* 	Number of points of a tripwire
+		*/
+		int Points(int line) const {
+			return Last(line) - first[line] + 1;
+		}
+
+		/**
+		* @brief
+		* 	Point of a tripwire
+		* @param	n	0 to Points() - 1
+		*/
+		void Point(int line, int n, float& x, float& y) const {
+			int s = first[line] + n;
+			if (s < Last(line)){
+				x = ax[s];
+				y = ay[s];
+			}
+			else {
+				x = ax[s - 1] + ex[s - 1];
+				y = ay[s - 1] + ey[s - 1];
+			}
+		}
+
+		/**
+		* @brief
+		* 	Reset counts of all tripwires
+		*/
+		void ResetCounts(void){
+			for (int line = 0; line < Size(); line++){
+				TripwireCount count = {};
+				counts[line] = count;
+			}
+		}
+
+		/**
+		* @brief
+		* 	Count humans of a frame crossing the tripwires
+		*
+		*	- Movement of a human is prex, prey -> x, y of HumanStore.
+		*	- Crossings are in crossings (cleared by each call).
+		*/
+		template <class T>
+		void Count(const HumanStore<T>& humans){
+			crossings.clear();
+			if (ax.empty()){
+				return;
+			}
+			for (int ahno = 0; ahno < humans.Size(); ahno++){
+				float px = humans.prex[ahno];
+				float py = humans.prey[ahno];
+				float qx = humans.x[ahno];
+				float qy = humans.y[ahno];
+				if ((px == qx) && (py == qy)){
+					//Not moved
+					continue;
+				}
+
+				//All segments of all tripwires at once
+				if (CrossSegments(px, py, qx, qy, &ax[0], &ay[0], &ex[0], &ey[0], (int)ax.size(), &mask[0]) == 0){
+					continue;
+				}
+
+				//Sum of crossed segments of each tripwire (segments of a tripwire are consecutive)
+				int line = -1;
+				int sum = 0;
+				for (int w = 0; w < (int)mask.size(); w++){
+					for (unsigned int bits = mask[w]; bits != 0; bits &= bits - 1){
+						int s = w * 32 + TofBitScan(bits);
+						if (lineof[s] != line){
+							AddCrossing(ahno, line, sum);
+							line = lineof[s];
+							sum = 0;
+						}
+						sum += CrossSegment(px, py, qx, qy, ax[s], ay[s], ex[s], ey[s]);
+					}
+				}
+				AddCrossing(ahno, line, sum);
+			}
+		}
+
+	private:
+		std::vector<std::string> names;
+		std::vector<int> first;					//First segment of each tripwire
+		std::vector<float> ax;					//Start of each segment
+		std::vector<float> ay;
+		std::vector<float> ex;					//End - start of each segment
+		std::vector<float> ey;
+		std::vector<int> lineof;				//Tripwire of each segment
+		std::vector<unsigned int> mask;			//Result of CrossSegments()
+
+		//End of segments of a tripwire
+		int Last(int line) const {
+			return (line + 1 < (int)first.size()) ? first[line + 1] : (int)ax.size();
+		}
+
+		//Count a tripwire crossed by a human (sum of crossed segments, 0: not counted)
+		void AddCrossing(int ahno, int line, int sum){
+			if ((line < 0) || (sum == 0)){
+				return;
+			}
+			TripwireCrossing crossing;
+			crossing.index = ahno;
+			crossing.line = line;
+			crossing.bIn = (sum > 0);
+			if (crossing.bIn){
+				counts[line].In++;
+			}
+			else {
+				counts[line].Out++;
+			}
+			crossings.push_back(crossing);
+		}
+	};
+
+	/**
+	* @brief
+	* 	Read a tripwire from a text "name,x1,y1,x2,y2[,x3,y3...]"
+	* @param	text	Text
+	* @param	name	[out] Name
+	* @param	x, y	[out] Points (TRIPWIRE_MAX_POINTS)
+	* @return	Number of points (0: error)
+	*/
+	inline int ParseTripwire(const char* text, std::string& name, float* x, float* y)
+	{
+		const char* p = text;
+		while (*p == ' '){
+			p++;
+		}
+		const char* comma = p;
+		while ((*comma != ',') && (*comma != 0)){
+			comma++;
+		}
+		if ((*comma == 0) || (comma == p)){
+			return 0;
+		}
+		name.assign(p, comma - p);
+
+		int num = 0;
+		p = comma;
+		while ((*p == ',') && (num < TRIPWIRE_MAX_POINTS)){
+			char* end;
+			x[num] = strtof(p + 1, &end);
+			if ((end == p + 1) || (*end != ',')){
+				return 0;
+			}
+			p = end;
+			y[num] = strtof(p + 1, &end);
+			if (end == p + 1){
+				return 0;
+			}
+			p = end;
+			num++;
+		}
+		if ((*p != 0) || (num < 2)){
+			return 0;
+		}
+		return num;
+	}
+
+}
+
+#endif //_hlds_tripwire_H
@@ -3,7 +3,7 @@
 * @brief		Sample program for Hitachi-LG Data Storage (HLDS)'s TOFv2 Motion Sensor
 * @author		Hitachi-LG Data Storage, Inc. (HLDS)
 * @date			2018.02.13
-* @version		v1.1.0
+* @version		v1.5.1
 * @copyright	Hitachi-LG Data Storage,Inc.
 *
 * @par Change History:
@@ -12,6 +12,16 @@
 *					- Add edge noise reduction
 * - 2018.02.13 v1.1.0
 *					- Add close window function
+* - 2026.10.16 v1.2.0
+*					- Show dropped frames and latency
+* - 2026.10.16 v1.3.0
+*					- Colorize by packed color table (one lookup per pixel)
+* - 2026.10.16 v1.4.0
+*					- Add color quality/speed setting (quantized color table)
+* - 2026.10.16 v1.5.0
+*					- Colorize at the resolution of the sensor and enlarge by cv::resize (nearest neighbour)
+* - 2026.10.16 v1.5.1
+*					- Remove color quality/speed setting (the quantized color table was not faster)
 */
 
 
@@ -23,6 +33,8 @@
 #include <Windows.h>
 
 #include "tof.h"
+#include "TofFrameTelemetry.h"
+#include "TofColorizer.h"
 
 #include <opencv2/opencv.hpp>
 //#include <opencv2/opencv_lib.hpp>
@@ -470,15 +482,28 @@ void main(void)
 	frame1.CreateColorTable(0, 0xfeff);
 	frame2.CreateColorTable(0, 0xfeff);
 
+	//Packed color tables (one lookup per pixel)
+	ColorLut colorlut1;
+	ColorLut colorlut2;
+	colorlut1.Build(frame1.ColorTable);
+	colorlut2.Build(frame2.ColorTable);
+
 	//Create windows for display as resizable
 	cv::namedWindow("Tofv2Viewer", CV_WINDOW_NORMAL);
 
-	//Sub Display
-	cv::Mat subdisplay(SUB_DISPLAY_HEIGHT, SUB_DISPLAY_WIDTH, CV_8UC3);
+	//Colorized frames at the resolution of the sensor (enlarged to Main/Sub Display)
+	cv::Mat native1;
+	cv::Mat native2;
 
 	//To caluculate FPS
 	clock_t frametime = clock();
 
+	//Dropped frames and latency from read to display (statistics are updated every 1 sec.)
+	FrameTelemetry telemetry;
+	FrameStamp stamp;
+	TelemetryStat telemetrystat = telemetry.Stat();
+	clock_t stattime = clock();
+
 	//Valid frame number(Only multiple number of this number is used)
 #ifdef FRAME_RATE_10FPS
 	int frameperiod = 3;
@@ -503,13 +528,7 @@ void main(void)
 			CheckSimulationStatus(frameno, &ptof, &tof);
 		}
 
-		long framediff;
-		if (frameno >= frame1.framenumber){
-			framediff = frameno - frame1.framenumber;
-		}
-		else {
-			framediff = frameno + 0x7fffffff - frame1.framenumber;
-		}
+		long framediff = FrameNumberDiff(frame1.framenumber, frameno);
 
 		if (framediff >= frameperiod){
 			//Read a new frame only if frame number is changed(Old data is shown if it is not changed.)
@@ -527,74 +546,36 @@ void main(void)
 				std::cout << "readframe error" << endl;
 				break;
 			}
+			telemetry.Read(frame1.framenumber, stamp, frameperiod);
 
-			//Initialize screen
-			img = cv::Mat::zeros(MAIN_DISPLAY_HEIGHT, MAIN_DISPLAY_WIDTH, CV_8UC3);
-
-			if (bSubDisplay){
-				//Initialize Sub Display
-				subdisplay = cv::Mat::zeros(SUB_DISPLAY_HEIGHT, SUB_DISPLAY_WIDTH, CV_8UC3);
-			}
-
-			for (int y = 0; y < MAIN_DISPLAY_HEIGHT; y++){
-				for (int x = 0; x < MAIN_DISPLAY_WIDTH; x++){
-
-					long datano = (y * frame1.height / MAIN_DISPLAY_HEIGHT) * frame1.width + x * frame1.width / MAIN_DISPLAY_WIDTH;
-
-					cv::Vec3b v_main;
-					cv::Vec3b v_sub;
-
-					cv::Vec3b v_depth1;
-					v_depth1.val[0] = frame1.ColorTable[0][frame1.databuf[datano]];
-					v_depth1.val[1] = frame1.ColorTable[1][frame1.databuf[datano]];
-					v_depth1.val[2] = frame1.ColorTable[2][frame1.databuf[datano]];
-
-					if (bDepthIr){
-						cv::Vec3b v_ir;
-						v_ir.val[0] = frameir.databuf[datano] / 256;
-						v_ir.val[1] = v_ir.val[0];
-						v_ir.val[2] = v_ir.val[0];
-
-						if (!bReverseMainSub){
-							v_main = v_depth1;
-							v_sub = v_ir;
-						}
-						else {
-							v_main = v_ir;
-							v_sub = v_depth1;
-						}
-
-					}
-					else {
-						cv::Vec3b v_depth2;
-						v_depth2.val[0] = frame2.ColorTable[0][frame2.databuf[datano]];
-						v_depth2.val[1] = frame2.ColorTable[1][frame2.databuf[datano]];
-						v_depth2.val[2] = frame2.ColorTable[2][frame2.databuf[datano]];
-
-						if (!bReverseMainSub){
-							v_main = v_depth1;
-							v_sub = v_depth2;
-						}
-						else {
-							v_main = v_depth2;
-							v_sub = v_depth1;
-						}
-					}
-
-					img.at<cv::Vec3b>(y, x) = v_main;
-
-					if (bSubDisplay){
-						//Sub Display
-						subdisplay.at<cv::Vec3b>(y * SUB_DISPLAY_HEIGHT / MAIN_DISPLAY_HEIGHT,
-							x * SUB_DISPLAY_WIDTH / MAIN_DISPLAY_WIDTH) = v_sub;
-					}
+			//Colorize at the resolution of the sensor
+			int pixels = frame1.width * frame1.height;
+			native1.create(frame1.height, frame1.width, CV_8UC3);
+			native2.create(frame1.height, frame1.width, CV_8UC3);
+			colorlut1.Colorize(&frame1.databuf[0], pixels, native1.data);
+			if (bDepthIr){
+				//IR (upper 8 bits) as gray
+				unsigned char* ir = native2.data;
+				for (int i = 0; i < pixels; i++){
+					unsigned char v = (unsigned char)(frameir.databuf[i] >> 8);
+					ir[i * 3] = v;
+					ir[i * 3 + 1] = v;
+					ir[i * 3 + 2] = v;
 				}
 			}
+			else {
+				colorlut2.Colorize(&frame2.databuf[0], pixels, native2.data);
+			}
+
+			//Enlarge to Main Display (nearest neighbour, all pixels are overwritten)
+			cv::Mat& nativemain = bReverseMainSub ? native2 : native1;
+			cv::Mat& nativesub = bReverseMainSub ? native1 : native2;
+			cv::resize(nativemain, img, img.size(), 0, 0, cv::INTER_NEAREST);
 
 			if (bSubDisplay){
 				//Sub Display
 				cv::Mat roi = img(cv::Rect(SubDisplayX[SubDisplayPos], SubDisplayY[SubDisplayPos], SUB_DISPLAY_WIDTH, SUB_DISPLAY_HEIGHT));
-				cv::resize(subdisplay, roi, roi.size(), cv::INTER_LINEAR);
+				cv::resize(nativesub, roi, roi.size(), 0, 0, cv::INTER_NEAREST);
 			}
 
 			//Information display
@@ -725,11 +706,23 @@ void main(void)
 			text = to_string(frame1.timestamp.year) + "/" + to_string(frame1.timestamp.month) + "/" + to_string(frame1.timestamp.day) + " "
 				+ to_string(frame1.timestamp.hour) + ":" + to_string(frame1.timestamp.minute) + ":" + to_string(frame1.timestamp.second) + "." + to_string(frame1.timestamp.msecond);
 			cv::putText(img, text, cv::Point(650, 950), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
+
+			//Show dropped frames and latency(p50/p99/p999)
+			if ((frametime - stattime) >= CLOCKS_PER_SEC){
+				telemetrystat = telemetry.Stat();
+				stattime = frametime;
+			}
+			char latency[64];
+			sprintf(latency, "%.1f/%.1f/%.1f", telemetrystat.output.p50 / 1000000.0,
+				telemetrystat.output.p99 / 1000000.0, telemetrystat.output.p999 / 1000000.0);
+			text = "drop " + to_string(telemetrystat.dropped) + "  " + latency + "ms";
+			cv::putText(img, text, cv::Point(650, 910), cv::FONT_HERSHEY_TRIPLEX, 1.0, color, 2, CV_AA);
 			if (NULL == cvGetWindowHandle("Tofv2Viewer")){
 				brun = false;
 			}
 			else{
 				cv::imshow("Tofv2Viewer", img);
+				telemetry.Output(stamp);
 			}
 		}
 
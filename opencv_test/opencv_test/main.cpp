@@ -3,7 +3,7 @@
 * @brief		Sample program for Hitachi-LG Data Storage (HLDS)'s TOF Motion Sensor
 * @author		Hitachi-LG Data Storage, Inc. (HLDS)
 * @date			2018.02.07
-* @version		v1.2.0
+* @version		v1.3.0
 * @copyright	Hitachi-LG Data Storage,Inc.
 *
 * @par Change History:
@@ -16,6 +16,8 @@
 *					- Add mouse point function
 * - 2018.02.07 v1.2.0
 *					- Add close window function
+* - 2026.10.16 v1.3.0
+*					- Colorize and mirror in one pass into a picture reused for each TOF sensor
 */
 
 #include <stdio.h>
@@ -24,6 +26,7 @@
 #include <Windows.h>
 
 #include "tof.h""
+#include "..\..\HldsTofSdk.2.2.0vs2015\sample\TofColorizer.h"
 
 #include "opencv2\opencv.hpp"
 //#include <opencv2/opencv.hpp>
@@ -162,12 +165,18 @@ void main(void)
 	FrameDepth * frame = new FrameDepth[numoftof];
 
 	// Set color information in each frame
+	// (Packed color table is the same for all TOF sensors)
+	ColorLut colorlut;
 	for (int tofno = 0; tofno < numoftof; tofno++) {
 		if (tofenable[tofno] == true) {
 			frame[tofno].CreateColorTable(0, 65530);
+			colorlut.Build(frame[tofno].ColorTable);
 		}
 	}
 
+	// Color picture of each TOF sensor (reused while the size is the same)
+	cv::Mat * subs = new cv::Mat[numoftof];
+
 	// For measure FPS
 	struct Timer {
 		float fps;
@@ -253,39 +262,25 @@ void main(void)
 						memcpy(&ts[tofno], &frame[tofno].timestamp, sizeof(TimeStamp));
 					}
 
-					// Create color picture
-					std::vector<unsigned char> buf;
-					buf.resize(frame[tofno].width * frame[tofno].height * COLOR_CH_NUM);
-
-					if (isFlip == false) {
-						// Reverse(Mirror) mode
-						for (int i = 0; i < frame[tofno].height; i++) {
-							for (int j = 0; j < frame[tofno].width; j++) {
-								for (int ch = 0; ch < COLOR_CH_NUM; ch++) {
-									buf[(i * frame[tofno].width + j)*COLOR_CH_NUM + ch] = frame[tofno].ColorTable[ch][frame[tofno].databuf[i * frame[tofno].width + (frame[tofno].width - j - 1)]];
-								}
-							}
-						}
-					}
-					else {
-						// Normal(Camera view) mode
-						for (int i = 0; i < frame[tofno].width * frame[tofno].height; i++) {
-							for (int ch = 0; ch < COLOR_CH_NUM; ch++) {
-								buf[i * COLOR_CH_NUM + ch] = frame[tofno].ColorTable[ch][frame[tofno].databuf[i]];
-							}
-						}
-					}
-
-					// Make OpenCV matrix (8bits 3 colors) from depth data
-					cv::Mat sub(frame[tofno].height, frame[tofno].width, CV_8UC3, &buf[0]);
-
 					// Set ROI to the position in multi display
 					int col = tofno % screen_col;
 					int row = tofno / screen_row;
 					cv::Mat roi = screen(cv::Rect(col * sub_width, row * sub_height, sub_width, sub_height));
 
-					// Copy and adjust size the matrix of depth data to ROI(display position)
-					cv::resize(sub, roi, roi.size(), cv::INTER_LINEAR);
+					// Create color picture (Reverse(Mirror) mode if isFlip is false, colorize and mirror in one pass)
+					if ((frame[tofno].width == sub_width) && (frame[tofno].height == sub_height)) {
+						// Directly into ROI(display position)
+						colorlut.ColorizeImage(&frame[tofno].databuf[0], frame[tofno].width, frame[tofno].height, !isFlip,
+							roi.data, roi.step, sub_width, sub_height);
+					}
+					else {
+						subs[tofno].create(frame[tofno].height, frame[tofno].width, CV_8UC3);
+						colorlut.ColorizeImage(&frame[tofno].databuf[0], frame[tofno].width, frame[tofno].height, !isFlip,
+							subs[tofno].data, subs[tofno].step, frame[tofno].width, frame[tofno].height);
+
+						// Copy and adjust size the matrix of depth data to ROI(display position)
+						cv::resize(subs[tofno], roi, roi.size(), cv::INTER_LINEAR);
+					}
 
 					string text;
 
@@ -515,6 +510,7 @@ void main(void)
 	}
 
 	delete[] timer;
+	delete[] subs;
 	delete[] frame;
 	delete[] tof;
 	delete[] tofenable;